@@ -0,0 +1,450 @@
+/** @file
+ * Implementacja zwięzłego binarnego archiwum rozegranych gier.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#include "archive.h"
+#include "parser.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Wersja formatu archiwum zapisywana tuż za znacznikiem początku pliku.
+ */
+#define ARCHIVE_VERSION 1
+
+/**
+ * Największa liczba bajtów liczby zapisanej w kodowaniu o zmiennej długości.
+ */
+#define MAX_VARINT_LEN 10
+
+/**
+ * Liczba zwykłych ruchów wykonywanych naraz przy odtwarzaniu gry.
+ */
+#define REPLAY_BATCH 256
+
+/**
+ * Początkowy rozmiar bufora na zakodowane ruchy jednej gry.
+ */
+#define GAME_BUFFER_SIZE 4096
+
+/** @brief Zakodowana gra, do której dopisywane są kolejne ruchy.
+ */
+typedef struct game_builder
+{
+    unsigned char *data; ///< Zakodowane wymiary planszy i ruchy.
+    size_t len; ///< Liczba bajtów w buforze.
+    size_t mem; ///< Rozmiar zaalokowanego bufora.
+    uint x; ///< Kolumna poprzedniego ruchu.
+    uint y; ///< Wiersz poprzedniego ruchu.
+    bool failed; ///< Czy zabrakło pamięci.
+} game_builder;
+
+/** @brief Koduje liczbę ze znakiem tak, by małe wartości bezwzględne
+ * miały małe kody.
+ * @param[in] n – kodowana liczba.
+ * @return Kod liczby: liczby nieujemne przechodzą na parzyste,
+ * a ujemne na nieparzyste.
+ */
+static inline muint zigzag(int64_t n)
+{
+    return ((muint) n << 1) ^ (muint) (n >> 63);
+}
+
+/** @brief Dekoduje liczbę zakodowaną przez @ref zigzag.
+ * @param[in] n – kod liczby.
+ * @return Zdekodowana liczba.
+ */
+static inline int64_t unzigzag(muint n)
+{
+    return (int64_t) (n >> 1) ^ -(int64_t) (n & 1);
+}
+
+/** @brief Odczytuje liczbę zapisaną w kodowaniu o zmiennej długości.
+ * Każdy bajt przechowuje siedem bitów liczby, od najmłodszych, a najstarszy
+ * bit oznacza, że liczba ma kolejne bajty.
+ * @param[in] data     – wskaźnik na zakodowane dane,
+ * @param[in] len      – liczba bajtów danych,
+ * @param[in,out] pos  – numer pierwszego bajtu liczby, po odczycie
+ *                       numer bajtu za liczbą,
+ * @param[out] value   – odczytana liczba.
+ * @return Wartość @p true, jeśli liczba mieści się w danych i w 64 bitach,
+ * a @p false w przeciwnym razie.
+ */
+static bool get_varint(const unsigned char *data, size_t len, size_t *pos,
+                       muint *value)
+{
+    muint result = 0;
+    for (uint shift = 0; shift < 64 && *pos < len; shift += 7)
+    {
+        unsigned char byte = data[(*pos)++];
+        result |= (muint) (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @brief Odczytuje liczbę z zakresu uint zapisaną w kodowaniu o zmiennej
+ * długości.
+ * @param[in] data     – wskaźnik na zakodowane dane,
+ * @param[in] len      – liczba bajtów danych,
+ * @param[in,out] pos  – numer pierwszego bajtu liczby, po odczycie
+ *                       numer bajtu za liczbą,
+ * @param[out] value   – odczytana liczba.
+ * @return Wartość @p true, jeśli odczytano liczbę z zakresu uint,
+ * a @p false w przeciwnym razie.
+ */
+static bool get_uint(const unsigned char *data, size_t len, size_t *pos,
+                     uint *value)
+{
+    muint n;
+    if (get_varint(data, len, pos, &n) == false || UINT32_MAX < n)
+        return false;
+    *value = n;
+    return true;
+}
+
+/** @brief Zapisuje liczbę w kodowaniu o zmiennej długości.
+ * @param[out] data – wskaźnik na miejsce na co najmniej
+ *                    @ref MAX_VARINT_LEN bajtów,
+ * @param[in] n     – zapisywana liczba.
+ * @return Liczba zapisanych bajtów.
+ */
+static size_t put_varint(unsigned char *data, muint n)
+{
+    size_t len = 0;
+    while (n >= 0x80)
+    {
+        data[len++] = (unsigned char) (n | 0x80);
+        n >>= 7;
+    }
+    data[len++] = (unsigned char) n;
+    return len;
+}
+
+/** @brief Dopisuje liczbę do zakodowanej gry.
+ * @param[in,out] game – wskaźnik na zakodowaną grę,
+ * @param[in] n        – dopisywana liczba.
+ */
+static void builder_put(game_builder *game, muint n)
+{
+    if (game->mem < game->len + MAX_VARINT_LEN)
+    {
+        size_t mem = 2 * game->mem + GAME_BUFFER_SIZE;
+        unsigned char *data = realloc(game->data, mem);
+        if (data == NULL)
+        {
+            game->failed = true;
+            return;
+        }
+        game->data = data;
+        game->mem = mem;
+    }
+    game->len += put_varint(game->data + game->len, n);
+}
+
+/** @brief Rozpoczyna kodowanie kolejnej gry.
+ * @param[in,out] game – wskaźnik na zakodowaną grę,
+ * @param[in] cmd      – polecenie @p B tworzące grę.
+ */
+static void builder_start(game_builder *game, const command *cmd)
+{
+    game->len = 0;
+    game->x = 0;
+    game->y = 0;
+    for (int i = 0; i < 4; ++i)
+        builder_put(game, cmd->args[i]);
+}
+
+/** @brief Dopisuje ruch do zakodowanej gry.
+ * @param[in,out] game – wskaźnik na zakodowaną grę,
+ * @param[in] cmd      – udane polecenie @p m lub @p g.
+ */
+static void builder_move(game_builder *game, const command *cmd)
+{
+    uint x = cmd->args[1], y = cmd->args[2];
+    builder_put(game, (muint) cmd->args[0] << 1 | (cmd->type == 'g'));
+    builder_put(game, zigzag((int64_t) x - game->x));
+    builder_put(game, zigzag((int64_t) y - game->y));
+    game->x = x;
+    game->y = y;
+}
+
+/** @brief Zapisuje zakodowaną grę do archiwum.
+ * Gra jest poprzedzona liczbą jej bajtów, dzięki czemu można ją pominąć
+ * bez dekodowania ruchów.
+ * @param[in] game    – wskaźnik na zakodowaną grę,
+ * @param[in,out] out – wskaźnik na strukturę zapisującą archiwum.
+ */
+static void builder_write(const game_builder *game, writer *out)
+{
+    unsigned char prefix[MAX_VARINT_LEN];
+    writer_put_bytes(out, prefix, put_varint(prefix, game->len));
+    writer_put_bytes(out, game->data, game->len);
+    writer_end(out);
+}
+
+/** @brief Ustawia kursor na pierwszym ruchu gry.
+ * @param[out] cursor – wskaźnik na kursor.
+ */
+void archive_cursor_init(archive_cursor *cursor)
+{
+    cursor->pos = 0;
+    cursor->x = 0;
+    cursor->y = 0;
+}
+
+/** @brief Sprawdza nagłówek archiwum i pomija go.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą archiwum.
+ * @return Wartość @p true, jeśli dane zaczynają się nagłówkiem archiwum
+ * w obsługiwanej wersji, a @p false w przeciwnym razie.
+ */
+bool archive_check_header(reader *input)
+{
+    const char *data;
+    if (reader_available(input, ARCHIVE_MAGIC_LEN + 1, &data) < ARCHIVE_MAGIC_LEN + 1
+        || memcmp(data, ARCHIVE_MAGIC, ARCHIVE_MAGIC_LEN) != 0
+        || data[ARCHIVE_MAGIC_LEN] != ARCHIVE_VERSION)
+        return false;
+
+    reader_consume(input, ARCHIVE_MAGIC_LEN + 1);
+    return true;
+}
+
+/** @brief Udostępnia kolejną grę z archiwum.
+ * Zakodowane ruchy gry są dostępne do kolejnego wywołania funkcji
+ * wczytujących z @p input.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą archiwum,
+ * @param[out] game     – wskaźnik na opis gry.
+ * @return Wartość @p 1, jeśli udostępniono kolejną grę, @p 0, jeśli
+ * archiwum się skończyło, a @p -1, jeśli archiwum jest uszkodzone.
+ */
+int archive_next_game(reader *input, archive_game *game)
+{
+    const char *chars;
+    size_t available = reader_available(input, MAX_VARINT_LEN, &chars);
+    if (available == 0)
+        return 0;
+
+    size_t pos = 0;
+    muint len;
+    if (get_varint((const unsigned char *) chars, available, &pos, &len) == false
+        || SIZE_MAX - pos < len)
+        return -1;
+
+    size_t total = pos + len;
+    if (reader_available(input, total, &chars) < total)
+        return -1;
+
+    const unsigned char *data = (const unsigned char *) chars;
+    if (get_uint(data, total, &pos, &game->width) == false
+        || get_uint(data, total, &pos, &game->height) == false
+        || get_uint(data, total, &pos, &game->players) == false
+        || get_uint(data, total, &pos, &game->areas) == false)
+        return -1;
+
+    game->moves = data + pos;
+    game->len = total - pos;
+    reader_consume(input, total);
+    return 1;
+}
+
+/** @brief Dekoduje kolejny ruch gry.
+ * @param[in] game          – wskaźnik na opis gry,
+ * @param[in,out] cursor    – wskaźnik na pozycję w ciągu ruchów,
+ * @param[out] m            – wskaźnik na odczytany ruch,
+ * @param[out] golden       – czy odczytany ruch jest złotym ruchem.
+ * @return Wartość @p 1, jeśli odczytano ruch, @p 0, jeśli ruchy gry się
+ * skończyły, a @p -1, jeśli zapis ruchu jest uszkodzony.
+ */
+int archive_next_move(const archive_game *game, archive_cursor *cursor,
+                      move *m, bool *golden)
+{
+    if (cursor->pos == game->len)
+        return 0;
+
+    muint tag, dx, dy;
+    if (get_varint(game->moves, game->len, &cursor->pos, &tag) == false
+        || get_varint(game->moves, game->len, &cursor->pos, &dx) == false
+        || get_varint(game->moves, game->len, &cursor->pos, &dy) == false)
+        return -1;
+
+    int64_t x = cursor->x + unzigzag(dx);
+    int64_t y = cursor->y + unzigzag(dy);
+    if ((tag >> 1) > UINT32_MAX || x < 0 || UINT32_MAX < x || y < 0 || UINT32_MAX < y)
+        return -1;
+
+    m->player = tag >> 1;
+    m->x = cursor->x = x;
+    m->y = cursor->y = y;
+    *golden = tag & 1;
+    return 1;
+}
+
+/** @brief Odtwarza grę z archiwum.
+ * Kolejne zwykłe ruchy są wykonywane grupami przez @ref gamma_move_batch.
+ * @param[in] game    – wskaźnik na opis gry,
+ * @param[out] moves  – liczba odtworzonych ruchów lub NULL,
+ * @param[out] golden – liczba odtworzonych złotych ruchów lub NULL.
+ * @return Wskaźnik na strukturę przechowującą stan gry po ostatnim ruchu
+ * lub NULL, jeśli zabrakło pamięci, gra jest uszkodzona lub któryś
+ * z zapisanych ruchów się nie powiódł.
+ */
+gamma_t *archive_replay(const archive_game *game, muint *moves, muint *golden)
+{
+    gamma_t *g = gamma_new(game->width, game->height, game->players, game->areas);
+    if (g == NULL)
+        return NULL;
+
+    move batch[REPLAY_BATCH];
+    size_t pending = 0;
+    muint total = 0, golden_total = 0;
+    archive_cursor cursor;
+    archive_cursor_init(&cursor);
+    bool is_golden, fine = true;
+    int next;
+
+    while (fine && (next = archive_next_move(game, &cursor, &batch[pending], &is_golden)) == 1)
+    {
+        total++;
+        if (is_golden)
+        {
+            // Zwykłe ruchy sprzed złotego ruchu muszą zostać wykonane przed nim.
+            fine = gamma_move_batch(g, batch, pending, NULL) == pending
+                && gamma_golden_move(g, batch[pending].player,
+                                     batch[pending].x, batch[pending].y);
+            golden_total++;
+            pending = 0;
+        }
+        else if (++pending == REPLAY_BATCH)
+        {
+            fine = gamma_move_batch(g, batch, pending, NULL) == pending;
+            pending = 0;
+        }
+    }
+
+    if (fine == false || next == -1
+        || gamma_move_batch(g, batch, pending, NULL) != pending)
+    {
+        gamma_delete(g);
+        return NULL;
+    }
+
+    if (moves != NULL)
+        *moves = total;
+    if (golden != NULL)
+        *golden = golden_total;
+    return g;
+}
+
+/** @brief Zapisuje do archiwum gry z zapisów tekstowych trybu wsadowego.
+ * Każde poprawne polecenie @p B rozpoczyna kolejną grę. Polecenia @p m
+ * i @p g są wykonywane, a do archiwum trafiają tylko udane ruchy. Pozostałe
+ * linie są pomijane.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą zapisy gier,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą archiwum.
+ * @return Wartość @p true, jeśli wszystkie gry zostały zapisane,
+ * a @p false, jeśli zabrakło pamięci.
+ */
+bool archive_session(reader *input, writer *out)
+{
+    game_builder builder = {NULL, 0, 0, 0, 0, false};
+    gamma_t *game = NULL;
+    const char *line;
+    size_t len;
+    command cmd;
+    int read;
+
+    writer_put_bytes(out, ARCHIVE_MAGIC, ARCHIVE_MAGIC_LEN);
+    writer_put_char(out, ARCHIVE_VERSION);
+    writer_end(out);
+
+    while ((read = reader_next_line(input, &line, &len)) == 1)
+    {
+        if (parse_line(line, len, &cmd) != 1)
+            continue;
+
+        if (cmd.type == 'B' && cmd.arguments == 4)
+        {
+            gamma_t *next = gamma_new(cmd.args[0], cmd.args[1],
+                                      cmd.args[2], cmd.args[3]);
+            if (next == NULL)
+                continue;
+            if (game != NULL)
+                builder_write(&builder, out);
+            gamma_delete(game);
+            game = next;
+            builder_start(&builder, &cmd);
+        }
+        else if (game != NULL && cmd.arguments == 3
+                 && ((cmd.type == 'm' && gamma_move(game, cmd.args[0], cmd.args[1], cmd.args[2]))
+                     || (cmd.type == 'g' && gamma_golden_move(game, cmd.args[0], cmd.args[1], cmd.args[2]))))
+        {
+            builder_move(&builder, &cmd);
+        }
+
+        if (builder.failed)
+            break;
+    }
+
+    if (game != NULL)
+        builder_write(&builder, out);
+    gamma_delete(game);
+    free(builder.data);
+    return read != -1 && builder.failed == false;
+}
+
+/** @brief Wypisuje podsumowania wszystkich gier z archiwum.
+ * Dla każdej gry wypisuje linię "numer_gry ruchy złote_ruchy zajęte_pola
+ * najlepszy_wynik", gdzie najlepszy wynik to liczba pól gracza, który zajął
+ * ich najwięcej. Uszkodzona gra jest sygnalizowana linią "ERROR numer_gry"
+ * na wyjściu błędów.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą archiwum,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą podsumowania,
+ * @param[in,out] err   – wskaźnik na strukturę zapisującą błędy.
+ * @return Wartość @p true, jeśli całe archiwum zostało przetworzone,
+ * a @p false, jeśli ma niepoprawny nagłówek lub jest uszkodzone.
+ */
+bool summary_session(reader *input, writer *out, writer *err)
+{
+    if (archive_check_header(input) == false)
+        return false;
+
+    archive_game info;
+    muint number = 0, moves, golden;
+    int next;
+    while ((next = archive_next_game(input, &info)) == 1)
+    {
+        number++;
+        gamma_t *game = archive_replay(&info, &moves, &golden);
+        if (game == NULL)
+        {
+            writer_put_string(err, "ERROR ");
+            writer_put_number(err, number);
+            writer_put_char(err, '\n');
+            writer_end(err);
+            continue;
+        }
+
+        writer_put_number(out, number);
+        writer_put_char(out, ' ');
+        writer_put_number(out, moves);
+        writer_put_char(out, ' ');
+        writer_put_number(out, golden);
+        writer_put_char(out, ' ');
+        writer_put_number(out, gamma_all_busy_fields(game));
+        writer_put_char(out, ' ');
+        writer_put_number(out, gamma_best_result(game));
+        writer_put_char(out, '\n');
+        writer_end(out);
+        gamma_delete(game);
+    }
+    return next == 0;
+}
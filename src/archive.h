@@ -0,0 +1,120 @@
+/** @file
+ * Interfejs zwięzłego binarnego archiwum rozegranych gier.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#ifndef GAMMA_ARCHIVE_H
+#define GAMMA_ARCHIVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "gamma.h"
+#include "reader.h"
+#include "writer.h"
+
+/**
+ * Znacznik początku pliku archiwum.
+ */
+#define ARCHIVE_MAGIC "GAMMAARC"
+
+/**
+ * Długość znacznika początku pliku archiwum.
+ */
+#define ARCHIVE_MAGIC_LEN 8
+
+/** @brief Gra zapisana w archiwum.
+ * Ruchy są zakodowane liczbami o zmiennej długości: numer gracza
+ * przesunięty o jeden bit w lewo, z najmłodszym bitem oznaczającym złoty
+ * ruch, a następnie różnice współrzędnych względem poprzedniego ruchu.
+ */
+typedef struct archive_game
+{
+    uint width; ///< Szerokość planszy.
+    uint height; ///< Wysokość planszy.
+    uint players; ///< Liczba graczy.
+    uint areas; ///< Maksymalna liczba obszarów jednego gracza.
+    const unsigned char *moves; ///< Zakodowane ruchy.
+    size_t len; ///< Liczba bajtów zakodowanych ruchów.
+} archive_game;
+
+/** @brief Pozycja w ciągu zakodowanych ruchów gry.
+ */
+typedef struct archive_cursor
+{
+    size_t pos; ///< Numer pierwszego nieodczytanego bajtu.
+    uint x; ///< Kolumna poprzedniego ruchu.
+    uint y; ///< Wiersz poprzedniego ruchu.
+} archive_cursor;
+
+/** @brief Ustawia kursor na pierwszym ruchu gry.
+ * @param[out] cursor – wskaźnik na kursor.
+ */
+void archive_cursor_init(archive_cursor *cursor);
+
+/** @brief Sprawdza nagłówek archiwum i pomija go.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą archiwum.
+ * @return Wartość @p true, jeśli dane zaczynają się nagłówkiem archiwum
+ * w obsługiwanej wersji, a @p false w przeciwnym razie.
+ */
+bool archive_check_header(reader *input);
+
+/** @brief Udostępnia kolejną grę z archiwum.
+ * Zakodowane ruchy gry są dostępne do kolejnego wywołania funkcji
+ * wczytujących z @p input.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą archiwum,
+ * @param[out] game     – wskaźnik na opis gry.
+ * @return Wartość @p 1, jeśli udostępniono kolejną grę, @p 0, jeśli
+ * archiwum się skończyło, a @p -1, jeśli archiwum jest uszkodzone.
+ */
+int archive_next_game(reader *input, archive_game *game);
+
+/** @brief Dekoduje kolejny ruch gry.
+ * @param[in] game          – wskaźnik na opis gry,
+ * @param[in,out] cursor    – wskaźnik na pozycję w ciągu ruchów,
+ * @param[out] m            – wskaźnik na odczytany ruch,
+ * @param[out] golden       – czy odczytany ruch jest złotym ruchem.
+ * @return Wartość @p 1, jeśli odczytano ruch, @p 0, jeśli ruchy gry się
+ * skończyły, a @p -1, jeśli zapis ruchu jest uszkodzony.
+ */
+int archive_next_move(const archive_game *game, archive_cursor *cursor,
+                      move *m, bool *golden);
+
+/** @brief Odtwarza grę z archiwum.
+ * Kolejne zwykłe ruchy są wykonywane grupami przez @ref gamma_move_batch.
+ * @param[in] game    – wskaźnik na opis gry,
+ * @param[out] moves  – liczba odtworzonych ruchów lub NULL,
+ * @param[out] golden – liczba odtworzonych złotych ruchów lub NULL.
+ * @return Wskaźnik na strukturę przechowującą stan gry po ostatnim ruchu
+ * lub NULL, jeśli zabrakło pamięci, gra jest uszkodzona lub któryś
+ * z zapisanych ruchów się nie powiódł.
+ */
+gamma_t *archive_replay(const archive_game *game, muint *moves, muint *golden);
+
+/** @brief Zapisuje do archiwum gry z zapisów tekstowych trybu wsadowego.
+ * Każde poprawne polecenie @p B rozpoczyna kolejną grę. Polecenia @p m
+ * i @p g są wykonywane, a do archiwum trafiają tylko udane ruchy. Pozostałe
+ * linie są pomijane.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą zapisy gier,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą archiwum.
+ * @return Wartość @p true, jeśli wszystkie gry zostały zapisane,
+ * a @p false, jeśli zabrakło pamięci.
+ */
+bool archive_session(reader *input, writer *out);
+
+/** @brief Wypisuje podsumowania wszystkich gier z archiwum.
+ * Dla każdej gry wypisuje linię "numer_gry ruchy złote_ruchy zajęte_pola
+ * najlepszy_wynik", gdzie najlepszy wynik to liczba pól gracza, który zajął
+ * ich najwięcej. Uszkodzona gra jest sygnalizowana linią "ERROR numer_gry"
+ * na wyjściu błędów.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą archiwum,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą podsumowania,
+ * @param[in,out] err   – wskaźnik na strukturę zapisującą błędy.
+ * @return Wartość @p true, jeśli całe archiwum zostało przetworzone,
+ * a @p false, jeśli ma niepoprawny nagłówek lub jest uszkodzone.
+ */
+bool summary_session(reader *input, writer *out, writer *err);
+
+#endif //GAMMA_ARCHIVE_H
@@ -0,0 +1,294 @@
+/** @file
+ * Implementacja modułu wykonującego polecenia trybu wsadowego.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#include "batch.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief Zapisuje odpowiedź będącą liczbą.
+ * Funkcja pomocnicza w @ref execute_command.
+ * @param[out] res – wskaźnik na odpowiedź,
+ * @param[in] n    – liczba będąca odpowiedzią.
+ */
+static inline void answer(response *res, muint n)
+{
+    res->kind = RESPONSE_NUMBER;
+    res->value = n;
+}
+
+/** @brief Zapisuje odpowiedź będącą napisem opisującym planszę.
+ * Funkcja pomocnicza w @ref execute_command.
+ * @param[out] res – wskaźnik na odpowiedź,
+ * @param[in] text – zaalokowany napis lub NULL, jeśli nie udało się
+ *                   go utworzyć.
+ */
+static inline void answer_text(response *res, char *text)
+{
+    res->kind = text == NULL ? RESPONSE_ERROR : RESPONSE_TEXT;
+    res->text = text;
+}
+
+/** @brief Zapisuje odpowiedź z polami zmienionymi od podanego momentu.
+ * Funkcja pomocnicza w @ref execute_command.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] epoch    – stan licznika zmian podany przez użytkownika,
+ * @param[out] res     – wskaźnik na odpowiedź.
+ */
+static void answer_changes(gamma_t *game, muint epoch, response *res)
+{
+    res->changes = gamma_changes(game, epoch, &res->count);
+    if (res->changes == NULL)
+    {
+        res->kind = RESPONSE_ERROR;
+        return;
+    }
+    res->kind = RESPONSE_CHANGES;
+    res->value = gamma_epoch(game);
+}
+
+/** @brief Ustawia odpowiedź oznaczającą błędne polecenie.
+ * @param[out] res – wskaźnik na odpowiedź.
+ */
+void response_init(response *res)
+{
+    res->kind = RESPONSE_ERROR;
+    res->text = NULL;
+    res->changes = NULL;
+}
+
+/** @brief Wykonuje polecenie trybu wsadowego.
+ * Wybór komendy odbywa się na podstawie jej jednoznakowego identyfikatora.
+ * Jeśli rozgrywka jeszcze się nie rozpoczęła, jedynym poprawnym poleceniem
+ * jest @p B, które tworzy nową grę.
+ * @param[in,out] game – wskaźnik na wskaźnik na strukturę przechowującą
+ *                       stan gry, NULL jeśli gra nie została utworzona,
+ * @param[in] cmd      – wskaźnik na przeanalizowane polecenie,
+ * @param[out] res     – wskaźnik na strukturę, w której zapisywana
+ *                       jest odpowiedź.
+ */
+void execute_command(gamma_t **game, const command *cmd, response *res)
+{
+    const uint *arg = cmd->args;
+    gamma_t *g = *game;
+    int args = cmd->arguments;
+    response_init(res);
+
+    // Rozpoczęcie rozgrywki w trybie wsadowym.
+    if (g == NULL)
+    {
+        if (cmd->type == 'B' && args == 4
+            && (*game = gamma_new(arg[0], arg[1], arg[2], arg[3])) != NULL)
+        {
+            res->kind = RESPONSE_OK;
+        }
+        return;
+    }
+
+    switch (cmd->type)
+    {
+        // Wywołanie zwykłego ruchu.
+        case 'm':
+            if (args == 3)
+                answer(res, gamma_move(g, arg[0], arg[1], arg[2]));
+            break;
+
+        // Wywołanie złotego ruchu.
+        case 'g':
+            if (args == 3)
+                answer(res, gamma_golden_move(g, arg[0], arg[1], arg[2]));
+            break;
+
+        // Wywołanie liczby zajętych pól.
+        case 'b':
+            if (args == 1)
+                answer(res, gamma_busy_fields(g, arg[0]));
+            break;
+
+        // Wywołanie liczby wolnych pól danego gracza.
+        case 'f':
+            if (args == 1)
+                answer(res, gamma_free_fields(g, arg[0]));
+            break;
+
+        // Pytanie o możliwość wykonania złotego ruchu.
+        case 'q':
+            if (args == 1)
+                answer(res, gamma_golden_possible(g, arg[0]));
+            break;
+
+        // Wypisanie pól zmienionych od podanego stanu licznika zmian.
+        case 'd':
+            if (args == 1)
+                answer_changes(g, cmd->epoch, res);
+            break;
+
+        // Wyświetlenie planszy aktualnego stanu rozgrywki.
+        case 'p':
+            if (args == 0)
+                answer_text(res, gamma_board(g));
+            break;
+
+        // Wyświetlenie planszy zakodowanej długościami serii.
+        case 'r':
+            if (args == 0)
+                answer_text(res, gamma_board_rle(g));
+            break;
+
+        default:
+            break;
+    }
+}
+
+/** @brief Zwalnia pamięć zajmowaną przez odpowiedź.
+ * @param[in,out] res – wskaźnik na odpowiedź.
+ */
+void response_free(response *res)
+{
+    free(res->text);
+    free(res->changes);
+    res->text = NULL;
+    res->changes = NULL;
+}
+
+/** @brief Wypisuje identyfikator gry i spację, jeśli go podano.
+ * Funkcja pomocnicza w @ref print_answer.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in] tag     – wskaźnik na identyfikator gry lub NULL.
+ */
+static void print_tag(writer *out, const uint *tag)
+{
+    if (tag != NULL)
+    {
+        writer_put_number(out, *tag);
+        writer_put_char(out, ' ');
+    }
+}
+
+/** @brief Wypisuje napis, poprzedzając każdą jego linię identyfikatorem gry.
+ * Funkcja pomocnicza w @ref print_answer.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in] text    – napis zakończony znakiem nowej linii,
+ * @param[in] tag     – wskaźnik na identyfikator gry lub NULL.
+ */
+static void print_text(writer *out, const char *text, const uint *tag)
+{
+    if (tag == NULL)
+    {
+        writer_put_string(out, text);
+        return;
+    }
+
+    while (*text != '\0')
+    {
+        const char *end = strchr(text, '\n');
+        size_t len = end != NULL ? (size_t) (end - text) + 1 : strlen(text);
+        print_tag(out, tag);
+        writer_put_bytes(out, text, len);
+        text += len;
+    }
+}
+
+/** @brief Wypisuje pola zmienione od podanego stanu licznika zmian.
+ * Funkcja pomocnicza w @ref print_answer.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in] res     – wskaźnik na odpowiedź,
+ * @param[in] tag     – wskaźnik na identyfikator gry lub NULL.
+ */
+static void print_changes(writer *out, const response *res, const uint *tag)
+{
+    print_tag(out, tag);
+    writer_put_number(out, res->value);
+    writer_put_char(out, ' ');
+    writer_put_number(out, res->count);
+    writer_put_char(out, '\n');
+    for (muint i = 0; i < res->count; ++i)
+    {
+        print_tag(out, tag);
+        writer_put_number(out, res->changes[i].x);
+        writer_put_char(out, ' ');
+        writer_put_number(out, res->changes[i].y);
+        writer_put_char(out, ' ');
+        writer_put_number(out, res->changes[i].owner);
+        writer_put_char(out, '\n');
+    }
+}
+
+/** @brief Wypisuje odpowiedź w formacie tekstowym.
+ * Funkcja pomocnicza w @ref print_response i @ref print_tagged_response.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err – wskaźnik na strukturę zapisującą błędy,
+ * @param[in] line    – numer linii, której dotyczy odpowiedź,
+ * @param[in,out] res – wskaźnik na odpowiedź,
+ * @param[in] tag     – wskaźnik na identyfikator gry poprzedzający każdą
+ *                      linię odpowiedzi lub NULL.
+ */
+static void print_answer(writer *out, writer *err, muint line, response *res,
+                         const uint *tag)
+{
+    switch (res->kind)
+    {
+        case RESPONSE_ERROR:
+            writer_put_string(err, "ERROR ");
+            writer_put_number(err, line);
+            writer_put_char(err, '\n');
+            writer_end(err);
+            return;
+
+        case RESPONSE_OK:
+            print_tag(out, tag);
+            writer_put_string(out, "OK ");
+            writer_put_number(out, line);
+            writer_put_char(out, '\n');
+            break;
+
+        case RESPONSE_NUMBER:
+            print_tag(out, tag);
+            writer_put_number(out, res->value);
+            writer_put_char(out, '\n');
+            break;
+
+        case RESPONSE_TEXT:
+            print_text(out, res->text, tag);
+            break;
+
+        case RESPONSE_CHANGES:
+            print_changes(out, res, tag);
+            break;
+    }
+    response_free(res);
+    writer_end(out);
+}
+
+/** @brief Wypisuje odpowiedź w formacie tekstowym.
+ * Błędy są wypisywane w postaci "ERROR numer_linii" do @p err,
+ * pozostałe odpowiedzi do @p out. Zwalnia pamięć zajmowaną przez odpowiedź.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err – wskaźnik na strukturę zapisującą błędy,
+ * @param[in] line    – numer linii, której dotyczy odpowiedź,
+ * @param[in,out] res – wskaźnik na odpowiedź.
+ */
+void print_response(writer *out, writer *err, muint line, response *res)
+{
+    print_answer(out, err, line, res, NULL);
+}
+
+/** @brief Wypisuje odpowiedź jednej z wielu gier w formacie tekstowym.
+ * Działa jak @ref print_response, ale każda linia odpowiedzi wypisywana
+ * do @p out jest poprzedzona identyfikatorem gry i spacją. Błędy nie mają
+ * identyfikatora, bo wskazuje je numer linii.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err – wskaźnik na strukturę zapisującą błędy,
+ * @param[in] line    – numer linii, której dotyczy odpowiedź,
+ * @param[in,out] res – wskaźnik na odpowiedź,
+ * @param[in] game    – identyfikator gry.
+ */
+void print_tagged_response(writer *out, writer *err, muint line, response *res,
+                           uint game)
+{
+    print_answer(out, err, line, res, &game);
+}
@@ -0,0 +1,84 @@
+/** @file
+ * Interfejs modułu wykonującego polecenia trybu wsadowego.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#ifndef GAMMA_BATCH_H
+#define GAMMA_BATCH_H
+
+#include "gamma.h"
+#include "parser.h"
+#include "writer.h"
+
+/** @brief Rodzaj odpowiedzi na polecenie trybu wsadowego.
+ */
+typedef enum response_kind
+{
+    RESPONSE_ERROR, ///< Polecenie jest błędne.
+    RESPONSE_OK, ///< Rozpoczęto rozgrywkę w trybie wsadowym.
+    RESPONSE_NUMBER, ///< Odpowiedzią jest liczba.
+    RESPONSE_TEXT, ///< Odpowiedzią jest napis opisujący planszę.
+    RESPONSE_CHANGES, ///< Odpowiedzią są pola zmienione od podanego momentu.
+} response_kind;
+
+/** @brief Struktura przechowująca odpowiedź na polecenie.
+ */
+typedef struct response
+{
+    response_kind kind; ///< Rodzaj odpowiedzi.
+    muint value; /**< Liczba będąca odpowiedzią, a dla zmienionych pól
+        aktualny stan licznika zmian planszy. */
+    char *text; ///< Zaalokowany napis opisujący planszę.
+    field_change *changes; ///< Zaalokowana tablica zmienionych pól.
+    muint count; ///< Liczba zmienionych pól.
+} response;
+
+/** @brief Ustawia odpowiedź oznaczającą błędne polecenie.
+ * @param[out] res – wskaźnik na odpowiedź.
+ */
+void response_init(response *res);
+
+/** @brief Wykonuje polecenie trybu wsadowego.
+ * Wybór komendy odbywa się na podstawie jej jednoznakowego identyfikatora.
+ * Jeśli rozgrywka jeszcze się nie rozpoczęła, jedynym poprawnym poleceniem
+ * jest @p B, które tworzy nową grę.
+ * @param[in,out] game – wskaźnik na wskaźnik na strukturę przechowującą
+ *                       stan gry, NULL jeśli gra nie została utworzona,
+ * @param[in] cmd      – wskaźnik na przeanalizowane polecenie,
+ * @param[out] res     – wskaźnik na strukturę, w której zapisywana
+ *                       jest odpowiedź.
+ */
+void execute_command(gamma_t **game, const command *cmd, response *res);
+
+/** @brief Zwalnia pamięć zajmowaną przez odpowiedź.
+ * @param[in,out] res – wskaźnik na odpowiedź.
+ */
+void response_free(response *res);
+
+/** @brief Wypisuje odpowiedź w formacie tekstowym.
+ * Błędy są wypisywane w postaci "ERROR numer_linii" do @p err,
+ * pozostałe odpowiedzi do @p out. Zwalnia pamięć zajmowaną przez odpowiedź.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err – wskaźnik na strukturę zapisującą błędy,
+ * @param[in] line    – numer linii, której dotyczy odpowiedź,
+ * @param[in,out] res – wskaźnik na odpowiedź.
+ */
+void print_response(writer *out, writer *err, muint line, response *res);
+
+/** @brief Wypisuje odpowiedź jednej z wielu gier w formacie tekstowym.
+ * Działa jak @ref print_response, ale każda linia odpowiedzi wypisywana
+ * do @p out jest poprzedzona identyfikatorem gry i spacją. Błędy nie mają
+ * identyfikatora, bo wskazuje je numer linii.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err – wskaźnik na strukturę zapisującą błędy,
+ * @param[in] line    – numer linii, której dotyczy odpowiedź,
+ * @param[in,out] res – wskaźnik na odpowiedź,
+ * @param[in] game    – identyfikator gry.
+ */
+void print_tagged_response(writer *out, writer *err, muint line, response *res,
+                           uint game);
+
+#endif //GAMMA_BATCH_H
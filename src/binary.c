@@ -0,0 +1,181 @@
+/** @file
+ * Implementacja binarnego protokołu poleceń trybu wsadowego.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#include "binary.h"
+#include "batch.h"
+#include <string.h>
+
+/**
+ * Status odpowiedzi na poprawne polecenie.
+ */
+#define STATUS_OK 0
+
+/**
+ * Status odpowiedzi na błędne polecenie.
+ */
+#define STATUS_ERROR 1
+
+/**
+ * Długość rekordu opisującego jedno zmienione pole.
+ */
+#define CHANGE_RECORD_LEN 12
+
+/** @brief Odczytuje liczbę 32-bitową zapisaną w porządku little-endian.
+ * @param[in] data – wskaźnik na pierwszy bajt liczby.
+ * @return Odczytana liczba.
+ */
+static inline uint get_u32(const unsigned char *data)
+{
+    return (uint) data[0] | (uint) data[1] << 8
+           | (uint) data[2] << 16 | (uint) data[3] << 24;
+}
+
+/** @brief Zapisuje liczbę w porządku little-endian.
+ * @param[out] data – wskaźnik na pierwszy bajt liczby,
+ * @param[in] n     – zapisywana liczba,
+ * @param[in] len   – liczba bajtów liczby.
+ */
+static inline void put_le(unsigned char *data, muint n, uint len)
+{
+    for (uint i = 0; i < len; ++i)
+    {
+        data[i] = n & 0xff;
+        n >>= 8;
+    }
+}
+
+/** @brief Sprawdza czy dane wejściowe rozpoczynają sesję binarną.
+ * Jeśli tak, pomija nagłówek sesji.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane.
+ * @return Wartość @p true, jeśli dane wejściowe zaczynają się nagłówkiem
+ * @ref BINARY_MAGIC, a @p false w przeciwnym razie.
+ */
+bool binary_magic(reader *input)
+{
+    // Najpierw sprawdzamy tylko pierwszy bajt, żeby w protokole tekstowym
+    // nie czekać na kolejne dane wpisywane w terminalu.
+    const char *data;
+    if (reader_available(input, 1, &data) == 0 || data[0] != BINARY_MAGIC[0])
+        return false;
+
+    if (reader_available(input, BINARY_MAGIC_LEN, &data) < BINARY_MAGIC_LEN
+        || memcmp(data, BINARY_MAGIC, BINARY_MAGIC_LEN) != 0)
+        return false;
+
+    reader_consume(input, BINARY_MAGIC_LEN);
+    return true;
+}
+
+/** @brief Dekoduje rekord z poleceniem.
+ * Funkcja pomocnicza w @ref binary_session.
+ * @param[in] data – wskaźnik na początek rekordu,
+ * @param[out] cmd – wskaźnik na strukturę z poleceniem.
+ * @return Wartość @p true, jeśli rekord ma poprawną liczbę argumentów,
+ * a @p false w przeciwnym razie.
+ */
+static bool decode_command(const unsigned char *data, command *cmd)
+{
+    cmd->type = data[0];
+    cmd->arguments = data[1];
+    for (int i = 0; i < MAX_ARGUMENTS; ++i)
+        cmd->args[i] = get_u32(data + 4 + 4 * i);
+    cmd->epoch = cmd->args[0];
+    return cmd->arguments <= MAX_ARGUMENTS;
+}
+
+/** @brief Zapisuje rekord z odpowiedzią wraz z następującymi po nim danymi.
+ * Funkcja pomocnicza w @ref binary_session.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in] number  – numer polecenia,
+ * @param[in] type    – identyfikator komendy,
+ * @param[in] res     – wskaźnik na odpowiedź.
+ */
+static void put_reply(writer *out, uint number, char type, const response *res)
+{
+    unsigned char record[REPLY_RECORD_LEN] = {0};
+    muint value = res->value;
+
+    if (res->kind == RESPONSE_TEXT)
+        value = strlen(res->text);
+    else if (res->kind == RESPONSE_CHANGES)
+        value = 8 + CHANGE_RECORD_LEN * res->count;
+    else if (res->kind != RESPONSE_NUMBER)
+        value = 0;
+
+    put_le(record, number, 4);
+    record[4] = type;
+    record[5] = res->kind == RESPONSE_ERROR ? STATUS_ERROR : STATUS_OK;
+    put_le(record + 8, value, 8);
+    writer_put_bytes(out, record, REPLY_RECORD_LEN);
+
+    if (res->kind == RESPONSE_TEXT)
+    {
+        writer_put_bytes(out, res->text, value);
+    }
+    else if (res->kind == RESPONSE_CHANGES)
+    {
+        unsigned char change[CHANGE_RECORD_LEN];
+        put_le(change, res->value, 8);
+        writer_put_bytes(out, change, 8);
+        for (muint i = 0; i < res->count; ++i)
+        {
+            put_le(change, res->changes[i].x, 4);
+            put_le(change + 4, res->changes[i].y, 4);
+            put_le(change + 8, res->changes[i].owner, 4);
+            writer_put_bytes(out, change, CHANGE_RECORD_LEN);
+        }
+    }
+}
+
+/** @brief Przeprowadza rozgrywkę w trybie wsadowym w protokole binarnym.
+ * Wczytuje kolejne rekordy poleceń aż do końca danych wejściowych, wykonuje
+ * je i zapisuje rekordy odpowiedzi. Niepełny rekord na końcu danych jest
+ * traktowany jako błędne polecenie.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą odpowiedzi.
+ */
+void binary_session(reader *input, writer *out)
+{
+    gamma_t *game = NULL;
+    const char *data;
+    size_t available;
+    uint number = 0;
+    command cmd;
+    response res;
+
+    while ((available = reader_available(input, COMMAND_RECORD_LEN, &data)) > 0)
+    {
+        number++;
+        if (available < COMMAND_RECORD_LEN)
+        {
+            // Niepełny rekord na końcu danych wejściowych.
+            reader_consume(input, available);
+            response_init(&res);
+            put_reply(out, number, data[0], &res);
+            break;
+        }
+
+        bool fine = decode_command((const unsigned char *) data, &cmd);
+        reader_consume(input, COMMAND_RECORD_LEN);
+        if (fine)
+        {
+            execute_command(&game, &cmd, &res);
+        }
+        else
+        {
+            response_init(&res);
+        }
+
+        put_reply(out, number, cmd.type, &res);
+        response_free(&res);
+        writer_end(out);
+    }
+
+    writer_end(out);
+    gamma_delete(game);
+}
@@ -0,0 +1,66 @@
+/** @file
+ * Interfejs binarnego protokołu poleceń trybu wsadowego.
+ *
+ * Sesja binarna rozpoczyna się nagłówkiem @ref BINARY_MAGIC. Każde polecenie
+ * to rekord długości @ref COMMAND_RECORD_LEN bajtów: identyfikator komendy
+ * (ten sam znak co w protokole tekstowym), liczba argumentów, dwa bajty
+ * zarezerwowane i cztery argumenty jako liczby 32-bitowe. Każda odpowiedź to
+ * rekord długości @ref REPLY_RECORD_LEN bajtów: numer polecenia (32 bity),
+ * identyfikator komendy, status (0 - poprawne polecenie, 1 - błąd), dwa bajty
+ * zarezerwowane i wartość 64-bitowa. Dla komend @p p i @p r wartością jest
+ * długość opisu planszy, który następuje bezpośrednio po rekordzie. Dla komendy
+ * @p d wartością jest długość danych następujących po rekordzie: aktualnego
+ * stanu licznika zmian (64 bity) i trójek (x, y, właściciel) po 32 bity.
+ * Wszystkie liczby są zapisywane w porządku little-endian.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#ifndef GAMMA_BINARY_H
+#define GAMMA_BINARY_H
+
+#include <stdbool.h>
+#include "reader.h"
+#include "writer.h"
+
+/**
+ * Nagłówek rozpoczynający sesję binarną. Zaczyna się od znaku, który nie może
+ * rozpoczynać poprawnej linii protokołu tekstowego.
+ */
+#define BINARY_MAGIC "\0GB\1"
+
+/**
+ * Długość nagłówka rozpoczynającego sesję binarną.
+ */
+#define BINARY_MAGIC_LEN 4
+
+/**
+ * Długość rekordu z poleceniem.
+ */
+#define COMMAND_RECORD_LEN 20
+
+/**
+ * Długość rekordu z odpowiedzią.
+ */
+#define REPLY_RECORD_LEN 16
+
+/** @brief Sprawdza czy dane wejściowe rozpoczynają sesję binarną.
+ * Jeśli tak, pomija nagłówek sesji.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane.
+ * @return Wartość @p true, jeśli dane wejściowe zaczynają się nagłówkiem
+ * @ref BINARY_MAGIC, a @p false w przeciwnym razie.
+ */
+bool binary_magic(reader *input);
+
+/** @brief Przeprowadza rozgrywkę w trybie wsadowym w protokole binarnym.
+ * Wczytuje kolejne rekordy poleceń aż do końca danych wejściowych, wykonuje
+ * je i zapisuje rekordy odpowiedzi. Niepełny rekord na końcu danych jest
+ * traktowany jako błędne polecenie.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą odpowiedzi.
+ */
+void binary_session(reader *input, writer *out);
+
+#endif //GAMMA_BINARY_H
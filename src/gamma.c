@@ -5,7 +5,20 @@
  * @copyright Uniwersytet Warszawski
  * @date 22 maja 2020
  */
+
+/**
+ * Makro wymagane do poprawnego działania funkcji @ref fdatasync.
+ */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "gamma.h"
 #include "stdio.h"
 
@@ -20,6 +33,77 @@
  */
 #define EMPTY 0
 
+/**
+ * O ile ruchów naprzód pola są sprowadzane do pamięci podręcznej
+ * w @ref gamma_move_batch i @ref gamma_golden_move_batch.
+ */
+#define PREFETCH_DISTANCE 8
+
+/**
+ * Liczba wpisów dziennika zmian, po osiągnięciu której najstarsza połowa
+ * wpisów jest usuwana.
+ */
+#define CHANGES_LIMIT (1 << 20)
+
+/**
+ * Znacznik początku pliku migawki stanu gry.
+ */
+#define SNAPSHOT_MAGIC "GAMMASNP"
+
+/**
+ * Długość znacznika początku pliku migawki.
+ */
+#define SNAPSHOT_MAGIC_LEN 8
+
+/**
+ * Wersja formatu migawki stanu gry.
+ */
+#define SNAPSHOT_VERSION 2
+
+/**
+ * Wartość zapisywana w kolejności bajtów komputera, pozwalająca wykryć
+ * migawkę zapisaną na komputerze o innej kolejności bajtów.
+ */
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+/**
+ * Rozmiar nagłówka migawki w bajtach.
+ */
+#define SNAPSHOT_HEADER_SIZE 128
+
+/**
+ * Wyrównanie w bajtach początków planszy i tablicy indeksów w migawce,
+ * dzięki któremu obie tablice zaczynają się na granicy strony pamięci
+ * po odwzorowaniu pliku przez @ref gamma_map.
+ */
+#define SNAPSHOT_ALIGN 4096
+
+/**
+ * Rozmiar rekordu jednego gracza w migawce w bajtach.
+ */
+#define SNAPSHOT_PLAYER_SIZE 32
+
+/**
+ * Rozmiar bufora zapisu i odczytu migawki.
+ */
+#define SNAPSHOT_BUFFER_SIZE (1 << 20)
+
+/**
+ * Największa liczba bajtów przekazywana w jednym wywołaniu
+ * @ref write lub @ref read podczas zapisu i odczytu migawki.
+ */
+#define SNAPSHOT_CHUNK (1 << 30)
+
+/**
+ * Przyrostek nazwy pliku tymczasowego, do którego trafia zapisywana migawka.
+ */
+#define SNAPSHOT_SUFFIX ".tmp"
+
+/**
+ * Największa liczba wątków, na które dzielona jest praca na planszy.
+ */
+#define MAX_THREADS 256
+
 /**
  * Stała do poruszanie się po planszy horyzontalnie.
  * Wykorzystawane przy funkcjach wzorowanych na DFS.
@@ -49,8 +133,36 @@ typedef struct player
     muint next_ind; /**< Zmienna pomocniczna, wolny indeks, do zajęcia
         prez nastepny obszar zajęty przez tego gracza. */
     muint border; ///< Liczba pustych pól które graniczą z polami gracza.
+    muint golden_checked; /**< Wartość licznika zmian planszy powiększona
+        o jeden, dla której obliczono @p golden, lub zero. */
+    bool golden; /**< Czy gracz mógł wykonać złoty ruch, mając już wszystkie
+        dozwolone obszary, przy wartości licznika z @p golden_checked. */
 } player;
 
+/** @brief Udany ruch zapisany w historii gry.
+ */
+typedef struct logged_move
+{
+    move m; ///< Gracz i pole ruchu.
+    bool golden; ///< Czy ruch był złotym ruchem.
+} logged_move;
+
+/** @brief Historia gry pozwalająca odtworzyć jej stan po dowolnym ruchu.
+ * Zawiera dziennik udanych ruchów oraz pełne kopie stanu gry wykonywane
+ * co @p interval ruchów. Kopia o numerze @p i przedstawia stan gry po
+ * pierwszych @p i * @p interval ruchach z dziennika.
+ */
+typedef struct history
+{
+    muint interval; ///< Liczba ruchów między kolejnymi kopiami stanu gry.
+    logged_move *moves; ///< Dziennik udanych ruchów.
+    muint len; ///< Liczba ruchów w dzienniku.
+    muint mem; ///< Liczba ruchów, na które zaalokowano pamięć.
+    struct gamma **checkpoints; ///< Kopie stanu gry.
+    muint checkpoints_len; ///< Liczba kopii stanu gry.
+    muint checkpoints_mem; ///< Liczba kopii, na które zaalokowano pamięć.
+} history;
+
 /** @brief Główna struktura gry Gamma.
  * Zawiera wszystkie informacje o aktualnej rozgrywce.
  */
@@ -73,6 +185,23 @@ typedef struct gamma
         zajętych przez graczy z przynajmniej dwucyfrowym indeksem. */
     uint golden_moves_used; /**< Pomocnicza zmienna do zliczania
         wykorzystanych złotych ruchów */
+    muint epoch; /**< Licznik zmian właścicieli pól na planszy,
+        zwiększany przy każdym zajęciu lub zwolnieniu pola. */
+    field_change *changes; /**< Dziennik zmian planszy, każdy wpis zawiera
+        właściciela pola sprzed zmiany. */
+    muint changes_len; ///< Liczba wpisów w dzienniku zmian.
+    muint changes_mem; ///< Liczba wpisów, na które zaalokowano pamięć.
+    muint changes_start; /**< Wartość licznika @p epoch, od której
+        prowadzony jest dziennik zmian. */
+    bool changes_tracked; ///< Czy dziennik zmian jest prowadzony.
+    void *map; /**< Odwzorowany w pamięci plik migawki, w którym leżą
+        kolumny planszy i tablicy indeksów, lub NULL. */
+    size_t map_len; ///< Długość odwzorowanego pliku migawki.
+    history *history; /**< Historia gry prowadzona po wywołaniu
+        @ref gamma_history lub NULL. */
+    muint over_checked; /**< Wartość licznika zmian planszy powiększona
+        o jeden, dla której obliczono @p over, lub zero. */
+    bool over; ///< Czy gra była zakończona przy wartości z @p over_checked.
 } gamma_t;
 
 /** @brief Alokuje pamieć na plansze do gry.
@@ -199,6 +328,7 @@ gamma_t *gamma_new(uint width, uint height, uint players, uint areas)
         game->players[i].free_golden_move = true;
         game->players[i].next_ind = 1;
         game->players[i].border = 0;
+        game->players[i].golden_checked = 0;
     }
 
     if (init_board(game, width, height) == false
@@ -214,9 +344,34 @@ gamma_t *gamma_new(uint width, uint height, uint players, uint areas)
     game->busy_fields = 0;
     game->fields_of_wider_players = 0;
     game->golden_moves_used = 0;
+    game->epoch = 0;
+    game->changes = NULL;
+    game->changes_len = 0;
+    game->changes_mem = 0;
+    game->changes_start = 0;
+    game->changes_tracked = false;
+    game->map = NULL;
+    game->map_len = 0;
+    game->history = NULL;
+    game->over_checked = 0;
     return game;
 }
 
+/** @brief Zwalnia historię gry wraz ze wszystkimi kopiami stanu gry.
+ * Funkcja pomocnicza w @ref gamma_delete i @ref gamma_history.
+ * @param[in] h – wskaźnik na historię lub NULL.
+ */
+static void free_history(history *h)
+{
+    if (h == NULL)
+        return;
+    for (muint i = 0; i < h->checkpoints_len; ++i)
+        gamma_delete(h->checkpoints[i]);
+    free(h->checkpoints);
+    free(h->moves);
+    free(h);
+}
+
 /** @brief Usuwa strukturę przechowującą stan gry.
  * Usuwa z pamięci strukturę wskazywaną przez @p g.
  * Nic nie robi, jeśli wskaźnik ten ma wartość NULL.
@@ -226,14 +381,23 @@ void gamma_delete(gamma_t *game)
 {
     if (game != NULL)
     {
-        for (uint i = 0; i < game->width; ++i)
+        if (game->map != NULL)
+        {
+            munmap(game->map, game->map_len);
+        }
+        else
         {
-            free(game->board[i]);
-            free(game->indexes[i]);
+            for (uint i = 0; i < game->width; ++i)
+            {
+                free(game->board[i]);
+                free(game->indexes[i]);
+            }
         }
         free(game->board);
         free(game->indexes);
         free(game->players);
+        free(game->changes);
+        free_history(game->history);
         free(game);
     }
 }
@@ -286,6 +450,169 @@ inline static bool coords_are_fine(uint x, uint y, gamma_t *game)
     return x < game->width && y < game->heigth;
 }
 
+/** @brief Odnotowuje zmianę właściciela pola.
+ * Zwiększa licznik zmian planszy, a jeśli prowadzony jest dziennik zmian,
+ * dopisuje do niego pole (@p x, @p y) wraz z jego poprzednim właścicielem.
+ * Jeśli zabraknie pamięci na dziennik, przestaje on być prowadzony
+ * i zostanie założony od nowa przy następnym wywołaniu @ref gamma_changes.
+ * Dziennik liczący @ref CHANGES_LIMIT wpisów traci najstarszą ich połowę.
+ * Funkcja pomocnicza w @ref gamma_move i @ref gamma_golden_move.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x        – numer kolumny zmienionego pola,
+ * @param[in] y        – numer wiersza zmienionego pola,
+ * @param[in] owner    – właściciel pola przed zmianą.
+ */
+static void note_change(gamma_t *game, uint x, uint y, uint owner)
+{
+    game->epoch++;
+    if (game->changes_tracked == false)
+        return;
+
+    // Pełny dziennik traci najstarszą połowę wpisów zamiast rosnąć dalej.
+    if (game->changes_len == game->changes_mem && CHANGES_LIMIT <= game->changes_len)
+    {
+        muint dropped = game->changes_len / 2;
+        memmove(game->changes, game->changes + dropped,
+                (game->changes_len - dropped) * sizeof(field_change));
+        game->changes_len -= dropped;
+        game->changes_start += dropped;
+    }
+    else if (game->changes_len == game->changes_mem)
+    {
+        muint mem = 2 * game->changes_mem + 16;
+        if (CHANGES_LIMIT < mem)
+            mem = CHANGES_LIMIT;
+        field_change *changes = realloc(game->changes, mem * sizeof(field_change));
+        if (changes == NULL)
+        {
+            free(game->changes);
+            game->changes = NULL;
+            game->changes_len = 0;
+            game->changes_mem = 0;
+            game->changes_tracked = false;
+            return;
+        }
+        game->changes = changes;
+        game->changes_mem = mem;
+    }
+
+    game->changes[game->changes_len].x = x;
+    game->changes[game->changes_len].y = y;
+    game->changes[game->changes_len].owner = owner;
+    game->changes_len++;
+}
+
+/** @brief Wycofuje ostatnie zmiany, które wzajemnie się zniosły.
+ * Przywraca licznik zmian planszy do wartości @p epoch i usuwa z końca
+ * dziennika zmian wpisy odnotowane od tamtej chwili. Wykonuje się po
+ * nieudanym złotym ruchu, który przywrócił poprzedniego właściciela pola,
+ * aby licznik zmian rósł tylko wraz z udanymi ruchami.
+ * Funkcja pomocnicza w @ref golden_place.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] epoch    – wartość licznika zmian sprzed wycofywanych zmian.
+ */
+static void forget_changes(gamma_t *game, muint epoch)
+{
+    muint undone = game->epoch - epoch;
+    game->epoch = epoch;
+    if (game->changes_tracked)
+        game->changes_len -= undone;
+}
+
+/** @brief Tworzy kopię stanu gry.
+ * Kopia nie ma dziennika zmian ani historii, a jej plansza leży w zwykłej
+ * pamięci także wtedy, gdy plansza oryginału jest odwzorowaną migawką.
+ * Funkcja pomocnicza w @ref note_move, @ref gamma_history i @ref gamma_seek.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wskaźnik na kopię lub NULL, jeśli nie udało się zaalokować pamięci.
+ */
+static gamma_t *gamma_clone(gamma_t *game)
+{
+    gamma_t *copy = gamma_new(game->width, game->heigth,
+                              game->number_of_players, game->max_areas);
+    if (copy == NULL)
+        return NULL;
+
+    for (uint x = 0; x < game->width; ++x)
+    {
+        memcpy(copy->board[x], game->board[x], game->heigth * sizeof(uint));
+        memcpy(copy->indexes[x], game->indexes[x], game->heigth * sizeof(muint));
+    }
+    memcpy(copy->players + 1, game->players + 1,
+           game->number_of_players * sizeof(player));
+    copy->busy_fields = game->busy_fields;
+    copy->fields_of_wider_players = game->fields_of_wider_players;
+    copy->golden_moves_used = game->golden_moves_used;
+    copy->epoch = game->epoch;
+    return copy;
+}
+
+/** @brief Dopisuje kopię stanu gry do historii.
+ * Funkcja pomocnicza w @ref note_move i @ref gamma_history.
+ * @param[in,out] h – wskaźnik na historię,
+ * @param[in] game  – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli kopia została dopisana, a @p false,
+ * jeśli nie udało się zaalokować pamięci.
+ */
+static bool add_checkpoint(history *h, gamma_t *game)
+{
+    if (h->checkpoints_len == h->checkpoints_mem)
+    {
+        muint mem = 2 * h->checkpoints_mem + 4;
+        gamma_t **checkpoints = realloc(h->checkpoints, mem * sizeof(gamma_t*));
+        if (checkpoints == NULL)
+            return false;
+        h->checkpoints = checkpoints;
+        h->checkpoints_mem = mem;
+    }
+
+    gamma_t *copy = gamma_clone(game);
+    if (copy == NULL)
+        return false;
+    h->checkpoints[h->checkpoints_len++] = copy;
+    return true;
+}
+
+/** @brief Odnotowuje udany ruch w historii gry.
+ * Co @p interval ruchów zapisuje kopię stanu gry. Jeśli zabraknie pamięci,
+ * historia jest porzucana i trzeba ją włączyć ponownie przez
+ * @ref gamma_history.
+ * Funkcja pomocnicza w @ref gamma_move, @ref gamma_golden_move
+ * i ich wersjach wsadowych.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] m        – wskaźnik na wykonany ruch,
+ * @param[in] golden   – czy ruch był złotym ruchem.
+ */
+static void note_move(gamma_t *game, const move *m, bool golden)
+{
+    history *h = game->history;
+    if (h == NULL)
+        return;
+
+    if (h->len == h->mem)
+    {
+        muint mem = 2 * h->mem + 64;
+        logged_move *moves = realloc(h->moves, mem * sizeof(logged_move));
+        if (moves == NULL)
+        {
+            free_history(h);
+            game->history = NULL;
+            return;
+        }
+        h->moves = moves;
+        h->mem = mem;
+    }
+
+    h->moves[h->len].m = *m;
+    h->moves[h->len].golden = golden;
+    h->len++;
+    if (h->len % h->interval == 0 && add_checkpoint(h, game) == false)
+    {
+        free_history(h);
+        game->history = NULL;
+    }
+}
+
 /** @brief Sprawdza czy koło podanego pola jest pole gracza @p player.
  * Sprawdzane jest czy jedno sąsiądnich pól wzgledem
  * pola (@p x, @p y) nalezy do gracza @p player.
@@ -347,10 +674,164 @@ static void reindexify(gamma_t *game, uint player, uint x, uint y, muint from, m
     }
 }
 
+/** @brief Sprawdza bez przeszukiwania obszaru, czy pole można odebrać.
+ * Zwolnienie pola (@p x, @p y) dzieli obszar jego właściciela na co najwyżej
+ * tyle części, ile ma on pól wokół niego. Funkcja tylko czyta stan gry,
+ * więc może być wykonywana równolegle.
+ * Funkcja pomocnicza w @ref releasable i @ref golden_strip.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x    – numer kolumny zajętego pola,
+ * @param[in] y    – numer wiersza zajętego pola.
+ * @return Wartość @p true, jeśli właściciel na pewno nie przekroczy limitu
+ * obszarów po utracie pola, a @p false, jeśli nie da się tego rozstrzygnąć.
+ */
+static bool surely_releasable(gamma_t *game, uint x, uint y)
+{
+    uint owner = game->board[x][y];
+    uint around = 0;
+    for (int i = 0; i < DIRECTIONS; ++i)
+    {
+        uint _x = x + X[i];
+        uint _y = y + Y[i];
+        if (coords_are_fine(_x, _y, game) && game->board[_x][_y] == owner)
+            around++;
+    }
+    return game->players[owner].areas + around <= game->max_areas + 1;
+}
+
+/** @brief Sprawdza, czy właściciel pola może je stracić.
+ * Jeśli liczba pól właściciela wokół pola (@p x, @p y) nie rozstrzyga
+ * sprawy, części obszaru pozostałe po zwolnieniu pola są zliczane przez
+ * nadanie im nowego indeksu.
+ * Funkcja pomocnicza w @ref golden_scan i @ref golden_pass.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x        – numer kolumny zajętego pola,
+ * @param[in] y        – numer wiersza zajętego pola.
+ * @return Wartość @p true, jeśli po utracie pola właściciel nie przekroczy
+ * limitu obszarów, a @p false w przeciwnym przypadku.
+ */
+static bool releasable(gamma_t *game, uint x, uint y)
+{
+    if (surely_releasable(game, x, y))
+        return true;
+
+    uint outsider = game->board[x][y];
+    muint old_ind = game->indexes[x][y];
+    muint new_ind = game->players[outsider].next_ind++;
+    game->indexes[x][y] = new_ind;
+    int cnt = -1;
+    for (int i = 0; i < DIRECTIONS; ++i)
+    {
+        uint _x = x + X[i];
+        uint _y = y + Y[i];
+        if (coords_are_fine(_x, _y, game)
+            && game->board[_x][_y] == outsider
+            && game->indexes[_x][_y] == old_ind)
+        {
+            cnt++;
+            reindexify(game, outsider, _x, _y, old_ind, new_ind);
+        }
+    }
+
+    return game->players[outsider].areas + cnt <= game->max_areas;
+}
+
+/** @brief Szuka pola, na którym gracz może wykonać złoty ruch.
+ * Przegląda planszę w poszukiwaniu pola innego gracza, sąsiadującego z polem
+ * gracza @p player, którego zajęcie nie rozspójni obszarów właściciela ponad
+ * dozwoloną liczbę. Zakłada, że gracz @p player ma już wszystkie dozwolone
+ * obszary.
+ * Funkcja pomocnicza w @ref gamma_golden_possible.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player   – numer gracza, liczba dodatnia niewiększa od wartości
+ *                       @p players z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli takie pole istnieje, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool golden_scan(gamma_t *game, uint player)
+{
+    for (uint x = 0; x < game->width; ++x)
+    {
+        for (uint y = 0; y < game->heigth; ++y)
+        {
+            // Zajmuje inny gracz to pole, a gracz może
+            // dołączyć je do swoich obszarów.
+            if (game->board[x][y] != EMPTY && game->board[x][y] != player
+                && neighbourhood_is_fine(game, player, x, y)
+                && releasable(game, x, y))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+/** @brief Szuka złotych ruchów wielu graczy w jednym przejściu po planszy.
+ * Każde pole jest sprawdzane co najwyżej raz, niezależnie od liczby
+ * sąsiadujących z nim graczy. Przejście kończy się, gdy każdy z szukanych
+ * graczy ma już znane pole. Odpowiedzi są zapamiętywane do następnej
+ * zmiany planszy.
+ * Funkcja pomocnicza w @ref gamma_golden_possible_all.
+ * @param[in,out] game   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in,out] wanted – tablica indeksowana numerami graczy, wartość
+ *                         @p true oznacza gracza, dla którego szukane jest
+ *                         pole; po znalezieniu pola jest zerowana,
+ * @param[in] remaining  – liczba szukanych graczy,
+ * @param[out] out       – tablica indeksowana numerami graczy, w której
+ *                         szukanym graczom wpisywane są odpowiedzi.
+ */
+static void golden_pass(gamma_t *game, bool *wanted, uint remaining, bool *out)
+{
+    for (uint x = 0; x < game->width && remaining > 0; ++x)
+    {
+        for (uint y = 0; y < game->heigth && remaining > 0; ++y)
+        {
+            uint owner = game->board[x][y];
+            if (owner == EMPTY)
+                continue;
+
+            int fine = -1;
+            for (int i = 0; i < DIRECTIONS; ++i)
+            {
+                uint _x = x + X[i];
+                uint _y = y + Y[i];
+                if (coords_are_fine(_x, _y, game) == false)
+                    continue;
+                uint p = game->board[_x][_y];
+                if (p == EMPTY || p == owner || wanted[p] == false)
+                    continue;
+
+                if (fine == -1)
+                    fine = releasable(game, x, y);
+                if (fine == 1)
+                {
+                    out[p] = true;
+                    game->players[p].golden = true;
+                    game->players[p].golden_checked = game->epoch + 1;
+                    wanted[p] = false;
+                    remaining--;
+                }
+            }
+        }
+    }
+
+    for (uint p = 1; p <= game->number_of_players; ++p)
+    {
+        if (wanted[p])
+        {
+            out[p] = false;
+            game->players[p].golden = false;
+            game->players[p].golden_checked = game->epoch + 1;
+        }
+    }
+}
+
 /** @brief Sprawdza, czy gracz może wykonać złoty ruch.
  * Sprawdza, czy gracz @p player jeszcze nie wykonał w tej rozgrywce złotego
  * ruchu i jest przynajmniej jedno pole zajęte przez innego gracza, którego
  * zajęcie nie rozpójni obszarów tego gracza ponad dozwoloną liczbę.
+ * Wynik przeszukania planszy jest zapamiętywany do następnej zmiany planszy,
+ * więc kolejne wywołania dla tego samego stanu gry działają w czasie stałym.
  * @param[in] game    – wskaźnik na strukturę przechowującą stan gry,
  * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
  *                      @p players z funkcji @ref gamma_new.
@@ -369,42 +850,49 @@ bool gamma_golden_possible(gamma_t *game, uint player)
     if (game->players[player].areas < game->max_areas)
         return true;
 
-    for (uint x = 0; x < game->width; ++x)
+    if (game->players[player].golden_checked != game->epoch + 1)
     {
-        for (uint y = 0; y < game->heigth; ++y)
+        game->players[player].golden = golden_scan(game, player);
+        game->players[player].golden_checked = game->epoch + 1;
+    }
+    return game->players[player].golden;
+}
+
+/** @brief Sprawdza, czy gra się zakończyła.
+ * Gra kończy się, gdy żaden gracz nie może wykonać ani zwykłego, ani złotego
+ * ruchu. Wynik jest zapamiętywany do następnej zmiany planszy.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli żaden gracz nie może wykonać ruchu lub
+ * @p game ma wartość NULL, a @p false w przeciwnym przypadku.
+ */
+bool gamma_game_over(gamma_t *game)
+{
+    if (game == NULL)
+        return true;
+
+    if (game->over_checked != game->epoch + 1)
+    {
+        game->over = true;
+        for (uint i = 1; i <= game->number_of_players && game->over; ++i)
         {
-            // Zajmuje inny gracz to pole.
-            if (game->board[x][y] != EMPTY && game->board[x][y] != player)
-            {
-                // Gracz może dołączyć to pole do swoich obszarów.
-                if (neighbourhood_is_fine(game, player, x, y))
-                {
-                    uint outsider = game->board[x][y];
-                    uint old_ind = game->indexes[x][y];
-                    uint new_ind = game->players[outsider].next_ind++;
-                    game->indexes[x][y] = new_ind;
-                    int cnt = -1;
-                    for (int i = 0; i < DIRECTIONS; ++i)
-                    {
-                        uint _x = x + X[i];
-                        uint _y = y + Y[i];
-                        if (coords_are_fine(_x, _y, game)
-                            && game->board[_x][_y] == outsider
-                            && game->indexes[_x][_y] == old_ind)
-                        {
-                            cnt++;
-                            reindexify(game, outsider, _x, _y, old_ind, new_ind);
-                        }
-                    }
-
-                    if (game->players[outsider].areas + cnt <= game->max_areas)
-                        return true;
-                }
-            }
+            if (gamma_free_fields(game, i) > 0)
+                game->over = false;
         }
-    }
 
-    return false;
+        // Złote ruchy wszystkich graczy są szukane w jednym przejściu.
+        bool *golden = NULL;
+        if (game->over)
+            golden = malloc(((muint) game->number_of_players + 1) * sizeof(bool));
+        bool all = golden != NULL && gamma_golden_possible_all(game, golden, 1);
+        for (uint i = 1; i <= game->number_of_players && game->over; ++i)
+        {
+            if (all ? golden[i] : gamma_golden_possible(game, i))
+                game->over = false;
+        }
+        free(golden);
+        game->over_checked = game->epoch + 1;
+    }
+    return game->over;
 }
 
 /** @brief Podaje liczbę pól zajętych przez gracza.
@@ -524,8 +1012,12 @@ static void update_positive_border(gamma_t *game, uint player, uint x, uint y)
     }
 }
 
-/** @brief Wykonuje ruch.
- * Ustawia pionek gracza @p player na polu (@p x, @p y).
+/** @brief Wykonuje ruch o sprawdzonych parametrach.
+ * Ustawia pionek gracza @p player na polu (@p x, @p y), o ile pole jest
+ * puste, a gracz nie przekroczy dozwolonej liczby obszarów. Zakłada,
+ * że @p game nie ma wartości NULL, a gracz i współrzędne są poprawne.
+ * Funkcja pomocnicza w @ref gamma_move, @ref gamma_move_batch
+ * i @ref golden_place.
  * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
  * @param[in] player   – numer gracza, liczba dodatnia niewiększa od wartości
  *                      @p players z funkcji @ref gamma_new,
@@ -534,76 +1026,155 @@ static void update_positive_border(gamma_t *game, uint player, uint x, uint y)
  * @param[in] y        – numer wiersza, liczba nieujemna mniejsza od wartości
  *                      @p height z funkcji @ref gamma_new.
  * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
- * gdy ruch jest nielegalny lub któryś z parametrów jest niepoprawny.
+ * gdy ruch jest nielegalny.
  */
-bool gamma_move(gamma_t *game, uint player, uint x, uint y)
+static inline bool place(gamma_t *game, uint player, uint x, uint y)
 {
-    if (game != NULL && coords_are_fine(x, y, game)
-        && player_is_fine(player, game)
-        && game->board[x][y] == EMPTY)
+    if (game->board[x][y] != EMPTY)
+        return false;
+
+    for (uint i = 0; i < DIRECTIONS; ++i)
     {
-        for (uint i = 0; i < DIRECTIONS; ++i)
+        uint _x = x + X[i];
+        uint _y = y + Y[i];
+        if (coords_are_fine(_x, _y, game) && game->board[_x][_y] == player)
         {
-            uint _x = x + X[i];
-            uint _y = y + Y[i];
-            if (coords_are_fine(_x, _y, game) && game->board[_x][_y] == player)
+            if (game->indexes[x][y] == EMPTY)
             {
-                if (game->indexes[x][y] == EMPTY)
-                {
-                    game->indexes[x][y] = game->indexes[_x][_y];
-                    game->board[x][y] = player;
-                    game->players[player].fields++;
-                    game->busy_fields++;
-                    if (WIDE < player)
-                        game->fields_of_wider_players++;
-                }
-                else if (game->indexes[x][y] != game->indexes[_x][_y])
-                {
-                    reindexify(game, player, _x, _y, game->indexes[_x][_y], game->indexes[x][y]);
-                    game->players[player].areas--;
-                }
+                game->indexes[x][y] = game->indexes[_x][_y];
+                game->board[x][y] = player;
+                game->players[player].fields++;
+                game->busy_fields++;
+                if (WIDE < player)
+                    game->fields_of_wider_players++;
+            }
+            else if (game->indexes[x][y] != game->indexes[_x][_y])
+            {
+                reindexify(game, player, _x, _y, game->indexes[_x][_y], game->indexes[x][y]);
+                game->players[player].areas--;
             }
         }
-        if (game->indexes[x][y] != EMPTY)
-        {
-            game->board[x][y] = EMPTY;
-            update_positive_border(game, player, x, y);
-            game->board[x][y] = player;
-            return true;
-        }
-        else if (game->players[player].areas < game->max_areas)
-        {
-            game->indexes[x][y] = game->players[player].next_ind++;
-            game->players[player].areas++;
-            game->players[player].fields++;
-            game->busy_fields++;
-            if (WIDE < player)
-                game->fields_of_wider_players++;
-            game->board[x][y] = EMPTY;
-            update_positive_border(game, player, x, y);
-            game->board[x][y] = player;
-            return true;
-        }
+    }
+    if (game->indexes[x][y] != EMPTY)
+    {
+        game->board[x][y] = EMPTY;
+        update_positive_border(game, player, x, y);
+        game->board[x][y] = player;
+        note_change(game, x, y, EMPTY);
+        return true;
+    }
+    else if (game->players[player].areas < game->max_areas)
+    {
+        game->indexes[x][y] = game->players[player].next_ind++;
+        game->players[player].areas++;
+        game->players[player].fields++;
+        game->busy_fields++;
+        if (WIDE < player)
+            game->fields_of_wider_players++;
+        game->board[x][y] = EMPTY;
+        update_positive_border(game, player, x, y);
+        game->board[x][y] = player;
+        note_change(game, x, y, EMPTY);
+        return true;
     }
     return false;
 }
 
-/** @brief Oblicza logarytm dziesiętny zaokrąglony w góre do liczby całkowitej.
- * Funkcja pomocnicza do szacowania rozmiaru tablicy w @ref gamma_spaced_board,
- * @ref show_board oraz @ref interactive_game.
- * @param[in] x    – liczba logarytmowana.
- * @return Wynik tego działania.
+/** @brief Wykonuje ruch.
+ * Ustawia pionek gracza @p player na polu (@p x, @p y).
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player   – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x        – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y        – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
+ * gdy ruch jest nielegalny lub któryś z parametrów jest niepoprawny.
  */
-uint ceil_log(uint x)
+bool gamma_move(gamma_t *game, uint player, uint x, uint y)
 {
-    uint res = 0;
-    while (x != 0)
-    {
-        res++;
-        x /= 10;
-    }
-    return res;
-}
+    if (game == NULL || coords_are_fine(x, y, game) == false
+        || player_is_fine(player, game) == false
+        || place(game, player, x, y) == false)
+        return false;
+
+    move m = {player, x, y};
+    note_move(game, &m, false);
+    return true;
+}
+
+/** @brief Sprowadza do pamięci podręcznej pole, którego dotyczy ruch.
+ * Pole jest pobierane z wyprzedzeniem tylko wtedy, gdy jego współrzędne
+ * są poprawne.
+ * Funkcja pomocnicza w @ref gamma_move_batch i @ref gamma_golden_move_batch.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] m    – wskaźnik na ruch.
+ */
+static inline void prefetch_field(gamma_t *game, const move *m)
+{
+    if (coords_are_fine(m->x, m->y, game))
+    {
+        __builtin_prefetch(&game->board[m->x][m->y], 1);
+        __builtin_prefetch(&game->indexes[m->x][m->y], 1);
+    }
+}
+
+/** @brief Wykonuje ciąg ruchów.
+ * Wykonuje po kolei ruchy z tablicy @p moves, dając ten sam wynik co kolejne
+ * wywołania @ref gamma_move. Poprawność @p game jest sprawdzana raz, a pola
+ * kolejnych ruchów są z wyprzedzeniem sprowadzane do pamięci podręcznej.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves    – tablica ruchów,
+ * @param[in] n        – liczba ruchów,
+ * @param[out] results – tablica na @p n wyników kolejnych ruchów lub NULL.
+ * @return Liczba wykonanych ruchów.
+ */
+size_t gamma_move_batch(gamma_t *game, const move *moves, size_t n, bool *results)
+{
+    if (game == NULL)
+    {
+        for (size_t i = 0; results != NULL && i < n; ++i)
+            results[i] = false;
+        return 0;
+    }
+
+    size_t done = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i + PREFETCH_DISTANCE < n)
+            prefetch_field(game, &moves[i + PREFETCH_DISTANCE]);
+
+        const move *m = &moves[i];
+        bool result = coords_are_fine(m->x, m->y, game)
+                      && player_is_fine(m->player, game)
+                      && place(game, m->player, m->x, m->y);
+        if (result)
+            note_move(game, m, false);
+        if (results != NULL)
+            results[i] = result;
+        done += result;
+    }
+
+    return done;
+}
+
+/** @brief Oblicza logarytm dziesiętny zaokrąglony w góre do liczby całkowitej.
+ * Funkcja pomocnicza do szacowania rozmiaru tablicy w @ref gamma_spaced_board
+ * oraz szerokości pól rysowanych przez @ref interactive_game.
+ * @param[in] x    – liczba logarytmowana.
+ * @return Wynik tego działania.
+ */
+uint ceil_log(uint x)
+{
+    uint res = 0;
+    while (x != 0)
+    {
+        res++;
+        x /= 10;
+    }
+    return res;
+}
 
 /** @brief Daje napis opisujący stan plansz.
  * Alokuje w pamięci bufor, w którym umieszcza napis zawierający tekstowy
@@ -710,6 +1281,169 @@ char *gamma_board(gamma_t *game)
     return board_display;
 }
 
+/** @brief Bufor na napis o zmiennej długości.
+ * Wykorzystywany przy budowaniu napisów, których długości
+ * nie da się z góry oszacować.
+ */
+typedef struct text
+{
+    char *data; ///< Zaalokowany bufor z napisem.
+    muint len; ///< Liczba zapisanych znaków.
+    muint mem; ///< Rozmiar zaalokowanego bufora.
+} text;
+
+/** @brief Zapewnia miejsce w buforze na kolejne znaki.
+ * Jeśli to konieczne, co najmniej podwaja rozmiar bufora.
+ * W przypadku braku pamięci zwalnia bufor.
+ * @param[in,out] t  – wskaźnik na bufor,
+ * @param[in] extra  – liczba znaków, które mają się jeszcze zmieścić.
+ * @return Wartość @p true, jeśli bufor pomieści @p extra kolejnych znaków,
+ * a @p false, jeśli nie udało się zaalokować pamięci.
+ */
+static bool text_reserve(text *t, muint extra)
+{
+    if (t->len + extra <= t->mem)
+        return true;
+
+    muint mem = 2 * t->mem;
+    if (mem < t->len + extra)
+        mem = t->len + extra;
+    char *data = realloc(t->data, mem * sizeof(char));
+    if (data == NULL)
+    {
+        free(t->data);
+        t->data = NULL;
+        return false;
+    }
+    t->data = data;
+    t->mem = mem;
+    return true;
+}
+
+/** @brief Dopisuje liczbę w zapisie dziesiętnym do bufora.
+ * Bufor musi mieć zapewnione miejsce na co najmniej 20 znaków.
+ * @param[in,out] t – wskaźnik na bufor,
+ * @param[in] n     – dopisywana liczba.
+ */
+static void text_put_number(text *t, muint n)
+{
+    char reversed[20];
+    uint len = 0;
+    do
+    {
+        reversed[len++] = digits[n % 10];
+        n /= 10;
+    } while (n != 0);
+
+    while (len > 0)
+        t->data[t->len++] = reversed[--len];
+}
+
+/** @brief Sprawdza czy dwa wiersze planszy są identyczne.
+ * Funkcja pomocnicza w @ref gamma_board_rle.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] a    – numer pierwszego wiersza,
+ * @param[in] b    – numer drugiego wiersza.
+ * @return Wartość @p true, jeśli wiersze mają tych samych właścicieli
+ * na wszystkich polach, a @p false w przeciwnym przypadku.
+ */
+static bool same_rows(gamma_t *game, uint a, uint b)
+{
+    for (uint x = 0; x < game->width; ++x)
+    {
+        if (game->board[x][a] != game->board[x][b])
+            return false;
+    }
+    return true;
+}
+
+/** @brief Dopisuje do bufora zakodowany wiersz planszy.
+ * Wiersz jest zapisywany jako ciąg serii oddzielonych spacjami. Seria to
+ * identyfikator gracza albo kropka dla pustych pól, a jeśli seria ma więcej
+ * niż jedno pole, także gwiazdka i długość serii.
+ * Funkcja pomocnicza w @ref gamma_board_rle.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in,out] t – wskaźnik na bufor,
+ * @param[in] y    – numer kodowanego wiersza.
+ * @return Wartość @p true, jeśli wiersz został dopisany, a @p false,
+ * jeśli nie udało się zaalokować pamięci.
+ */
+static bool rle_row(gamma_t *game, text *t, uint y)
+{
+    uint x = 0;
+    while (x < game->width)
+    {
+        uint val = game->board[x][y];
+        uint start = x;
+        while (x < game->width && game->board[x][y] == val)
+            x++;
+
+        // Miejsce na spację, identyfikator, gwiazdkę, długość i koniec linii.
+        if (text_reserve(t, 24) == false)
+            return false;
+        if (start != 0)
+            t->data[t->len++] = ' ';
+        if (val == EMPTY)
+            t->data[t->len++] = '.';
+        else
+            text_put_number(t, val);
+        if (x - start > 1)
+        {
+            t->data[t->len++] = '*';
+            text_put_number(t, x - start);
+        }
+    }
+    t->data[t->len++] = '\n';
+    return true;
+}
+
+/** @brief Daje skompresowany napis opisujący stan planszy.
+ * Alokuje w pamięci bufor, w którym umieszcza opis planszy zakodowany
+ * długościami serii. Wiersze są wypisywane w tej samej kolejności co
+ * w @ref gamma_board. Każdy wiersz jest ciągiem serii oddzielonych spacjami,
+ * np. wiersz "..11111..." ma postać ".*2 1*5 .*3". Ciąg @p k wierszy
+ * identycznych z wierszem poprzednim zapisywany jest jako jedna linia "=k".
+ * Napis powstaje bezpośrednio z planszy, bez budowania pełnego opisu.
+ * Funkcja wywołująca musi zwolnić ten bufor.
+ * @param[in] game    – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wskaźnik na zaalokowany bufor zawierający napis opisujący stan
+ * planszy lub NULL, jeśli nie udało się zaalokować pamięci.
+ */
+char *gamma_board_rle(gamma_t *game)
+{
+    if (game == NULL)
+        return NULL;
+
+    text t = {NULL, 0, 0};
+    uint y = game->heigth;
+    while (y > 0)
+    {
+        y--;
+        if (rle_row(game, &t, y) == false)
+            return NULL;
+
+        uint repeated = 0;
+        while (y > 0 && same_rows(game, y, y - 1))
+        {
+            repeated++;
+            y--;
+        }
+        if (repeated > 0)
+        {
+            if (text_reserve(&t, 22) == false)
+                return NULL;
+            t.data[t.len++] = '=';
+            text_put_number(&t, repeated);
+            t.data[t.len++] = '\n';
+        }
+    }
+
+    if (text_reserve(&t, 1) == false)
+        return NULL;
+    t.data[t.len++] = '\0';
+    return t.data;
+}
+
 /** @brief Aktualizuje liczbę sąsiednich wolnych pól.
  * Sprawdza jak zwolnienie pola (@p x, @p y) wpływa na liczbę wolnych pól wokół tego pola,
  * nastepnie aktualizuje ten parametr u wszystkich sąsiadów tego pola.
@@ -788,9 +1522,11 @@ static void lost_independent_borders(gamma_t *game, uint player_out, uint x, uin
     }
 }
 
-/** @brief Wykonuje złoty ruch.
+/** @brief Wykonuje złoty ruch o sprawdzonych parametrach.
  * Ustawia pionek gracza @p player na polu (@p x, @p y) zajętym przez innego
- * gracza, usuwając pionek innego gracza.
+ * gracza, usuwając pionek innego gracza. Zakłada, że gracz może jeszcze
+ * wykonać złoty ruch, a współrzędne są poprawne.
+ * Funkcja pomocnicza w @ref gamma_golden_move i @ref gamma_golden_move_batch.
  * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
  * @param[in] player   – numer gracza, liczba dodatnia niewiększa od wartości
  *                      @p players z funkcji @ref gamma_new,
@@ -799,20 +1535,17 @@ static void lost_independent_borders(gamma_t *game, uint player_out, uint x, uin
  * @param[in] y        – numer wiersza, liczba nieujemna mniejsza od wartości
  *                      @p height z funkcji @ref gamma_new.
  * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
- * gdy gracz wykorzystał już swój złoty ruch, ruch jest nielegalny
- * lub któryś z parametrów jest niepoprawny.
+ * gdy ruch jest nielegalny. Nielegalny ruch nie zmienia licznika zmian.
  */
-bool gamma_golden_move(gamma_t *game, uint player, uint x, uint y)
+static bool golden_place(gamma_t *game, uint player, uint x, uint y)
 {
-    if (gamma_golden_possible_con(game, player) == false
-        || coords_are_fine(x, y, game) == false
-        || game->board[x][y] == EMPTY
-        || game->board[x][y] == player)
+    if (game->board[x][y] == EMPTY || game->board[x][y] == player)
         return false;
 
     uint player_out = game->board[x][y];
     uint index_out = game->indexes[x][y];
     uint new_index = game->players[player_out].next_ind;
+    muint epoch = game->epoch;
 
     for (uint i = 0; i < DIRECTIONS; ++i)
     {
@@ -823,6 +1556,7 @@ bool gamma_golden_move(gamma_t *game, uint player, uint x, uint y)
             if (game->board[x][y] == player_out)
             {
                 game->board[x][y] = EMPTY;
+                note_change(game, x, y, player_out);
                 update_blank_all_neighbours(game, x, y);
                 lost_independent_borders(game, player_out, x, y);
                 game->indexes[x][y] = EMPTY;
@@ -846,6 +1580,7 @@ bool gamma_golden_move(gamma_t *game, uint player, uint x, uint y)
     if (game->board[x][y] == player_out)
     {
         game->board[x][y] = EMPTY;
+        note_change(game, x, y, player_out);
         lost_independent_borders(game, player_out, x, y);
         update_blank_all_neighbours(game, x, y);
         game->indexes[x][y] = EMPTY;
@@ -858,12 +1593,13 @@ bool gamma_golden_move(gamma_t *game, uint player, uint x, uint y)
 
     if (game->max_areas < game->players[player_out].areas)
     {
-        gamma_move(game, player_out, x, y);
+        place(game, player_out, x, y);
+        forget_changes(game, epoch);
         return false;
     }
     else
     {
-        if (gamma_move(game, player, x, y))
+        if (place(game, player, x, y))
         {
             game->players[player].free_golden_move = false;
             game->golden_moves_used++;
@@ -871,141 +1607,1681 @@ bool gamma_golden_move(gamma_t *game, uint player, uint x, uint y)
         }
         else
         {
-            gamma_move(game, player_out, x, y);
+            place(game, player_out, x, y);
+            forget_changes(game, epoch);
             return false;
         }
     }
 }
 
-/** @brief Funkcja pomocznicza do przesuwania wyświetlanej treści.
- * Wypisuje na stdout @p margin spacji dzięki czemu następny stdout
- * jest przesunięty w prawo.
- * @param[in] margin – długośc przesunięcia, tj. liczba spacji,
-*/
-void push (uint margin)
+/** @brief Wykonuje złoty ruch.
+ * Ustawia pionek gracza @p player na polu (@p x, @p y) zajętym przez innego
+ * gracza, usuwając pionek innego gracza.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player   – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x        – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y        – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
+ * gdy gracz wykorzystał już swój złoty ruch, ruch jest nielegalny
+ * lub któryś z parametrów jest niepoprawny.
+ */
+bool gamma_golden_move(gamma_t *game, uint player, uint x, uint y)
 {
-    for (uint _ = 0; _ < margin; _++)
-        printf(" ");
+    if (gamma_golden_possible_con(game, player) == false
+        || coords_are_fine(x, y, game) == false
+        || golden_place(game, player, x, y) == false)
+        return false;
+
+    move m = {player, x, y};
+    note_move(game, &m, true);
+    return true;
 }
 
-/** @brief Wyświetla aktualny stan planszy.
- * Wypisuje do konsoli aktualny stan planszy z uzglednienie tego że na
- * polu (@p x, @p y) znajduje się aktualnie kursor.
- * Funkcja pomocnicza w @ref interactive_game.
- * @param[in] game   – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] cur_x  – numer kolumny, gdzie znajduje się kursor, liczba nieujemna
- *                      mniejsza od wartości @p width z funkcji @ref gamma_new,
- * @param[in] cur_y  – numer wiersza, gdzie znajduje się kursor, liczba nieujemna
- *                      mniejsza od wartości @p width z funkcji @ref gamma_new,
- * @param[in] player – identyfikator gracza, którego jest tura,
- * @param[in] margin – zmienna pomocnicza do środkowa planszy,
- *                      tj. odległość planszy od lewej ściany terminala.
- */
-void show_board(gamma_t *game, uint cur_x, uint cur_y, uint player, uint margin)
-{
-    uint cell_size = ceil_log(game->number_of_players)
-            + (WIDE < game->number_of_players);
-
-    printf("\n");
-    push(margin);
-    printf("╔");
-    for (uint i = 0; i < game->width * cell_size; i++)
-        printf("═");
-    printf("╗\n");
+/** @brief Wykonuje ciąg złotych ruchów.
+ * Wykonuje po kolei złote ruchy z tablicy @p moves, dając ten sam wynik co
+ * kolejne wywołania @ref gamma_golden_move. Poprawność @p game jest
+ * sprawdzana raz, a pola kolejnych ruchów są z wyprzedzeniem sprowadzane
+ * do pamięci podręcznej.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves    – tablica ruchów,
+ * @param[in] n        – liczba ruchów,
+ * @param[out] results – tablica na @p n wyników kolejnych ruchów lub NULL.
+ * @return Liczba wykonanych ruchów.
+ */
+size_t gamma_golden_move_batch(gamma_t *game, const move *moves, size_t n, bool *results)
+{
+    if (game == NULL)
+    {
+        for (size_t i = 0; results != NULL && i < n; ++i)
+            results[i] = false;
+        return 0;
+    }
 
-    for (uint x = 0; x < game->heigth; ++x)
+    size_t done = 0;
+    for (size_t i = 0; i < n; ++i)
     {
-        push(margin);
-        printf("║");
-        for (uint y = 0; y < game->width; ++y)
+        if (i + PREFETCH_DISTANCE < n)
+            prefetch_field(game, &moves[i + PREFETCH_DISTANCE]);
+
+        const move *m = &moves[i];
+        bool result = gamma_golden_possible_con(game, m->player)
+                      && coords_are_fine(m->x, m->y, game)
+                      && golden_place(game, m->player, m->x, m->y);
+        if (result)
+            note_move(game, m, true);
+        if (results != NULL)
+            results[i] = result;
+        done += result;
+    }
+
+    return done;
+}
+
+/** @brief Wyznacza reprezentanta obszaru zawierającego dane pole.
+ * Podczas przebudowy obszarów tablica @p indexes przechowuje dla każdego
+ * zajętego pola numer pola nadrzędnego powiększony o jeden, przy czym pole
+ * nadrzędne zawsze ma numer nie większy niż dane pole. Pole o numerze
+ * @p cell leży w kolumnie @p cell / @p heigth i wierszu @p cell % @p heigth.
+ * Po drodze skraca ścieżki, przepinając pola do ich dziadków.
+ * Funkcja pomocnicza w @ref rebuild_areas i @ref unite.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] cell     – numer pola.
+ * @return Numer reprezentanta obszaru.
+ */
+static muint find_root(gamma_t *game, muint cell)
+{
+    uint h = game->heigth;
+    muint parent = game->indexes[cell / h][cell % h] - 1;
+    while (parent != cell)
+    {
+        muint grandparent = game->indexes[parent / h][parent % h] - 1;
+        game->indexes[cell / h][cell % h] = grandparent + 1;
+        cell = parent;
+        parent = grandparent;
+    }
+    return cell;
+}
+
+/** @brief Przebudowuje obszary i liczniki graczy na podstawie planszy.
+ * W pierwszym przejściu po planszy łączy sąsiednie pola tego samego gracza
+ * w obszary, zapisując w @p indexes numery pól nadrzędnych. W drugim
+ * przejściu nadaje obszarom kolejne indeksy graczy, zlicza pola i obszary
+ * graczy oraz puste pola graniczące z polami każdego gracza. Nie alokuje
+ * pamięci i nie zmienia stanu złotych ruchów.
+ * Funkcja pomocnicza w @ref gamma_set_fields i @ref gamma_rebuild_areas.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void rebuild_areas(gamma_t *game)
+{
+    uint h = game->heigth;
+
+    game->over_checked = 0;
+    for (uint i = 1; i <= game->number_of_players; ++i)
+    {
+        game->players[i].golden_checked = 0;
+        game->players[i].fields = 0;
+        game->players[i].areas = 0;
+        game->players[i].next_ind = 1;
+        game->players[i].border = 0;
+    }
+    game->busy_fields = 0;
+    game->fields_of_wider_players = 0;
+
+    // Pole łączymy z lewym i dolnym sąsiadem, które zostały już odwiedzone,
+    // a mniejszego z reprezentantów czynimy reprezentantem całości.
+    for (uint x = 0; x < game->width; ++x)
+    {
+        for (uint y = 0; y < h; ++y)
         {
-            uint val = game->board[y][game->heigth - x - 1];
-            if (val == player)
+            uint owner = game->board[x][y];
+            muint cell = (muint) x * h + y;
+            if (owner == EMPTY)
             {
-                printf("\e[0;97m");
-                if (gamma_areas(game, player) < game->max_areas)
-                    printf("\e[42m");
-                else
-                    printf("\e[41m");
+                game->indexes[x][y] = EMPTY;
+                continue;
             }
 
-            if (game->heigth - x - 1 == cur_x && y == cur_y)
+            muint root = cell;
+            if (0 < x && game->board[x - 1][y] == owner)
+                root = find_root(game, cell - h);
+            if (0 < y && game->board[x][y - 1] == owner)
             {
-                printf("\e[0;97m");
-                printf("\x1b[44m");
-                if (val == EMPTY)
+                muint other = find_root(game, cell - 1);
+                if (other < root)
                 {
-                    for (uint i = 1; i < cell_size; ++i)
-                        printf(" ");
-                    printf(".");
+                    if (root != cell)
+                        game->indexes[root / h][root % h] = other + 1;
+                    root = other;
                 }
-                else
+                else if (root < other)
                 {
-                    for (uint i = ceil_log(val); i < cell_size; ++i)
-                        printf(" ");
-                    printf("%d", val);
+                    game->indexes[other / h][other % h] = root + 1;
                 }
-                printf("\x1b[0m");
             }
-            else if (val == EMPTY)
+            game->indexes[x][y] = root + 1;
+        }
+    }
+
+    // Pola nadrzędne mają mniejsze numery, więc w chwili odwiedzenia pola
+    // jego pole nadrzędne ma już nadany indeks obszaru.
+    for (uint x = 0; x < game->width; ++x)
+    {
+        for (uint y = 0; y < h; ++y)
+        {
+            uint owner = game->board[x][y];
+            if (owner == EMPTY)
+            {
+                update_blank_all_neighbours(game, x, y);
+                continue;
+            }
+
+            muint cell = (muint) x * h + y;
+            muint parent = game->indexes[x][y] - 1;
+            if (parent == cell)
             {
-                for (uint i = 1; i < cell_size; ++i)
-                    printf(" ");
-                printf(".");
+                game->indexes[x][y] = game->players[owner].next_ind++;
+                game->players[owner].areas++;
             }
             else
             {
-                for (uint i = ceil_log(val); i < cell_size; ++i)
-                    printf(" ");
-                printf("%d", val);
+                game->indexes[x][y] = game->indexes[parent / h][parent % h];
+            }
+
+            game->players[owner].fields++;
+            game->busy_fields++;
+            if (WIDE < owner)
+                game->fields_of_wider_players++;
+        }
+    }
+}
+
+/** @brief Zlicza graczy, z których polami graniczy puste pole.
+ * Zwiększa licznik @p border każdego gracza, którego pole sąsiaduje
+ * z polem (@p x, @p y), tak jak @ref update_blank_all_neighbours, ale
+ * w osobnej tablicy liczników.
+ * Funkcja pomocnicza w @ref label_strip.
+ * @param[in] game       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x          – numer kolumny pustego pola,
+ * @param[in] y          – numer wiersza pustego pola,
+ * @param[in,out] border – tablica liczników indeksowana numerami graczy.
+ */
+static void count_border(gamma_t *game, uint x, uint y, muint *border)
+{
+    uint neighbours[DIRECTIONS];
+
+    for (uint i = 0; i != DIRECTIONS; ++i)
+    {
+        uint _x = x + X[i];
+        uint _y = y + Y[i];
+        neighbours[i] = coords_are_fine(_x, _y, game) ? game->board[_x][_y] : EMPTY;
+    }
+
+    for (uint i = 0; i != DIRECTIONS; ++i)
+    {
+        uint current_neighbour = neighbours[i];
+        if (current_neighbour != EMPTY)
+        {
+            border[current_neighbour]++;
+            for (uint j = i; j < DIRECTIONS; ++j)
+                if (neighbours[j] == current_neighbour)
+                    neighbours[j] = EMPTY;
+        }
+    }
+}
+
+/** @brief Pas kolumn planszy przetwarzany przez jeden wątek.
+ * Liczniki i znaleziska są prowadzone osobno dla każdego pasa i łączone
+ * po zakończeniu pracy wątków, dzięki czemu wątki nie zapisują wspólnej
+ * pamięci.
+ */
+typedef struct strip
+{
+    gamma_t *game; ///< Wskaźnik na strukturę przechowującą stan gry.
+    uint from; ///< Pierwsza kolumna pasa.
+    uint to; ///< Kolumna za ostatnią kolumną pasa.
+    muint *fields; ///< Liczby pól graczy w pasie.
+    muint *areas; ///< Liczby obszarów graczy, których reprezentant leży w pasie.
+    muint *border; ///< Liczby pustych pól pasa graniczących z polami graczy.
+    const bool *wanted; ///< Gracze, dla których szukany jest złoty ruch.
+    bool *found; ///< Gracze, którym znaleziono w pasie złoty ruch.
+    bool *unsure; /**< Gracze, których kandydatów w pasie trzeba sprawdzić
+        przeszukaniem obszaru. */
+} strip;
+
+/** @brief Łączy obszary zawierające dwa pola o tym samym właścicielu.
+ * Reprezentantem połączonego obszaru zostaje mniejszy z reprezentantów.
+ * Funkcja pomocnicza w @ref label_strip i @ref gamma_rebuild_areas.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] a        – numer pierwszego pola,
+ * @param[in] b        – numer drugiego pola.
+ * @return Numer reprezentanta połączonego obszaru.
+ */
+static muint unite(gamma_t *game, muint a, muint b)
+{
+    uint h = game->heigth;
+    a = find_root(game, a);
+    b = find_root(game, b);
+    if (a < b)
+        game->indexes[b / h][b % h] = a + 1;
+    else if (b < a)
+        game->indexes[a / h][a % h] = b + 1;
+    return a < b ? a : b;
+}
+
+/** @brief Łączy pola pasa w obszary i zlicza pola graczy.
+ * Działa jak pierwsze przejście @ref rebuild_areas, ale łączy tylko pola
+ * leżące w pasie, po czym każde pole pasa wskazuje bezpośrednio na
+ * reprezentanta swojego obszaru w pasie. Zlicza też pola graczy i puste
+ * pola graniczące z ich polami.
+ * Funkcja pomocnicza w @ref gamma_rebuild_areas, wykonywana w osobnym wątku.
+ * @param[in,out] arg – wskaźnik na pas planszy.
+ * @return Wartość NULL.
+ */
+static void *label_strip(void *arg)
+{
+    strip *s = arg;
+    gamma_t *game = s->game;
+    uint h = game->heigth;
+
+    for (uint x = s->from; x < s->to; ++x)
+    {
+        for (uint y = 0; y < h; ++y)
+        {
+            uint owner = game->board[x][y];
+            muint cell = (muint) x * h + y;
+            if (owner == EMPTY)
+            {
+                game->indexes[x][y] = EMPTY;
+                count_border(game, x, y, s->border);
+                continue;
             }
 
-            printf("\033[0m");
+            s->fields[owner]++;
+            game->indexes[x][y] = cell + 1;
+            if (s->from < x && game->board[x - 1][y] == owner)
+                unite(game, cell - h, cell);
+            if (0 < y && game->board[x][y - 1] == owner)
+                unite(game, cell - 1, cell);
         }
-        printf("║\n");
     }
 
-    push(margin);
-    printf("╚");
-    for (uint i = 0; i < game->width * cell_size; i++)
-        printf("═");
-    printf("╝\n");
+    // Pole nadrzędne ma mniejszy numer, więc wskazuje już na reprezentanta.
+    for (uint x = s->from; x < s->to; ++x)
+    {
+        for (uint y = 0; y < h; ++y)
+        {
+            muint parent = game->indexes[x][y];
+            if (parent != EMPTY)
+                game->indexes[x][y] = game->indexes[(parent - 1) / h][(parent - 1) % h];
+        }
+    }
+    return NULL;
 }
 
-/** @brief Zwraca liczbę wszystkich zajętych pól na planszy.
- * Funkcja pomocnicza w @ref interactive_game.
- * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
- * @return Liczba zajętych pól.
+/** @brief Nadaje polom pasa indeksy obszarów.
+ * Indeksem obszaru jest numer jego reprezentanta na całej planszy
+ * powiększony o jeden. Odczytuje wyłącznie pola własnego pasa.
+ * Funkcja pomocnicza w @ref gamma_rebuild_areas, wykonywana w osobnym wątku.
+ * @param[in,out] arg – wskaźnik na pas planszy.
+ * @return Wartość NULL.
  */
-muint gamma_all_busy_fields(gamma_t *game)
+static void *finish_strip(void *arg)
 {
-    return game->busy_fields;
+    strip *s = arg;
+    gamma_t *game = s->game;
+    uint h = game->heigth;
+    muint first = (muint) s->from * h;
+
+    for (uint x = s->from; x < s->to; ++x)
+    {
+        for (uint y = 0; y < h; ++y)
+        {
+            muint parent = game->indexes[x][y];
+            if (parent == EMPTY)
+                continue;
+
+            // Pola przy granicy pasa wskazują już na reprezentanta
+            // obszaru na całej planszy, również spoza pasa.
+            if (first < parent)
+                game->indexes[x][y] = game->indexes[(parent - 1) / h][(parent - 1) % h];
+            if (game->indexes[x][y] == (muint) x * h + y + 1)
+                s->areas[game->board[x][y]]++;
+        }
+    }
+    return NULL;
 }
 
-/** @brief Zwraca liczbę wszystkich obszarów gracza @p player.
- * Funkcja pomocnicza w @ref interactive_game.
- * @param[in] game   – wskaźnik na strukturę przechowującą stan gry.
- * @param[in] player – identyfikator gracza.
- * @return Liczba obszarów danego gracza.
+/** @brief Wyznacza liczbę pasów, na które jest dzielona plansza.
+ * Funkcja pomocnicza w @ref gamma_rebuild_areas
+ * i @ref gamma_golden_possible_all.
+ * @param[in] game    – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] threads – żądana liczba wątków, liczba dodatnia.
+ * @return Liczba @p threads ograniczona przez szerokość planszy
+ * i @ref MAX_THREADS.
  */
-uint gamma_areas(gamma_t *game, uint player)
+static uint strip_count(const gamma_t *game, uint threads)
 {
-    return game->players[player].areas;
+    uint count = threads < game->width ? threads : game->width;
+    return count < MAX_THREADS ? count : MAX_THREADS;
 }
 
-/** @brief Zwraca liczbe pól zajętych przez gracza, który zajął
- * ich najwięcej.
- * Funkcja pomocnicza w @ref interactive_game.
- * @param[in] game   – wskaźnik na strukturę przechowującą stan gry.
- * @return Liczba pól tego gracza.
+/** @brief Wykonuje funkcję dla każdego pasa w osobnym wątku.
+ * Pasy, dla których nie udało się utworzyć wątku, są przetwarzane
+ * przez wątek wywołujący, a gdy zabraknie pamięci na tablice wątków,
+ * wszystkie pasy są przetwarzane sekwencyjnie.
+ * Funkcja pomocnicza w @ref gamma_rebuild_areas
+ * i @ref gamma_golden_possible_all.
+ * @param[in,out] strips – tablica pasów,
+ * @param[in] count      – liczba pasów, co najwyżej @ref MAX_THREADS,
+ * @param[in] work       – funkcja przetwarzająca pas.
  */
-uint gamma_best_result(gamma_t *game)
+static void run_strips(strip *strips, uint count, void *(*work)(void *))
 {
-    uint result = 0;
-    for (uint i = 1; i <= game->number_of_players; ++i)
+    pthread_t *threads = malloc(count * sizeof(pthread_t));
+    bool *started = calloc(count, sizeof(bool));
+
+    for (uint i = 1; i < count && threads != NULL && started != NULL; ++i)
+        started[i] = pthread_create(&threads[i], NULL, work, &strips[i]) == 0;
+    work(&strips[0]);
+    for (uint i = 1; i < count; ++i)
     {
-        if (result < game->players[i].fields)
-            result = game->players[i].fields;
+        if (started != NULL && started[i])
+            pthread_join(threads[i], NULL);
+        else
+            work(&strips[i]);
     }
-    return result;
+
+    free(threads);
+    free(started);
+}
+
+/** @brief Przebudowuje obszary i liczniki graczy na podstawie planszy.
+ * Plansza jest dzielona na @p threads pasów kolumn. Wątki niezależnie łączą
+ * pola swoich pasów w obszary, następnie wątek wywołujący łączy obszary
+ * przecinające granice pasów, a na końcu wątki nadają polom indeksy obszarów.
+ * Liczby pól, obszarów i pustych pól graniczących z polami graczy są
+ * wyznaczane od nowa, a stan złotych ruchów się nie zmienia. Dla jednego
+ * wątku lub gdy nie uda się zaalokować pamięci na liczniki pasów, obszary
+ * są przebudowywane sekwencyjnie.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] threads  – liczba wątków, liczba dodatnia, ograniczana
+ *                       do szerokości planszy i 256.
+ * @return Wartość @p true, jeśli obszary zostały przebudowane, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny.
+ */
+bool gamma_rebuild_areas(gamma_t *game, uint threads)
+{
+    if (game == NULL || threads == 0)
+        return false;
+
+    uint count = strip_count(game, threads);
+    muint players = (muint) game->number_of_players + 1;
+    strip *strips = malloc(count * sizeof(strip));
+    muint *counters = count < 2 || strips == NULL ? NULL
+                      : calloc(3 * count * players, sizeof(muint));
+    if (counters == NULL)
+    {
+        free(strips);
+        rebuild_areas(game);
+        return true;
+    }
+
+    for (uint i = 0; i < count; ++i)
+    {
+        strips[i].game = game;
+        strips[i].from = (muint) game->width * i / count;
+        strips[i].to = (muint) game->width * (i + 1) / count;
+        strips[i].fields = counters + 3 * i * players;
+        strips[i].areas = strips[i].fields + players;
+        strips[i].border = strips[i].areas + players;
+    }
+    run_strips(strips, count, label_strip);
+
+    // Łączenie obszarów na granicach pasów. Łączeni są reprezentanci
+    // w pasach, więc pola graniczne nadal wskazują na swoich reprezentantów.
+    uint h = game->heigth;
+    for (uint i = 1; i < count; ++i)
+    {
+        uint x = strips[i].from;
+        for (uint y = 0; y < h; ++y)
+        {
+            if (game->board[x][y] != EMPTY && game->board[x - 1][y] == game->board[x][y])
+                unite(game, game->indexes[x - 1][y] - 1, game->indexes[x][y] - 1);
+        }
+    }
+
+    // Skierowanie pól granicznych i ich reprezentantów w pasach
+    // na reprezentantów całych obszarów.
+    for (uint i = 1; i < count; ++i)
+    {
+        for (uint x = strips[i].from - 1; x <= strips[i].from; ++x)
+        {
+            for (uint y = 0; y < h; ++y)
+            {
+                if (game->board[x][y] == EMPTY)
+                    continue;
+                muint local = game->indexes[x][y] - 1;
+                muint root = find_root(game, local);
+                game->indexes[local / h][local % h] = root + 1;
+                game->indexes[x][y] = root + 1;
+            }
+        }
+    }
+    run_strips(strips, count, finish_strip);
+
+    // Indeksy obszarów są numerami pól, więc kolejne obszary
+    // dostaną indeksy większe od numeru każdego pola.
+    game->busy_fields = 0;
+    game->fields_of_wider_players = 0;
+    game->over_checked = 0;
+    for (uint p = 1; p <= game->number_of_players; ++p)
+    {
+        game->players[p].golden_checked = 0;
+        game->players[p].fields = 0;
+        game->players[p].areas = 0;
+        game->players[p].border = 0;
+        game->players[p].next_ind = (muint) game->width * h + 1;
+        for (uint i = 0; i < count; ++i)
+        {
+            game->players[p].fields += strips[i].fields[p];
+            game->players[p].areas += strips[i].areas[p];
+            game->players[p].border += strips[i].border[p];
+        }
+        game->busy_fields += game->players[p].fields;
+        if (WIDE < p)
+            game->fields_of_wider_players += game->players[p].fields;
+    }
+
+    free(counters);
+    free(strips);
+    return true;
+}
+
+/** @brief Szuka w pasie złotych ruchów, które da się potwierdzić bez
+ * przeszukiwania obszarów.
+ * Tylko czyta stan gry. Gracz, którego kandydat wymaga przeszukania obszaru,
+ * jest oznaczany w tablicy @p unsure pasa.
+ * Funkcja pomocnicza w @ref gamma_golden_possible_all, wykonywana
+ * w osobnym wątku.
+ * @param[in,out] arg – wskaźnik na pas planszy.
+ * @return Wartość NULL.
+ */
+static void *golden_strip(void *arg)
+{
+    strip *s = arg;
+    gamma_t *game = s->game;
+
+    for (uint x = s->from; x < s->to; ++x)
+    {
+        for (uint y = 0; y < game->heigth; ++y)
+        {
+            uint owner = game->board[x][y];
+            if (owner == EMPTY)
+                continue;
+
+            int fine = -1;
+            for (int i = 0; i < DIRECTIONS; ++i)
+            {
+                uint _x = x + X[i];
+                uint _y = y + Y[i];
+                if (coords_are_fine(_x, _y, game) == false)
+                    continue;
+                uint p = game->board[_x][_y];
+                if (p == EMPTY || p == owner || s->wanted[p] == false || s->found[p])
+                    continue;
+
+                if (fine == -1)
+                    fine = surely_releasable(game, x, y);
+                if (fine == 1)
+                    s->found[p] = true;
+                else
+                    s->unsure[p] = true;
+            }
+        }
+    }
+    return NULL;
+}
+
+/** @brief Sprawdza, którzy gracze mogą wykonać złoty ruch.
+ * Odpowiada dla wszystkich graczy naraz. Gracze, dla których trzeba
+ * przeszukać planszę, są obsługiwani w jednym wspólnym przejściu, w którym
+ * każde pole jest sprawdzane raz. Przy więcej niż jednym wątku plansza jest
+ * dzielona na pasy kolumn, a wątki potwierdzają złote ruchy, których
+ * sprawdzenie nie wymaga przeszukiwania obszarów; pozostałych kandydatów
+ * sprawdza wątek wywołujący. Wyniki są zapamiętywane tak jak w
+ * @ref gamma_golden_possible.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] out     – tablica co najmniej @p players + 1 wartości, w której
+ *                       pod indeksem @p i zostanie zapisana odpowiedź
+ *                       @ref gamma_golden_possible dla gracza @p i,
+ *                       a pod indeksem zero wartość @p false,
+ * @param[in] threads  – liczba wątków, liczba dodatnia, ograniczana
+ *                       do szerokości planszy i 256.
+ * @return Wartość @p true, jeśli odpowiedzi zostały zapisane, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny lub zabrakło pamięci.
+ */
+bool gamma_golden_possible_all(gamma_t *game, bool *out, uint threads)
+{
+    if (game == NULL || out == NULL || threads == 0)
+        return false;
+
+    muint players = (muint) game->number_of_players + 1;
+    bool *wanted = calloc(players, sizeof(bool));
+    if (wanted == NULL)
+        return false;
+
+    // Odpowiedzi niewymagające przeszukania planszy.
+    uint remaining = 0;
+    out[0] = false;
+    for (uint p = 1; p < players; ++p)
+    {
+        player *pl = &game->players[p];
+        if (gamma_golden_possible_con(game, p) == false)
+            out[p] = false;
+        else if (pl->areas < game->max_areas)
+            out[p] = true;
+        else if (pl->golden_checked == game->epoch + 1)
+            out[p] = pl->golden;
+        else
+        {
+            wanted[p] = true;
+            remaining++;
+        }
+    }
+
+    uint count = strip_count(game, threads);
+    strip *strips = remaining == 0 || count < 2 ? NULL : malloc(count * sizeof(strip));
+    bool *flags = strips == NULL ? NULL : calloc(2 * count * players, sizeof(bool));
+    if (flags != NULL)
+    {
+        for (uint i = 0; i < count; ++i)
+        {
+            strips[i].game = game;
+            strips[i].from = (muint) game->width * i / count;
+            strips[i].to = (muint) game->width * (i + 1) / count;
+            strips[i].wanted = wanted;
+            strips[i].found = flags + 2 * i * players;
+            strips[i].unsure = strips[i].found + players;
+        }
+        run_strips(strips, count, golden_strip);
+
+        // Przeszukania obszarów wymagają tylko gracze, którym nie
+        // potwierdzono żadnego kandydata, a któryś był niepewny.
+        remaining = 0;
+        for (uint p = 1; p < players; ++p)
+        {
+            if (wanted[p] == false)
+                continue;
+            bool found = false, unsure = false;
+            for (uint i = 0; i < count; ++i)
+            {
+                found = found || strips[i].found[p];
+                unsure = unsure || strips[i].unsure[p];
+            }
+            if (found || unsure == false)
+            {
+                out[p] = found;
+                game->players[p].golden = found;
+                game->players[p].golden_checked = game->epoch + 1;
+                wanted[p] = false;
+            }
+            else
+            {
+                remaining++;
+            }
+        }
+    }
+    free(flags);
+    free(strips);
+
+    if (remaining > 0)
+        golden_pass(game, wanted, remaining, out);
+    free(wanted);
+    return true;
+}
+
+/** @brief Zapisuje właścicieli pól bez ich przebudowy.
+ * Każda zmiana właściciela jest odnotowywana w dzienniku zmian.
+ * Funkcja pomocnicza w @ref gamma_set_fields.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x        – numer kolumny pola,
+ * @param[in] y        – numer wiersza pola,
+ * @param[in] owner    – nowy właściciel pola, zero oznacza pole puste.
+ */
+static inline void set_owner(gamma_t *game, uint x, uint y, uint owner)
+{
+    if (game->board[x][y] != owner)
+    {
+        note_change(game, x, y, game->board[x][y]);
+        game->board[x][y] = owner;
+    }
+}
+
+/** @brief Ustawia właścicieli wielu pól naraz.
+ * Zapisuje po kolei właścicieli pól z tablicy @p fields bezpośrednio na
+ * planszy, a następnie w jednym przejściu po planszy przebudowuje obszary,
+ * liczby pól i obszarów graczy oraz liczby pustych pól graniczących z ich
+ * polami. Stan złotych ruchów się nie zmienia. Jeśli w otrzymanej pozycji
+ * któryś z graczy miałby więcej obszarów niż dozwolono, plansza wraca do
+ * poprzedniego stanu i historia gry pozostaje nietknięta. Pozycji ustawionej
+ * w ten sposób nie da się odtworzyć z ruchów, dlatego po jej ustawieniu
+ * historia gry jest porzucana. Pusta tablica rekordów niczego nie zmienia.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] fields   – tablica rekordów (x, y, właściciel), gdzie właściciel
+ *                       równy zero oznacza pole puste,
+ * @param[in] n        – liczba rekordów.
+ * @return Wartość @p true, jeśli pozycja została ustawiona, a @p false,
+ * gdy któryś z rekordów jest niepoprawny, pozycja jest niedozwolona
+ * lub nie udało się zaalokować pamięci.
+ */
+bool gamma_set_fields(gamma_t *game, const field_change *fields, size_t n)
+{
+    if (game == NULL)
+        return false;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (coords_are_fine(fields[i].x, fields[i].y, game) == false
+            || game->number_of_players < fields[i].owner)
+            return false;
+    }
+
+    if (n == 0)
+        return true;
+
+    uint *previous = calloc(n, sizeof(uint));
+    if (previous == NULL)
+        return false;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        previous[i] = game->board[fields[i].x][fields[i].y];
+        set_owner(game, fields[i].x, fields[i].y, fields[i].owner);
+    }
+    rebuild_areas(game);
+
+    bool allowed = true;
+    for (uint i = 1; i <= game->number_of_players; ++i)
+    {
+        if (game->max_areas < game->players[i].areas)
+            allowed = false;
+    }
+
+    // Przywrócenie poprzednich właścicieli w odwrotnej kolejności.
+    if (allowed == false)
+    {
+        for (size_t i = n; i > 0; --i)
+            set_owner(game, fields[i - 1].x, fields[i - 1].y, previous[i - 1]);
+        rebuild_areas(game);
+    }
+    else
+    {
+        free_history(game->history);
+        game->history = NULL;
+    }
+
+    free(previous);
+    return allowed;
+}
+
+/** @brief Zwraca liczbę wszystkich zajętych pól na planszy.
+ * Funkcja pomocnicza w @ref interactive_game.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba zajętych pól.
+ */
+muint gamma_all_busy_fields(gamma_t *game)
+{
+    return game->busy_fields;
+}
+
+/** @brief Zwraca właściciela pola (@p x, @p y).
+ * Funkcja pomocnicza w @ref interactive_game.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x    – numer kolumny pola,
+ * @param[in] y    – numer wiersza pola.
+ * @return Numer gracza zajmującego pole lub zero, jeśli pole jest puste,
+ * poza planszą lub @p game ma wartość NULL.
+ */
+uint gamma_owner(gamma_t *game, uint x, uint y)
+{
+    return game != NULL && coords_are_fine(x, y, game) ? game->board[x][y] : EMPTY;
+}
+
+/** @brief Zwraca liczbę wszystkich obszarów gracza @p player.
+ * Funkcja pomocnicza w @ref interactive_game.
+ * @param[in] game   – wskaźnik na strukturę przechowującą stan gry.
+ * @param[in] player – identyfikator gracza.
+ * @return Liczba obszarów danego gracza.
+ */
+uint gamma_areas(gamma_t *game, uint player)
+{
+    return game->players[player].areas;
+}
+
+/** @brief Zwraca liczbe pól zajętych przez gracza, który zajął
+ * ich najwięcej.
+ * Funkcja pomocnicza w @ref interactive_game.
+ * @param[in] game   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba pól tego gracza.
+ */
+uint gamma_best_result(gamma_t *game)
+{
+    uint result = 0;
+    for (uint i = 1; i <= game->number_of_players; ++i)
+    {
+        if (result < game->players[i].fields)
+            result = game->players[i].fields;
+    }
+    return result;
+}
+
+/** @brief Zwraca aktualną wartość licznika zmian planszy.
+ * Od momentu wywołania tej funkcji silnik prowadzi dziennik zmian,
+ * dzięki czemu zwrócona wartość może zostać później przekazana
+ * do @ref gamma_changes.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba dotychczasowych zmian właścicieli pól lub zero,
+ * jeśli @p game ma wartość NULL.
+ */
+muint gamma_epoch(gamma_t *game)
+{
+    if (game == NULL)
+        return 0;
+
+    if (game->changes_tracked == false)
+    {
+        game->changes_tracked = true;
+        game->changes_start = game->epoch;
+    }
+    return game->epoch;
+}
+
+/** @brief Podaje liczbę dotychczasowych zmian właścicieli pól.
+ * W odróżnieniu od @ref gamma_epoch nie włącza prowadzenia dziennika zmian.
+ * Nieudane ruchy, także złote, nie zmieniają tej liczby, więc ponowne
+ * wykonanie tych samych udanych ruchów daje tę samą wartość.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba dotychczasowych zmian właścicieli pól lub zero,
+ * jeśli @p game ma wartość NULL.
+ */
+muint gamma_change_count(gamma_t *game)
+{
+    return game == NULL ? 0 : game->epoch;
+}
+
+/** @brief Wpis dziennika zmian wraz z jego położeniem w dzienniku.
+ * Wykorzystywany przy porządkowaniu wpisów w @ref gamma_changes.
+ */
+typedef struct change_ref
+{
+    uint x; ///< Numer kolumny pola.
+    uint y; ///< Numer wiersza pola.
+    muint order; ///< Numer wpisu w dzienniku zmian.
+} change_ref;
+
+/** @brief Porównuje dwa wpisy dziennika zmian.
+ * Wpisy są porządkowane według numeru kolumny, numeru wiersza,
+ * a na końcu według kolejności ich dopisania do dziennika.
+ * Funkcja pomocnicza w @ref gamma_changes, przekazywana do @ref qsort.
+ * @param[in] a – wskaźnik na pierwszy wpis,
+ * @param[in] b – wskaźnik na drugi wpis,
+ * @return Liczba ujemna, zero lub liczba dodatnia, gdy pierwszy wpis jest
+ * odpowiednio mniejszy, równy lub większy od drugiego.
+ */
+static int compare_changes(const void *a, const void *b)
+{
+    const change_ref *A = a;
+    const change_ref *B = b;
+    if (A->x != B->x)
+        return A->x < B->x ? -1 : 1;
+    if (A->y != B->y)
+        return A->y < B->y ? -1 : 1;
+    if (A->order != B->order)
+        return A->order < B->order ? -1 : 1;
+    return 0;
+}
+
+/** @brief Zwraca wszystkie zajęte pola planszy.
+ * Odpowiada na zapytanie o zmiany od początku gry, kiedy plansza była pusta.
+ * Funkcja pomocnicza w @ref gamma_changes.
+ * @param[in] game   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] count – wskaźnik na liczbę zwróconych pól.
+ * @return Wskaźnik na zaalokowaną tablicę pól lub NULL,
+ * jeśli nie udało się zaalokować pamięci.
+ */
+static field_change *occupied_fields(gamma_t *game, muint *count)
+{
+    field_change *result = malloc((game->busy_fields + 1) * sizeof(field_change));
+    if (result == NULL)
+        return NULL;
+
+    muint pos = 0;
+    for (uint x = 0; x < game->width; ++x)
+    {
+        for (uint y = 0; y < game->heigth; ++y)
+        {
+            if (game->board[x][y] != EMPTY)
+            {
+                result[pos].x = x;
+                result[pos].y = y;
+                result[pos].owner = game->board[x][y];
+                pos++;
+            }
+        }
+    }
+    *count = pos;
+    return result;
+}
+
+/** @brief Podaje pola, których właściciel zmienił się od danego momentu.
+ * Alokuje tablicę rekordów (x, y, właściciel) opisujących pola, których
+ * właściciel jest inny niż w chwili, gdy licznik zmian planszy miał wartość
+ * @p epoch. Właściciel w rekordzie jest aktualnym właścicielem pola,
+ * a zero oznacza pole puste. Rekordy są uporządkowane według numeru kolumny,
+ * a następnie numeru wiersza. Funkcja wywołująca musi zwolnić tę tablicę.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] epoch    – wartość licznika zwrócona wcześniej przez
+ *                       @ref gamma_epoch, lub zero oznaczające początek gry,
+ * @param[out] count   – wskaźnik na liczbę zwróconych rekordów.
+ * @return Wskaźnik na zaalokowaną tablicę rekordów lub NULL, jeśli nie udało
+ * się zaalokować pamięci, któryś z parametrów jest niepoprawny lub
+ * dziennik zmian nie sięga już wartości @p epoch. Dziennik przechowuje
+ * co najmniej ostatnie pół miliona zmian, starsze wpisy są usuwane.
+ */
+field_change *gamma_changes(gamma_t *game, muint epoch, muint *count)
+{
+    if (game == NULL || count == NULL)
+        return NULL;
+
+    gamma_epoch(game);
+    if (epoch == 0)
+        return occupied_fields(game, count);
+    if (epoch < game->changes_start || game->epoch < epoch)
+        return NULL;
+
+    muint first = epoch - game->changes_start;
+    muint len = game->changes_len - first;
+    change_ref *refs = malloc((len + 1) * sizeof(change_ref));
+    field_change *result = malloc((len + 1) * sizeof(field_change));
+    if (refs == NULL || result == NULL)
+    {
+        free(refs);
+        free(result);
+        return NULL;
+    }
+
+    // Sortowanie wymaga jednoznacznej kolejności wpisów tego samego pola,
+    // więc wpisy są porządkowane razem ze swoimi numerami w dzienniku.
+    for (muint i = 0; i < len; ++i)
+    {
+        refs[i].x = game->changes[first + i].x;
+        refs[i].y = game->changes[first + i].y;
+        refs[i].order = first + i;
+    }
+    qsort(refs, len, sizeof(change_ref), compare_changes);
+
+    // Z każdej grupy wpisów tego samego pola zostaje ten najwcześniejszy,
+    // który przechowuje właściciela pola sprzed wszystkich zmian.
+    muint pos = 0;
+    for (muint i = 0; i < len; ++i)
+    {
+        if (i > 0 && refs[i].x == refs[i - 1].x && refs[i].y == refs[i - 1].y)
+            continue;
+
+        uint x = refs[i].x;
+        uint y = refs[i].y;
+        if (game->changes[refs[i].order].owner != game->board[x][y])
+        {
+            result[pos].x = x;
+            result[pos].y = y;
+            result[pos].owner = game->board[x][y];
+            pos++;
+        }
+    }
+    free(refs);
+    *count = pos;
+    return result;
+}
+
+/** @brief Bufor zapisu migawki stanu gry.
+ * Małe porcje danych są gromadzone w buforze, a duże kolumny planszy
+ * trafiają do pliku bezpośrednio, bez kopiowania.
+ */
+typedef struct snapshot_file
+{
+    int fd; ///< Deskryptor pliku migawki.
+    unsigned char *buffer; ///< Bufor na dane.
+    size_t len; ///< Liczba bajtów danych w buforze.
+    size_t pos; ///< Pozycja pierwszego nieodczytanego bajtu w buforze.
+    bool ok; ///< Czy wszystkie dotychczasowe operacje się powiodły.
+} snapshot_file;
+
+/** @brief Zapisuje do pliku cały blok danych.
+ * Ponawia wywołanie @ref write po przerwaniu przez sygnał
+ * i po częściowym zapisie.
+ * Funkcja pomocnicza w @ref snapshot_flush i @ref snapshot_put.
+ * @param[in] fd   – deskryptor pliku,
+ * @param[in] data – wskaźnik na zapisywane dane,
+ * @param[in] n    – liczba bajtów do zapisania.
+ * @return Wartość @p true, jeśli zapisano wszystkie dane,
+ * a @p false w przeciwnym razie.
+ */
+static bool write_full(int fd, const unsigned char *data, size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t written = write(fd, data, n < SNAPSHOT_CHUNK ? n : SNAPSHOT_CHUNK);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data += written;
+        n -= written;
+    }
+    return true;
+}
+
+/** @brief Wczytuje z pliku cały blok danych.
+ * Ponawia wywołanie @ref read po przerwaniu przez sygnał
+ * i po częściowym odczycie.
+ * Funkcja pomocnicza w @ref snapshot_get.
+ * @param[in] fd    – deskryptor pliku,
+ * @param[out] data – wskaźnik na miejsce na wczytane dane,
+ * @param[in] n     – liczba bajtów do wczytania.
+ * @return Liczba wczytanych bajtów, mniejsza od @p n tylko na końcu pliku
+ * lub po błędzie odczytu.
+ */
+static size_t read_full(int fd, unsigned char *data, size_t n)
+{
+    size_t done = 0;
+    while (done < n)
+    {
+        size_t left = n - done;
+        ssize_t got = read(fd, data + done, left < SNAPSHOT_CHUNK ? left : SNAPSHOT_CHUNK);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            break;
+        done += got;
+    }
+    return done;
+}
+
+/** @brief Zapisuje do pliku zawartość bufora migawki.
+ * Funkcja pomocnicza w @ref snapshot_put i @ref gamma_save.
+ * @param[in,out] out – wskaźnik na bufor zapisu.
+ */
+static void snapshot_flush(snapshot_file *out)
+{
+    if (out->ok && out->len > 0)
+        out->ok = write_full(out->fd, out->buffer, out->len);
+    out->len = 0;
+}
+
+/** @brief Dopisuje dane do migawki.
+ * Bloki nie mniejsze od bufora są zapisywane bezpośrednio.
+ * Funkcja pomocnicza w @ref gamma_save.
+ * @param[in,out] out – wskaźnik na bufor zapisu,
+ * @param[in] data    – wskaźnik na zapisywane dane,
+ * @param[in] n       – liczba bajtów do zapisania.
+ */
+static void snapshot_put(snapshot_file *out, const void *data, size_t n)
+{
+    if (SNAPSHOT_BUFFER_SIZE - out->len < n)
+        snapshot_flush(out);
+    if (n >= SNAPSHOT_BUFFER_SIZE)
+    {
+        if (out->ok)
+            out->ok = write_full(out->fd, data, n);
+        return;
+    }
+    memcpy(out->buffer + out->len, data, n);
+    out->len += n;
+}
+
+/** @brief Wczytuje dane z migawki.
+ * Bloki nie mniejsze od bufora są wczytywane bezpośrednio do @p data.
+ * Funkcja pomocnicza w @ref gamma_load.
+ * @param[in,out] in – wskaźnik na bufor odczytu,
+ * @param[out] data  – wskaźnik na miejsce na wczytane dane,
+ * @param[in] n      – liczba bajtów do wczytania.
+ */
+static void snapshot_get(snapshot_file *in, void *data, size_t n)
+{
+    unsigned char *dest = data;
+    size_t buffered = in->len - in->pos;
+    size_t now = buffered < n ? buffered : n;
+    memcpy(dest, in->buffer + in->pos, now);
+    in->pos += now;
+    dest += now;
+    n -= now;
+    if (n == 0 || in->ok == false)
+        return;
+
+    if (n >= SNAPSHOT_BUFFER_SIZE)
+    {
+        in->ok = read_full(in->fd, dest, n) == n;
+        return;
+    }
+    in->len = read_full(in->fd, in->buffer, SNAPSHOT_BUFFER_SIZE);
+    in->pos = 0;
+    if (in->len < n)
+    {
+        in->ok = false;
+        return;
+    }
+    memcpy(dest, in->buffer, n);
+    in->pos = n;
+}
+
+/** @brief Zapisuje liczbę 32-bitową w kolejności little-endian.
+ * Funkcja pomocnicza w @ref gamma_save.
+ * @param[out] p    – wskaźnik na miejsce na 4 bajty,
+ * @param[in] value – zapisywana liczba.
+ */
+static void put_u32(unsigned char *p, uint value)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = (unsigned char) (value >> (8 * i));
+}
+
+/** @brief Zapisuje liczbę 64-bitową w kolejności little-endian.
+ * Funkcja pomocnicza w @ref gamma_save.
+ * @param[out] p    – wskaźnik na miejsce na 8 bajtów,
+ * @param[in] value – zapisywana liczba.
+ */
+static void put_u64(unsigned char *p, muint value)
+{
+    for (int i = 0; i < 8; ++i)
+        p[i] = (unsigned char) (value >> (8 * i));
+}
+
+/** @brief Odczytuje liczbę 32-bitową zapisaną przez @ref put_u32.
+ * Funkcja pomocnicza w @ref gamma_load.
+ * @param[in] p – wskaźnik na 4 bajty.
+ * @return Odczytana liczba.
+ */
+static uint get_u32(const unsigned char *p)
+{
+    uint value = 0;
+    for (int i = 3; i >= 0; --i)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+/** @brief Odczytuje liczbę 64-bitową zapisaną przez @ref put_u64.
+ * Funkcja pomocnicza w @ref gamma_load.
+ * @param[in] p – wskaźnik na 8 bajtów.
+ * @return Odczytana liczba.
+ */
+static muint get_u64(const unsigned char *p)
+{
+    muint value = 0;
+    for (int i = 7; i >= 0; --i)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+/** @brief Wyznacza położenie planszy i tablicy indeksów w migawce.
+ * Obie tablice zaczynają się od przesunięć będących wielokrotnością
+ * @ref SNAPSHOT_ALIGN, a kolumny każdej z nich leżą w pliku jedna
+ * za drugą.
+ * Funkcja pomocnicza w @ref gamma_save, @ref gamma_load i @ref gamma_map.
+ * @param[in] width    – szerokość planszy,
+ * @param[in] height   – wysokość planszy,
+ * @param[in] players  – liczba graczy,
+ * @param[out] board   – przesunięcie początku planszy w pliku,
+ * @param[out] indexes – przesunięcie początku tablicy indeksów w pliku,
+ * @param[out] size    – rozmiar całego pliku migawki w bajtach.
+ * @return Wartość @p true, jeśli rozmiar pliku mieści się w typie @p size_t,
+ * a @p false, gdy wymiary planszy są na to zbyt duże.
+ */
+static bool snapshot_layout(uint width, uint height, uint players,
+                            muint *board, muint *indexes, muint *size)
+{
+    muint cells = (muint) width * height;
+    muint align = SNAPSHOT_ALIGN;
+    muint limit = SIZE_MAX;
+    muint records = SNAPSHOT_HEADER_SIZE + (muint) players * SNAPSHOT_PLAYER_SIZE;
+    *board = (records + align - 1) / align * align;
+
+    // Sprawdzenie przed mnożeniem, aby rozmiar tablic nie przekręcił licznika.
+    if (limit - 2 * align < *board
+        || (limit - 2 * align - *board) / (sizeof(uint) + sizeof(muint)) < cells)
+        return false;
+
+    *indexes = (*board + cells * sizeof(uint) + align - 1) / align * align;
+    *size = *indexes + cells * sizeof(muint);
+    return true;
+}
+
+/** @brief Zapisuje pełny stan gry do pliku.
+ * Migawka zawiera nagłówek z wersją formatu, liczbami opisującymi grę
+ * i przesunięciami obu tablic w pliku, rekordy graczy, a następnie
+ * wyrównane do granicy strony płaskie tablice z kolejnymi kolumnami planszy
+ * i tablicy indeksów obszarów. Tablice są zapisywane w kolejności bajtów
+ * komputera, a jej znacznik trafia do nagłówka, dzięki czemu plik może być
+ * używany bezpośrednio jako plansza przez @ref gamma_map. Dane są najpierw zapisywane do pliku
+ * tymczasowego, który po zsynchronizowaniu z dyskiem zastępuje @p path,
+ * więc przerwany zapis nie niszczy poprzedniej migawki. Dziennik zmian
+ * nie jest zapisywany.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] path – ścieżka do pliku migawki.
+ * @return Wartość @p true, jeśli migawka została zapisana, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny lub zapis się nie powiódł.
+ */
+bool gamma_save(gamma_t *game, const char *path)
+{
+    if (game == NULL || path == NULL)
+        return false;
+
+    size_t path_len = strlen(path);
+    char *temporary = malloc(path_len + sizeof(SNAPSHOT_SUFFIX));
+    snapshot_file out = {-1, malloc(SNAPSHOT_BUFFER_SIZE), 0, 0, true};
+    if (temporary == NULL || out.buffer == NULL)
+    {
+        free(temporary);
+        free(out.buffer);
+        return false;
+    }
+    memcpy(temporary, path, path_len);
+    memcpy(temporary + path_len, SNAPSHOT_SUFFIX, sizeof(SNAPSHOT_SUFFIX));
+
+    out.fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out.fd < 0)
+    {
+        free(temporary);
+        free(out.buffer);
+        return false;
+    }
+
+    unsigned char header[SNAPSHOT_HEADER_SIZE] = {0};
+    memcpy(header, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN);
+    put_u32(header + 8, SNAPSHOT_VERSION);
+    uint byte_order = SNAPSHOT_BYTE_ORDER;
+    memcpy(header + 12, &byte_order, sizeof(uint));
+    put_u32(header + 16, game->width);
+    put_u32(header + 20, game->heigth);
+    put_u32(header + 24, game->number_of_players);
+    put_u32(header + 28, game->max_areas);
+    put_u32(header + 32, game->golden_moves_used);
+    put_u64(header + 40, game->busy_fields);
+    put_u64(header + 48, game->fields_of_wider_players);
+    put_u64(header + 56, game->epoch);
+    muint board_offset = 0, indexes_offset = 0, size = 0;
+    snapshot_layout(game->width, game->heigth, game->number_of_players,
+                    &board_offset, &indexes_offset, &size);
+    put_u64(header + 64, board_offset);
+    put_u64(header + 72, indexes_offset);
+    snapshot_put(&out, header, SNAPSHOT_HEADER_SIZE);
+
+    for (uint i = 1; i <= game->number_of_players; ++i)
+    {
+        unsigned char record[SNAPSHOT_PLAYER_SIZE] = {0};
+        put_u64(record, game->players[i].fields);
+        put_u64(record + 8, game->players[i].next_ind);
+        put_u64(record + 16, game->players[i].border);
+        put_u32(record + 24, game->players[i].areas);
+        record[28] = game->players[i].free_golden_move;
+        snapshot_put(&out, record, SNAPSHOT_PLAYER_SIZE);
+    }
+
+    static const unsigned char padding[SNAPSHOT_ALIGN];
+    muint cells = (muint) game->width * game->heigth;
+    snapshot_put(&out, padding, board_offset - SNAPSHOT_HEADER_SIZE
+                 - (muint) game->number_of_players * SNAPSHOT_PLAYER_SIZE);
+    for (uint x = 0; x < game->width; ++x)
+        snapshot_put(&out, game->board[x], (size_t) game->heigth * sizeof(uint));
+    snapshot_put(&out, padding, indexes_offset - board_offset - cells * sizeof(uint));
+    for (uint x = 0; x < game->width; ++x)
+        snapshot_put(&out, game->indexes[x], (size_t) game->heigth * sizeof(muint));
+    snapshot_flush(&out);
+
+    bool ok = out.ok && fdatasync(out.fd) == 0;
+    ok = close(out.fd) == 0 && ok;
+    ok = ok && rename(temporary, path) == 0;
+    if (ok == false)
+        unlink(temporary);
+
+    free(temporary);
+    free(out.buffer);
+    return ok;
+}
+
+/** @brief Sprawdza nagłówek migawki.
+ * Funkcja pomocnicza w @ref gamma_load i @ref gamma_map.
+ * @param[in] header – wskaźnik na nagłówek migawki,
+ * @param[out] size  – rozmiar pliku migawki wynikający z nagłówka.
+ * @return Wartość @p true, jeśli nagłówek opisuje poprawną grę w obsługiwanej
+ * wersji formatu, zapisaną na komputerze o tej samej kolejności bajtów,
+ * której plik migawki da się zaadresować, a @p false w przeciwnym razie.
+ */
+static bool header_is_fine(const unsigned char *header, muint *size)
+{
+    uint byte_order;
+    memcpy(&byte_order, header + 12, sizeof(uint));
+    if (memcmp(header, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN) != 0
+        || get_u32(header + 8) != SNAPSHOT_VERSION
+        || byte_order != SNAPSHOT_BYTE_ORDER)
+        return false;
+
+    uint width = get_u32(header + 16);
+    uint height = get_u32(header + 20);
+    uint players = get_u32(header + 24);
+    if (width == 0 || height == 0 || players == 0 || get_u32(header + 28) == 0)
+        return false;
+
+    muint board, indexes;
+    return snapshot_layout(width, height, players, &board, &indexes, size)
+        && get_u64(header + 64) == board && get_u64(header + 72) == indexes;
+}
+
+/** @brief Przepisuje do gry liczniki zapisane w nagłówku migawki.
+ * Funkcja pomocnicza w @ref gamma_load i @ref gamma_map.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] header   – wskaźnik na nagłówek migawki.
+ */
+static void apply_header(gamma_t *game, const unsigned char *header)
+{
+    game->golden_moves_used = get_u32(header + 32);
+    game->busy_fields = get_u64(header + 40);
+    game->fields_of_wider_players = get_u64(header + 48);
+    game->epoch = get_u64(header + 56);
+    game->changes_start = game->epoch;
+    game->over_checked = 0;
+}
+
+/** @brief Odczytuje rekord gracza z migawki.
+ * Funkcja pomocnicza w @ref gamma_load i @ref gamma_map.
+ * @param[out] p     – wskaźnik na strukturę gracza,
+ * @param[in] record – wskaźnik na rekord gracza w migawce.
+ */
+static void apply_player(player *p, const unsigned char *record)
+{
+    p->fields = get_u64(record);
+    p->next_ind = get_u64(record + 8);
+    p->border = get_u64(record + 16);
+    p->areas = get_u32(record + 24);
+    p->free_golden_move = record[28] != 0;
+    p->golden_checked = 0;
+}
+
+/** @brief Sprawdza spójność liczników graczy z wczytanej migawki.
+ * Funkcja pomocnicza w @ref gamma_load, @ref gamma_map i @ref gamma_check.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli żaden gracz nie przekracza limitu obszarów,
+ * a liczby pól graczy sumują się do liczby zajętych pól, a @p false
+ * w przeciwnym razie.
+ */
+static bool players_are_fine(gamma_t *game)
+{
+    muint busy = 0;
+    for (uint i = 1; i <= game->number_of_players; ++i)
+    {
+        if (game->max_areas < game->players[i].areas)
+            return false;
+        busy += game->players[i].fields;
+    }
+    return busy == game->busy_fields;
+}
+
+/** @brief Sprawdza spójność wczytanej planszy.
+ * Funkcja pomocnicza w @ref gamma_load i @ref gamma_check.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli wszystkie pola należą do istniejących
+ * graczy, a liczba zajętych pól zgadza się z nagłówkiem, a @p false
+ * w przeciwnym razie.
+ */
+static bool board_is_fine(gamma_t *game)
+{
+    muint occupied = 0;
+    for (uint x = 0; x < game->width; ++x)
+    {
+        for (uint y = 0; y < game->heigth; ++y)
+        {
+            if (game->number_of_players < game->board[x][y])
+                return false;
+            occupied += game->board[x][y] != EMPTY;
+        }
+    }
+    return occupied == game->busy_fields;
+}
+
+/** @brief Odtwarza stan gry z pliku zapisanego przez @ref gamma_save.
+ * Kolumny planszy i tablicy indeksów są wczytywane bezpośrednio
+ * do zaalokowanej pamięci dużymi blokami. Dziennik zmian nowej gry jest
+ * pusty, a licznik zmian ma wartość z chwili zapisu.
+ * @param[in] path – ścieżka do pliku migawki.
+ * @return Wskaźnik na odtworzoną strukturę lub NULL, gdy nie udało się
+ * otworzyć pliku, zaalokować pamięci, plik ma nieobsługiwaną wersję
+ * albo jest uszkodzony.
+ */
+gamma_t *gamma_load(const char *path)
+{
+    if (path == NULL)
+        return NULL;
+
+    snapshot_file in = {-1, malloc(SNAPSHOT_BUFFER_SIZE), 0, 0, true};
+    if (in.buffer == NULL)
+        return NULL;
+    in.fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (in.fd < 0)
+    {
+        free(in.buffer);
+        return NULL;
+    }
+
+    // Rozmiar planszy z nagłówka jest sprawdzany z rozmiarem pliku przed
+    // alokacją, aby krótki plik nie wymusił alokacji ogromnej planszy.
+    gamma_t *game = NULL;
+    struct stat info;
+    unsigned char header[SNAPSHOT_HEADER_SIZE];
+    muint size;
+    snapshot_get(&in, header, SNAPSHOT_HEADER_SIZE);
+    if (in.ok && header_is_fine(header, &size)
+        && fstat(in.fd, &info) == 0 && size <= (muint) info.st_size)
+    {
+        game = gamma_new(get_u32(header + 16), get_u32(header + 20),
+                         get_u32(header + 24), get_u32(header + 28));
+    }
+
+    if (game != NULL)
+    {
+        apply_header(game, header);
+        for (uint i = 1; i <= game->number_of_players && in.ok; ++i)
+        {
+            unsigned char record[SNAPSHOT_PLAYER_SIZE];
+            snapshot_get(&in, record, SNAPSHOT_PLAYER_SIZE);
+            apply_player(&game->players[i], record);
+        }
+
+        unsigned char padding[SNAPSHOT_ALIGN];
+        muint cells = (muint) game->width * game->heigth;
+        muint board_offset = get_u64(header + 64);
+        muint indexes_offset = get_u64(header + 72);
+        snapshot_get(&in, padding, board_offset - SNAPSHOT_HEADER_SIZE
+                     - (muint) game->number_of_players * SNAPSHOT_PLAYER_SIZE);
+        for (uint x = 0; x < game->width && in.ok; ++x)
+            snapshot_get(&in, game->board[x], (size_t) game->heigth * sizeof(uint));
+        snapshot_get(&in, padding, indexes_offset - board_offset - cells * sizeof(uint));
+        for (uint x = 0; x < game->width && in.ok; ++x)
+            snapshot_get(&in, game->indexes[x], (size_t) game->heigth * sizeof(muint));
+
+        if (in.ok == false || players_are_fine(game) == false
+            || board_is_fine(game) == false)
+        {
+            gamma_delete(game);
+            game = NULL;
+        }
+    }
+
+    close(in.fd);
+    free(in.buffer);
+    return game;
+}
+
+/** @brief Tworzy grę korzystającą bezpośrednio z odwzorowanej migawki.
+ * Alokuje strukturę gry, tablicę graczy oraz tablice wskaźników na kolumny,
+ * które wskazują na kolejne kolumny planszy i tablicy indeksów w pliku
+ * odwzorowanym pod adresem @p map.
+ * Funkcja pomocnicza w @ref gamma_map.
+ * @param[in] map  – adres odwzorowanego pliku migawki o poprawnym nagłówku,
+ * @param[in] size – rozmiar odwzorowanego pliku.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci lub liczniki graczy są niespójne.
+ */
+static gamma_t *mapped_game(unsigned char *map, size_t size)
+{
+    gamma_t *game = malloc(sizeof(gamma_t));
+    if (game == NULL)
+        return NULL;
+
+    game->width = get_u32(map + 16);
+    game->heigth = get_u32(map + 20);
+    game->number_of_players = get_u32(map + 24);
+    game->max_areas = get_u32(map + 28);
+    game->changes = NULL;
+    game->changes_len = 0;
+    game->changes_mem = 0;
+    game->changes_tracked = false;
+    game->map = map;
+    game->map_len = size;
+    game->history = NULL;
+    apply_header(game, map);
+
+    game->players = malloc((((muint) game->number_of_players) + 1) * sizeof(player));
+    game->board = malloc(game->width * sizeof(uint*));
+    game->indexes = malloc(game->width * sizeof(muint*));
+    if (game->players == NULL || game->board == NULL || game->indexes == NULL)
+    {
+        free(game->players);
+        free(game->board);
+        free(game->indexes);
+        free(game);
+        return NULL;
+    }
+
+    const unsigned char *record = map + SNAPSHOT_HEADER_SIZE;
+    for (uint i = 1; i <= game->number_of_players; ++i)
+    {
+        apply_player(&game->players[i], record);
+        record += SNAPSHOT_PLAYER_SIZE;
+    }
+
+    uint *board = (uint*) (map + get_u64(map + 64));
+    muint *indexes = (muint*) (map + get_u64(map + 72));
+    for (uint x = 0; x < game->width; ++x)
+    {
+        game->board[x] = board + (muint) x * game->heigth;
+        game->indexes[x] = indexes + (muint) x * game->heigth;
+    }
+
+    if (players_are_fine(game) == false)
+    {
+        free(game->players);
+        free(game->board);
+        free(game->indexes);
+        free(game);
+        return NULL;
+    }
+    return game;
+}
+
+/** @brief Odwzorowuje migawkę w pamięci i używa jej jako planszy gry.
+ * Plansza i tablica indeksów nie są kopiowane: kolumny wskazują wprost
+ * na prywatne odwzorowanie pliku, więc strony są sprowadzane z dysku
+ * dopiero przy pierwszym dostępie, a ruchy modyfikują tylko kopie stron
+ * należące do procesu, nigdy sam plik. Zawartość planszy nie jest
+ * sprawdzana, aby nie sprowadzać od razu całego pliku, dlatego plik musi
+ * pochodzić z @ref gamma_save albo zostać sprawdzony przez @ref gamma_check.
+ * Dziennik zmian nowej gry jest pusty.
+ * @param[in] path – ścieżka do pliku migawki.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * otworzyć lub odwzorować pliku, zaalokować pamięci, plik ma nieobsługiwaną
+ * wersję, jest zbyt krótki albo ma niespójny nagłówek.
+ */
+gamma_t *gamma_map(const char *path)
+{
+    if (path == NULL)
+        return NULL;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+
+    struct stat info;
+    unsigned char header[SNAPSHOT_HEADER_SIZE];
+    muint size = 0;
+    bool fine = fstat(fd, &info) == 0
+        && read_full(fd, header, SNAPSHOT_HEADER_SIZE) == SNAPSHOT_HEADER_SIZE
+        && header_is_fine(header, &size)
+        && size <= (muint) info.st_size;
+
+    void *map = MAP_FAILED;
+    if (fine)
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    gamma_t *game = mapped_game(map, size);
+    if (game == NULL)
+        munmap(map, size);
+    return game;
+}
+
+/** @brief Sprawdza spójność planszy i liczników gry.
+ * Przegląda całą planszę, więc dla gry z @ref gamma_map sprowadza z dysku
+ * wszystkie jej strony. Sprawdza właścicieli pól i liczniki graczy,
+ * ale nie indeksy obszarów.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli wszystkie pola należą do istniejących
+ * graczy, a liczby zajętych pól zgadzają się z licznikami, a @p false
+ * w przeciwnym razie lub gdy @p game ma wartość NULL.
+ */
+bool gamma_check(gamma_t *game)
+{
+    return game != NULL && players_are_fine(game) && board_is_fine(game);
+}
+
+/** @brief Odtwarza kolejne ruchy z historii gry.
+ * Ruchy zapisane w historii były legalne, więc są wykonywane bez ponownego
+ * sprawdzania parametrów.
+ * Funkcja pomocnicza w @ref gamma_history i @ref gamma_seek.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves    – tablica ruchów z historii,
+ * @param[in] n        – liczba ruchów.
+ */
+static void replay_moves(gamma_t *game, const logged_move *moves, muint n)
+{
+    for (muint i = 0; i < n; ++i)
+    {
+        const move *m = &moves[i].m;
+        if (moves[i].golden)
+            golden_place(game, m->player, m->x, m->y);
+        else
+            place(game, m->player, m->x, m->y);
+    }
+}
+
+/** @brief Wyznacza kopie stanu gry dla nowego odstępu między nimi.
+ * Odtwarza wszystkie ruchy z historii, zaczynając od pierwszej kopii,
+ * i zapisuje stan gry co @p interval ruchów. Jeśli zabraknie pamięci,
+ * historia pozostaje bez zmian.
+ * Funkcja pomocnicza w @ref gamma_history.
+ * @param[in,out] h     – wskaźnik na historię,
+ * @param[in] interval  – nowa liczba ruchów między kopiami, liczba dodatnia.
+ * @return Wartość @p true, jeśli kopie zostały wyznaczone, a @p false,
+ * jeśli nie udało się zaalokować pamięci.
+ */
+static bool rebuild_checkpoints(history *h, muint interval)
+{
+    history fresh = {interval, NULL, 0, 0, NULL, 0, 0};
+    gamma_t *state = gamma_clone(h->checkpoints[0]);
+    bool fine = state != NULL && add_checkpoint(&fresh, state);
+    for (muint done = 0; fine && done < h->len; )
+    {
+        muint step = h->len - done < interval ? h->len - done : interval;
+        replay_moves(state, h->moves + done, step);
+        done += step;
+        if (step == interval)
+            fine = add_checkpoint(&fresh, state);
+    }
+    gamma_delete(state);
+
+    if (fine == false)
+    {
+        for (muint i = 0; i < fresh.checkpoints_len; ++i)
+            gamma_delete(fresh.checkpoints[i]);
+        free(fresh.checkpoints);
+        return false;
+    }
+
+    for (muint i = 0; i < h->checkpoints_len; ++i)
+        gamma_delete(h->checkpoints[i]);
+    free(h->checkpoints);
+    h->interval = interval;
+    h->checkpoints = fresh.checkpoints;
+    h->checkpoints_len = fresh.checkpoints_len;
+    h->checkpoints_mem = fresh.checkpoints_mem;
+    return true;
+}
+
+/** @brief Włącza, zmienia lub wyłącza historię gry.
+ * Pierwsza kopia stanu gry jest wykonywana od razu, kolejne po każdych
+ * @p interval udanych ruchach. Zmiana odstępu odtwarza wszystkie ruchy
+ * od pierwszej kopii.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] interval – liczba ruchów między kopiami stanu gry lub zero,
+ *                       które wyłącza historię.
+ * @return Wartość @p true, jeśli historia została włączona, zmieniona lub
+ * wyłączona, a @p false, jeśli @p game ma wartość NULL lub nie udało się
+ * zaalokować pamięci.
+ */
+bool gamma_history(gamma_t *game, muint interval)
+{
+    if (game == NULL)
+        return false;
+
+    if (interval == 0)
+    {
+        free_history(game->history);
+        game->history = NULL;
+        return true;
+    }
+
+    if (game->history != NULL)
+    {
+        return game->history->interval == interval
+               || rebuild_checkpoints(game->history, interval);
+    }
+
+    history *h = calloc(1, sizeof(history));
+    if (h == NULL)
+        return false;
+    h->interval = interval;
+    if (add_checkpoint(h, game) == false)
+    {
+        free_history(h);
+        return false;
+    }
+    game->history = h;
+    return true;
+}
+
+/** @brief Podaje liczbę ruchów zapisanych w historii gry.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba udanych ruchów od włączenia historii lub zero, jeśli
+ * historia nie jest prowadzona albo @p game ma wartość NULL.
+ */
+muint gamma_history_length(gamma_t *game)
+{
+    return game == NULL || game->history == NULL ? 0 : game->history->len;
+}
+
+/** @brief Odtwarza stan gry po danym ruchu.
+ * Kopiuje kopię stanu gry o numerze @p n / @p interval i wykonuje na niej
+ * co najwyżej @p interval - 1 kolejnych ruchów z historii.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] n    – numer ruchu, liczba nie większa od wartości
+ *                   @ref gamma_history_length.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, jeśli historia nie jest
+ * prowadzona, @p n jest zbyt duże lub nie udało się zaalokować pamięci.
+ */
+gamma_t *gamma_seek(gamma_t *game, muint n)
+{
+    if (game == NULL || game->history == NULL || game->history->len < n)
+        return NULL;
+
+    history *h = game->history;
+    muint checkpoint = n / h->interval;
+    gamma_t *state = gamma_clone(h->checkpoints[checkpoint]);
+    if (state != NULL)
+    {
+        muint first = checkpoint * h->interval;
+        replay_moves(state, h->moves + first, n - first);
+    }
+    return state;
 }
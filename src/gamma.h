@@ -10,6 +10,7 @@
 #define GAMMA_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -38,6 +39,27 @@ typedef struct player player;
  */
 typedef struct gamma gamma_t;
 
+/** @brief Rekord opisujący pole planszy i jego właściciela.
+ * Wykorzystywany przez @ref gamma_changes do zwracania zmienionych pól
+ * oraz przez @ref gamma_set_fields do ustawiania właścicieli pól.
+ */
+typedef struct field_change
+{
+    uint x; ///< Numer kolumny pola.
+    uint y; ///< Numer wiersza pola.
+    uint owner; ///< Właściciel pola, zero oznacza pole puste.
+} field_change;
+
+/** @brief Ruch gracza wykonywany przez @ref gamma_move_batch
+ * lub @ref gamma_golden_move_batch.
+ */
+typedef struct move
+{
+    uint player; ///< Numer gracza wykonującego ruch.
+    uint x; ///< Numer kolumny pola.
+    uint y; ///< Numer wiersza pola.
+} move;
+
 /** @brief Tworzy strukturę przechowującą stan gry.
  * Alokuje pamięć na nową strukturę przechowującą stan gry.
  * Inicjuje tę strukturę tak, aby reprezentowała początkowy stan gry.
@@ -73,8 +95,8 @@ void gamma_delete(gamma_t *game);
 bool gamma_move(gamma_t *game, uint player, uint x, uint y);
 
 /** @brief Oblicza logarytm dziesiętny zaokrąglony w góre do liczby całkowitej.
- * Funkcja pomocnicza do szacowania rozmiaru tablicy w @ref gamma_spaced_board,
- * @ref show_board oraz @ref interactive_game.
+ * Funkcja pomocnicza do szacowania rozmiaru tablicy w @ref gamma_spaced_board
+ * oraz szerokości pól rysowanych przez @ref interactive_game.
  * @param[in] x    – liczba logarytmowana.
  * @return Wynik tego działania.
  */
@@ -96,6 +118,65 @@ uint ceil_log(uint x);
  */
 bool gamma_golden_move(gamma_t *game, uint player, uint x, uint y);
 
+/** @brief Wykonuje ciąg ruchów.
+ * Wykonuje po kolei ruchy z tablicy @p moves, dając ten sam wynik co kolejne
+ * wywołania @ref gamma_move. Poprawność @p game jest sprawdzana raz, a pola
+ * kolejnych ruchów są z wyprzedzeniem sprowadzane do pamięci podręcznej.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves    – tablica ruchów,
+ * @param[in] n        – liczba ruchów,
+ * @param[out] results – tablica na @p n wyników kolejnych ruchów lub NULL.
+ * @return Liczba wykonanych ruchów.
+ */
+size_t gamma_move_batch(gamma_t *game, const move *moves, size_t n, bool *results);
+
+/** @brief Wykonuje ciąg złotych ruchów.
+ * Wykonuje po kolei złote ruchy z tablicy @p moves, dając ten sam wynik co
+ * kolejne wywołania @ref gamma_golden_move. Poprawność @p game jest
+ * sprawdzana raz, a pola kolejnych ruchów są z wyprzedzeniem sprowadzane
+ * do pamięci podręcznej.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves    – tablica ruchów,
+ * @param[in] n        – liczba ruchów,
+ * @param[out] results – tablica na @p n wyników kolejnych ruchów lub NULL.
+ * @return Liczba wykonanych ruchów.
+ */
+size_t gamma_golden_move_batch(gamma_t *game, const move *moves, size_t n, bool *results);
+
+/** @brief Ustawia właścicieli wielu pól naraz.
+ * Zapisuje po kolei właścicieli pól z tablicy @p fields bezpośrednio na
+ * planszy, a następnie w jednym przejściu po planszy przebudowuje obszary,
+ * liczby pól i obszarów graczy oraz liczby pustych pól graniczących z ich
+ * polami. Stan złotych ruchów się nie zmienia. Jeśli w otrzymanej pozycji
+ * któryś z graczy miałby więcej obszarów niż dozwolono, plansza wraca do
+ * poprzedniego stanu. Historia gry jest porzucana dopiero po ustawieniu
+ * pozycji, a pusta tablica rekordów niczego nie zmienia.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] fields   – tablica rekordów (x, y, właściciel), gdzie właściciel
+ *                       równy zero oznacza pole puste,
+ * @param[in] n        – liczba rekordów.
+ * @return Wartość @p true, jeśli pozycja została ustawiona, a @p false,
+ * gdy któryś z rekordów jest niepoprawny, pozycja jest niedozwolona
+ * lub nie udało się zaalokować pamięci.
+ */
+bool gamma_set_fields(gamma_t *game, const field_change *fields, size_t n);
+
+/** @brief Przebudowuje obszary i liczniki graczy na podstawie planszy.
+ * Plansza jest dzielona na @p threads pasów kolumn. Wątki niezależnie łączą
+ * pola swoich pasów w obszary, następnie wątek wywołujący łączy obszary
+ * przecinające granice pasów, a na końcu wątki nadają polom indeksy obszarów.
+ * Liczby pól, obszarów i pustych pól graniczących z polami graczy są
+ * wyznaczane od nowa, a stan złotych ruchów się nie zmienia. Dla jednego
+ * wątku lub gdy nie uda się zaalokować pamięci na liczniki pasów, obszary
+ * są przebudowywane sekwencyjnie.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] threads  – liczba wątków, liczba dodatnia, ograniczana
+ *                       do szerokości planszy i 256.
+ * @return Wartość @p true, jeśli obszary zostały przebudowane, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny.
+ */
+bool gamma_rebuild_areas(gamma_t *game, uint threads);
+
 /** @brief Podaje liczbę pól zajętych przez gracza.
  * Podaje liczbę pól zajętych przez gracza @p player.
  * @param[in] game    – wskaźnik na strukturę przechowującą stan gry,
@@ -121,6 +202,8 @@ muint gamma_free_fields(gamma_t *game, uint player);
  * Sprawdza, czy gracz @p player jeszcze nie wykonał w tej rozgrywce złotego
  * ruchu i jest przynajmniej jedno pole zajęte przez innego gracza, którego
  * zajęcie nie rozpójni obszarów tego gracza ponad dozwoloną liczbę.
+ * Wynik przeszukania planszy jest zapamiętywany do następnej zmiany planszy,
+ * więc kolejne wywołania dla tego samego stanu gry działają w czasie stałym.
  * @param[in] game    – wskaźnik na strukturę przechowującą stan gry,
  * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
  *                      @p players z funkcji @ref gamma_new.
@@ -130,6 +213,35 @@ muint gamma_free_fields(gamma_t *game, uint player);
  */
 bool gamma_golden_possible(gamma_t *game, uint player);
 
+/** @brief Sprawdza, którzy gracze mogą wykonać złoty ruch.
+ * Odpowiada dla wszystkich graczy naraz. Gracze, dla których trzeba
+ * przeszukać planszę, są obsługiwani w jednym wspólnym przejściu, w którym
+ * każde pole jest sprawdzane raz. Przy więcej niż jednym wątku plansza jest
+ * dzielona na pasy kolumn, a wątki potwierdzają złote ruchy, których
+ * sprawdzenie nie wymaga przeszukiwania obszarów; pozostałych kandydatów
+ * sprawdza wątek wywołujący. Wyniki są zapamiętywane tak jak w
+ * @ref gamma_golden_possible.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] out     – tablica co najmniej @p players + 1 wartości, w której
+ *                       pod indeksem @p i zostanie zapisana odpowiedź
+ *                       @ref gamma_golden_possible dla gracza @p i,
+ *                       a pod indeksem zero wartość @p false,
+ * @param[in] threads  – liczba wątków, liczba dodatnia, ograniczana
+ *                       do szerokości planszy i 256.
+ * @return Wartość @p true, jeśli odpowiedzi zostały zapisane, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny lub zabrakło pamięci.
+ */
+bool gamma_golden_possible_all(gamma_t *game, bool *out, uint threads);
+
+/** @brief Sprawdza, czy gra się zakończyła.
+ * Gra kończy się, gdy żaden gracz nie może wykonać ani zwykłego, ani złotego
+ * ruchu. Wynik jest zapamiętywany do następnej zmiany planszy.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli żaden gracz nie może wykonać ruchu lub
+ * @p game ma wartość NULL, a @p false w przeciwnym przypadku.
+ */
+bool gamma_game_over(gamma_t *game);
+
 /** @brief Daje napis opisujący stan planszy.
  * Alokuje w pamięci bufor, w którym umieszcza napis zawierający tekstowy
  * opis aktualnego stanu planszy.
@@ -140,27 +252,19 @@ bool gamma_golden_possible(gamma_t *game, uint player);
  */
 char *gamma_board(gamma_t *game);
 
-/** @brief Funkcja pomocznicza do przesuwania wyświetlanej treści.
- * Wypisuje na stdout @p margin spacji dzięki czemu następny stdout
- * jest przesunięty w prawo.
- * @param[in] margin – długośc przesunięcia, tj. liczba spacji,
-*/
-void push (uint margin);
-
-/** @brief Wyświetla aktualny stan planszy.
- * Wypisuje do konsoli aktualny stan planszy z uzglednienie tego że na
- * polu (@p x, @p y) znajduje się aktualnie kursor.
- * Funkcja pomocnicza w @ref interactive_game.
- * @param[in] game   – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] cur_x  – numer kolumny, gdzie znajduje się kursor, liczba nieujemna
- *                      mniejsza od wartości @p width z funkcji @ref gamma_new,
- * @param[in] cur_y  – numer wiersza, gdzie znajduje się kursor, liczba nieujemna
- *                      mniejsza od wartości @p width z funkcji @ref gamma_new,
- * @param[in] player – identyfikator gracza, którego jest tura,
- * @param[in] margin – zmienna pomocnicza do środkowa planszy,
- *                      tj. odległość planszy od lewej ściany terminala.
+/** @brief Daje skompresowany napis opisujący stan planszy.
+ * Alokuje w pamięci bufor, w którym umieszcza opis planszy zakodowany
+ * długościami serii. Wiersze są wypisywane w tej samej kolejności co
+ * w @ref gamma_board. Każdy wiersz jest ciągiem serii oddzielonych spacjami,
+ * np. wiersz "..11111..." ma postać ".*2 1*5 .*3". Ciąg @p k wierszy
+ * identycznych z wierszem poprzednim zapisywany jest jako jedna linia "=k".
+ * Napis powstaje bezpośrednio z planszy, bez budowania pełnego opisu.
+ * Funkcja wywołująca musi zwolnić ten bufor.
+ * @param[in] game    – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wskaźnik na zaalokowany bufor zawierający napis opisujący stan
+ * planszy lub NULL, jeśli nie udało się zaalokować pamięci.
  */
-void show_board(gamma_t *game, uint cur_x, uint cur_y, uint player, uint margin);
+char *gamma_board_rle(gamma_t *game);
 
 /** @brief Zwraca liczbę wszystkich zajętych pól na planszy.
  * Funkcja pomocnicza w @ref interactive_game.
@@ -169,6 +273,16 @@ void show_board(gamma_t *game, uint cur_x, uint cur_y, uint player, uint margin)
  */
 muint gamma_all_busy_fields(gamma_t *game);
 
+/** @brief Zwraca właściciela pola (@p x, @p y).
+ * Funkcja pomocnicza w @ref interactive_game.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x    – numer kolumny pola,
+ * @param[in] y    – numer wiersza pola.
+ * @return Numer gracza zajmującego pole lub zero, jeśli pole jest puste,
+ * poza planszą lub @p game ma wartość NULL.
+ */
+uint gamma_owner(gamma_t *game, uint x, uint y);
+
 /** @brief Zwraca liczbę wszystkich obszarów gracza @p player.
  * Funkcja pomocnicza w @ref interactive_game.
  * @param[in] game   – wskaźnik na strukturę przechowującą stan gry.
@@ -185,4 +299,123 @@ uint gamma_areas(gamma_t *game, uint player);
  */
 uint gamma_best_result(gamma_t *game);
 
+/** @brief Zwraca aktualną wartość licznika zmian planszy.
+ * Od momentu wywołania tej funkcji silnik prowadzi dziennik zmian,
+ * dzięki czemu zwrócona wartość może zostać później przekazana
+ * do @ref gamma_changes.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba dotychczasowych zmian właścicieli pól lub zero,
+ * jeśli @p game ma wartość NULL.
+ */
+muint gamma_epoch(gamma_t *game);
+
+/** @brief Podaje liczbę dotychczasowych zmian właścicieli pól.
+ * W odróżnieniu od @ref gamma_epoch nie włącza prowadzenia dziennika zmian.
+ * Nieudane ruchy, także złote, nie zmieniają tej liczby, więc ponowne
+ * wykonanie tych samych udanych ruchów daje tę samą wartość.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba dotychczasowych zmian właścicieli pól lub zero,
+ * jeśli @p game ma wartość NULL.
+ */
+muint gamma_change_count(gamma_t *game);
+
+/** @brief Podaje pola, których właściciel zmienił się od danego momentu.
+ * Alokuje tablicę rekordów (x, y, właściciel) opisujących pola, których
+ * właściciel jest inny niż w chwili, gdy licznik zmian planszy miał wartość
+ * @p epoch. Właściciel w rekordzie jest aktualnym właścicielem pola,
+ * a zero oznacza pole puste. Rekordy są uporządkowane według numeru kolumny,
+ * a następnie numeru wiersza. Funkcja wywołująca musi zwolnić tę tablicę.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] epoch    – wartość licznika zwrócona wcześniej przez
+ *                       @ref gamma_epoch, lub zero oznaczające początek gry,
+ * @param[out] count   – wskaźnik na liczbę zwróconych rekordów.
+ * @return Wskaźnik na zaalokowaną tablicę rekordów lub NULL, jeśli nie udało
+ * się zaalokować pamięci, któryś z parametrów jest niepoprawny lub
+ * dziennik zmian nie sięga już wartości @p epoch. Dziennik przechowuje
+ * co najmniej ostatnie pół miliona zmian, starsze wpisy są usuwane.
+ */
+field_change *gamma_changes(gamma_t *game, muint epoch, muint *count);
+
+/** @brief Zapisuje pełny stan gry do pliku.
+ * Zapisuje planszę, indeksy obszarów, stan wszystkich graczy oraz liczniki
+ * gry w wersjonowanym formacie binarnym. Plik @p path jest zastępowany
+ * dopiero po pomyślnym zapisie całej migawki.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] path – ścieżka do pliku migawki.
+ * @return Wartość @p true, jeśli migawka została zapisana, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny lub zapis się nie powiódł.
+ */
+bool gamma_save(gamma_t *game, const char *path);
+
+/** @brief Odtwarza stan gry z pliku.
+ * Tworzy strukturę przechowującą stan gry zapisany wcześniej przez
+ * @ref gamma_save. Dziennik zmian odtworzonej gry jest pusty.
+ * @param[in] path – ścieżka do pliku migawki.
+ * @return Wskaźnik na odtworzoną strukturę lub NULL, gdy nie udało się
+ * odczytać pliku, zaalokować pamięci lub plik jest niepoprawny.
+ */
+gamma_t *gamma_load(const char *path);
+
+/** @brief Odtwarza stan gry bez wczytywania całej planszy.
+ * Odwzorowuje w pamięci plik zapisany przez @ref gamma_save i używa go
+ * bezpośrednio jako planszy gry. Fragmenty planszy są wczytywane z dysku
+ * przy pierwszym dostępie, a zmiany planszy nie trafiają do pliku.
+ * Zawartość planszy nie jest sprawdzana, dlatego plik musi pochodzić
+ * z @ref gamma_save albo zostać sprawdzony przez @ref gamma_check.
+ * Dziennik zmian odtworzonej gry jest pusty.
+ * @param[in] path – ścieżka do pliku migawki.
+ * @return Wskaźnik na odtworzoną strukturę lub NULL, gdy nie udało się
+ * odwzorować pliku, zaalokować pamięci lub plik jest niepoprawny.
+ */
+gamma_t *gamma_map(const char *path);
+
+/** @brief Sprawdza spójność planszy i liczników gry.
+ * Przegląda całą planszę, więc dla gry z @ref gamma_map sprowadza z dysku
+ * wszystkie jej strony. Sprawdza właścicieli pól i liczniki graczy,
+ * ale nie indeksy obszarów.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli wszystkie pola należą do istniejących
+ * graczy, a liczby zajętych pól zgadzają się z licznikami, a @p false
+ * w przeciwnym razie lub gdy @p game ma wartość NULL.
+ */
+bool gamma_check(gamma_t *game);
+
+/** @brief Włącza, zmienia lub wyłącza historię gry.
+ * Od chwili włączenia historii silnik zapisuje każdy udany ruch oraz co
+ * @p interval ruchów pełną kopię stanu gry, dzięki czemu @ref gamma_seek
+ * odtwarza stan po dowolnym ruchu, wykonując co najwyżej @p interval ruchów.
+ * Mniejszy odstęp przyspiesza @ref gamma_seek kosztem pamięci na kopie.
+ * Zmiana odstępu w trakcie gry zachowuje zapisane ruchy i wyznacza kopie
+ * od nowa. Historia jest porzucana, gdy zabraknie na nią pamięci lub
+ * pozycja zostanie ustawiona przez @ref gamma_set_fields.
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] interval – liczba ruchów między kopiami stanu gry lub zero,
+ *                       które wyłącza historię.
+ * @return Wartość @p true, jeśli historia została włączona, zmieniona lub
+ * wyłączona, a @p false, jeśli @p game ma wartość NULL lub nie udało się
+ * zaalokować pamięci.
+ */
+bool gamma_history(gamma_t *game, muint interval);
+
+/** @brief Podaje liczbę ruchów zapisanych w historii gry.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba udanych ruchów od włączenia historii lub zero, jeśli
+ * historia nie jest prowadzona albo @p game ma wartość NULL.
+ */
+muint gamma_history_length(gamma_t *game);
+
+/** @brief Odtwarza stan gry po danym ruchu.
+ * Tworzy nową strukturę przechowującą stan gry po pierwszych @p n ruchach
+ * od włączenia historii, kopiując najbliższą wcześniejszą kopię stanu gry
+ * i wykonując pozostałe ruchy. Gra @p game się nie zmienia. Nowa gra nie
+ * ma historii ani dziennika zmian i musi zostać usunięta przez
+ * @ref gamma_delete.
+ * @param[in] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] n    – numer ruchu, liczba nie większa od wartości
+ *                   @ref gamma_history_length.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, jeśli historia nie jest
+ * prowadzona, @p n jest zbyt duże lub nie udało się zaalokować pamięci.
+ */
+gamma_t *gamma_seek(gamma_t *game, muint n);
+
 #endif /* GAMMA_H */
@@ -0,0 +1,396 @@
+/** @file
+ * Pomiar rozmiaru i czasu rysowania klatek trybu interaktywnego.
+ * Program uruchamia grę w pseudoterminalu, wysyła jej ustalone sekwencje
+ * klawiszy i mierzy, ile bajtów gra wypisała w odpowiedzi na każdy klawisz
+ * i po jakim czasie.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 22 maja 2020
+ */
+
+/**
+ * Makro wymagane do poprawnego działania funkcji @ref forkpty
+ * i @ref clock_gettime.
+ */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Liczba wierszy pseudoterminala.
+ */
+#define TERM_ROWS 50
+
+/**
+ * Liczba kolumn pseudoterminala.
+ */
+#define TERM_COLS 160
+
+/**
+ * Liczba klawiszy wysyłanych pojedynczo i liczba klawiszy w serii.
+ */
+#define KEYS 200
+
+/**
+ * Maksymalna liczba obszarów jednego gracza w mierzonych grach.
+ */
+#define AREAS 4
+
+/**
+ * Najdłuższy czas oczekiwania w milisekundach na pierwszą klatkę gry.
+ */
+#define FIRST_TIMEOUT 30000
+
+/**
+ * Najdłuższy czas oczekiwania w milisekundach na odpowiedź na klawisz.
+ * Klawisz, po którym w tym czasie nic nie zostało wypisane, nie zmienił
+ * obrazu na ekranie.
+ */
+#define KEY_TIMEOUT 100
+
+/**
+ * Czas w milisekundach bez nowych bajtów, po którym klatka jest uznawana
+ * za wypisaną w całości.
+ */
+#define QUIET 20
+
+/**
+ * Czas w milisekundach bez nowych bajtów, po którym uznaje się, że gra
+ * obsłużyła całą serię klawiszy.
+ */
+#define BURST_QUIET 300
+
+/** @brief Rozmiar mierzonej gry.
+ */
+typedef struct scenario
+{
+    unsigned width; ///< Szerokość planszy.
+    unsigned height; ///< Wysokość planszy.
+    unsigned players; ///< Liczba graczy.
+} scenario;
+
+/** @brief Wynik pomiaru jednej gry.
+ */
+typedef struct result
+{
+    size_t first_bytes; ///< Liczba bajtów pierwszej klatki.
+    double first_ms; ///< Czas do wypisania pierwszej klatki.
+    unsigned frames; ///< Liczba klawiszy, po których coś zostało wypisane.
+    size_t frame_bytes; ///< Łączna liczba bajtów klatek po klawiszach.
+    double frame_ms[KEYS]; ///< Czasy kolejnych klatek po klawiszach.
+    size_t burst_bytes; ///< Liczba bajtów wypisanych w odpowiedzi na serię.
+    double burst_ms; ///< Czas obsługi serii klawiszy.
+} result;
+
+/**
+ * Gry mierzone, gdy nie podano ich w argumentach programu.
+ */
+static const scenario defaults[] = {
+    {10, 10, 2}, {30, 12, 3}, {50, 30, 4}, {100, 40, 9},
+    {70, 40, 20}, {1000, 1000, 4}
+};
+
+/** @brief Podaje czas zegara monotonicznego.
+ * @return Liczba milisekund od ustalonej chwili w przeszłości.
+ */
+static double now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+}
+
+/** @brief Losuje kolejny klawisz sekwencji.
+ * Sekwencja zależy tylko od stanu generatora, więc każdy pomiar wysyła
+ * te same klawisze. Większość klawiszy to strzałki, a pozostałe to ruchy,
+ * złote ruchy i pominięcia tury.
+ * @param[in,out] state – stan generatora liczb pseudolosowych.
+ * @return Napis z sekwencją bajtów klawisza.
+ */
+static const char *next_key(unsigned *state)
+{
+    static const char *const keys[] = {
+        "\033[A", "\033[B", "\033[C", "\033[D",
+        "\033[A", "\033[B", "\033[C", "\033[D",
+        " ", " ", " ", "g", "c"
+    };
+    *state = *state * 1103515245u + 12345u;
+    return keys[(*state >> 16) % (sizeof(keys) / sizeof(keys[0]))];
+}
+
+/** @brief Uruchamia grę w nowym pseudoterminalu.
+ * Przed uruchomieniem gry wyłącza echo pseudoterminala, aby odpowiedzią
+ * na nagłówek była pierwsza klatka gry, a nie powtórzony wiersz polecenia.
+ * @param[in] binary – ścieżka do programu gry,
+ * @param[out] fd    – deskryptor strony nadrzędnej pseudoterminala.
+ * @return Identyfikator procesu gry lub -1, jeśli nie udało się go utworzyć.
+ */
+static pid_t start_game(const char *binary, int *fd)
+{
+    struct winsize size = {TERM_ROWS, TERM_COLS, 0, 0};
+    pid_t pid = forkpty(fd, NULL, NULL, &size);
+    if (pid == 0)
+    {
+        execl(binary, binary, (char*) NULL);
+        _exit(127);
+    }
+    if (pid > 0)
+    {
+        // Tryb ustawiony po stronie nadrzędnej obowiązuje, zanim gra
+        // otrzyma pierwszy bajt, więc nie ściga się z jej uruchamianiem.
+        struct termios mode;
+        if (tcgetattr(*fd, &mode) == 0)
+        {
+            mode.c_lflag &= ~(ECHO | ECHONL);
+            tcsetattr(*fd, TCSANOW, &mode);
+        }
+        fcntl(*fd, F_SETFL, fcntl(*fd, F_GETFL) | O_NONBLOCK);
+    }
+    return pid;
+}
+
+/** @brief Wysyła dane do gry i odbiera jej odpowiedź.
+ * Odpowiedź jest odbierana także w trakcie wysyłania, żeby gra nie
+ * zablokowała się na zapisie do pełnego pseudoterminala. Odpowiedź kończy
+ * się, gdy przez @p quiet milisekund nie nadejdą nowe bajty. Czas odpowiedzi
+ * jest liczony do nadejścia ostatniego bajtu.
+ * @param[in] fd            – deskryptor strony nadrzędnej pseudoterminala,
+ * @param[in] data          – wysyłane bajty,
+ * @param[in] len           – liczba wysyłanych bajtów,
+ * @param[in] first_timeout – najdłuższy czas oczekiwania na pierwszy bajt,
+ * @param[in] quiet         – czas ciszy kończący odpowiedź,
+ * @param[out] elapsed      – czas od rozpoczęcia wysyłania do ostatniego
+ *                            bajtu odpowiedzi lub zero, jeśli jej nie było,
+ * @param[out] closed       – czy gra zamknęła pseudoterminal.
+ * @return Liczba bajtów odpowiedzi.
+ */
+static size_t exchange(int fd, const char *data, size_t len, int first_timeout,
+                       int quiet, double *elapsed, bool *closed)
+{
+    char buffer[1 << 16];
+    double start = now_ms(), last = start;
+    size_t sent = 0, bytes = 0;
+
+    *closed = false;
+    while (*closed == false)
+    {
+        struct pollfd p = {fd, POLLIN | (sent < len ? POLLOUT : 0), 0};
+        int timeout = sent < len ? -1 : bytes == 0 ? first_timeout : quiet;
+        int ready = poll(&p, 1, timeout);
+        if (ready == -1 && errno == EINTR)
+            continue;
+        if (ready <= 0)
+            break;
+
+        if (p.revents & POLLIN)
+        {
+            ssize_t got = read(fd, buffer, sizeof(buffer));
+            if (got > 0)
+            {
+                bytes += got;
+                last = now_ms();
+            }
+            else if (got == 0 || errno != EAGAIN)
+                *closed = true;
+        }
+        else if (p.revents & (POLLHUP | POLLERR))
+        {
+            *closed = true;
+        }
+
+        if (*closed == false && sent < len && (p.revents & POLLOUT))
+        {
+            ssize_t put = write(fd, data + sent, len - sent);
+            if (put > 0)
+                sent += put;
+        }
+    }
+
+    *elapsed = bytes == 0 ? 0 : last - start;
+    return bytes;
+}
+
+/** @brief Porównuje dwa czasy.
+ * Funkcja pomocnicza w @ref print_result, przekazywana do @ref qsort.
+ * @param[in] a – wskaźnik na pierwszy czas,
+ * @param[in] b – wskaźnik na drugi czas.
+ * @return Liczba ujemna, zero lub dodatnia, jeśli pierwszy czas jest
+ * odpowiednio mniejszy, równy lub większy od drugiego.
+ */
+static int compare_times(const void *a, const void *b)
+{
+    double x = *(const double*) a, y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+/** @brief Wypisuje wiersz tabeli z wynikiem pomiaru gry.
+ * @param[in] sc – wskaźnik na rozmiar gry,
+ * @param[in,out] res – wskaźnik na wynik pomiaru, czasy klatek są sortowane.
+ */
+static void print_result(const scenario *sc, result *res)
+{
+    char board[32];
+    snprintf(board, sizeof(board), "%ux%u", sc->width, sc->height);
+    printf("%-12s %7u %9zu %9.1f %6u", board, sc->players,
+           res->first_bytes, res->first_ms, res->frames);
+
+    if (res->frames == 0)
+    {
+        printf(" %9s %8s %8s %8s", "-", "-", "-", "-");
+    }
+    else
+    {
+        double sum = 0;
+        for (unsigned i = 0; i < res->frames; ++i)
+            sum += res->frame_ms[i];
+        qsort(res->frame_ms, res->frames, sizeof(double), compare_times);
+        printf(" %9.1f %8.2f %8.2f %8.2f",
+               (double) res->frame_bytes / res->frames, sum / res->frames,
+               res->frame_ms[(res->frames - 1) * 95 / 100],
+               res->frame_ms[res->frames - 1]);
+    }
+    printf(" %9zu %9.1f\n", res->burst_bytes, res->burst_ms);
+    fflush(stdout);
+}
+
+/** @brief Mierzy klatki jednej gry.
+ * Po pierwszej klatce wysyła po jednym klawiszu, czekając na wypisanie
+ * odpowiedzi, a następnie wysyła naraz serię klawiszy i kończy grę
+ * kombinacją Ctrl-D. Gra, która skończy się wcześniej, jest mierzona
+ * do swojego końca.
+ * @param[in] binary – ścieżka do programu gry,
+ * @param[in] sc     – wskaźnik na rozmiar gry.
+ * @return Wartość @p true, jeśli gra zakończyła się poprawnie, a @p false,
+ * jeśli nie udało się jej uruchomić lub zakończyła się z błędem.
+ */
+static bool run_scenario(const char *binary, const scenario *sc)
+{
+    int fd;
+    pid_t pid = start_game(binary, &fd);
+    if (pid < 0)
+        return false;
+
+    static result res;
+    memset(&res, 0, sizeof(res));
+    char header[64];
+    int len = snprintf(header, sizeof(header), "I %u %u %u %u\n",
+                       sc->width, sc->height, sc->players, AREAS);
+    bool closed;
+    res.first_bytes = exchange(fd, header, len, FIRST_TIMEOUT, QUIET,
+                               &res.first_ms, &closed);
+
+    unsigned state = 1;
+    for (unsigned i = 0; i < KEYS && closed == false; ++i)
+    {
+        const char *key = next_key(&state);
+        double ms;
+        size_t bytes = exchange(fd, key, strlen(key), KEY_TIMEOUT, QUIET, &ms, &closed);
+        if (bytes > 0)
+        {
+            res.frame_bytes += bytes;
+            res.frame_ms[res.frames++] = ms;
+        }
+    }
+
+    if (closed == false)
+    {
+        char burst[KEYS * 4];
+        size_t burst_len = 0;
+        for (unsigned i = 0; i < KEYS; ++i)
+        {
+            const char *key = next_key(&state);
+            memcpy(burst + burst_len, key, strlen(key));
+            burst_len += strlen(key);
+        }
+        res.burst_bytes = exchange(fd, burst, burst_len, KEY_TIMEOUT,
+                                   BURST_QUIET, &res.burst_ms, &closed);
+    }
+
+    // Zakończenie gry i odebranie wyników końcowych. Gra, która nie zamknie
+    // pseudoterminala w ciągu FIRST_TIMEOUT ms, jest zabijana.
+    double ms;
+    int status;
+    if (closed == false)
+        exchange(fd, "\4", 1, FIRST_TIMEOUT, FIRST_TIMEOUT, &ms, &closed);
+    if (closed == false)
+        kill(pid, SIGKILL);
+    close(fd);
+    waitpid(pid, &status, 0);
+    bool fine = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    if (fine)
+        print_result(sc, &res);
+    return fine;
+}
+
+/** @brief Funkcja główna programu.
+ * Pierwszym argumentem jest ścieżka do programu gry, a kolejnymi rozmiary
+ * mierzonych gier w postaci SZEROKOŚĆxWYSOKOŚĆxGRACZE. Bez rozmiarów
+ * mierzony jest ustalony zestaw gier. Dla każdej gry wypisuje wiersz
+ * z rozmiarem i czasem pierwszej klatki, liczbą klatek po pojedynczych
+ * klawiszach, ich średnim rozmiarem, średnim, 95. percentylem i maksymalnym
+ * czasem oraz rozmiarem i czasem odpowiedzi na serię klawiszy. Czasy są
+ * podawane w milisekundach, a rozmiary w bajtach.
+ * @param[in] argc – liczba argumentów,
+ * @param[in] argv – argumenty programu.
+ * @return Zero, jeśli wszystkie gry zostały zmierzone, a jeden w przeciwnym
+ * razie.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s GAMMA [WIDTHxHEIGHTxPLAYERS ...]\n", argv[0]);
+        return 1;
+    }
+
+    size_t count = argc > 2 ? (size_t) argc - 2 : sizeof(defaults) / sizeof(defaults[0]);
+    scenario *list = malloc(count * sizeof(scenario));
+    if (list == NULL)
+        return 1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        char rest;
+        if (argc == 2)
+            list[i] = defaults[i];
+        else if (sscanf(argv[i + 2], "%ux%ux%u%c", &list[i].width, &list[i].height,
+                        &list[i].players, &rest) != 3)
+        {
+            fprintf(stderr, "invalid game size: %s\n", argv[i + 2]);
+            free(list);
+            return 1;
+        }
+    }
+
+    printf("%-12s %7s %9s %9s %6s %9s %8s %8s %8s %9s %9s\n", "board",
+           "players", "first_B", "first_ms", "frames", "B/frame", "ms/frame",
+           "p95_ms", "max_ms", "burst_B", "burst_ms");
+    fflush(stdout);
+    bool fine = true;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (run_scenario(argv[1], &list[i]) == false)
+        {
+            fprintf(stderr, "game %ux%u with %u players failed\n",
+                    list[i].width, list[i].height, list[i].players);
+            fine = false;
+        }
+    }
+
+    free(list);
+    return fine ? 0 : 1;
+}
@@ -7,76 +7,380 @@
  * @date 15 maja 2020
  */
 
+#include "gamma.h"
+#include "parser.h"
+#include "reader.h"
+#include "writer.h"
+#include "batch.h"
+#include "binary.h"
+#include "pipeline.h"
+#include "parallel.h"
+#include "multi.h"
+#include "server.h"
+#include "interactive.h"
+#include "wal.h"
+#include "archive.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** @brief Ustawienia programu podane w wierszu poleceń.
+ */
+typedef struct options
+{
+    flush_policy flush; ///< Sposób opróżniania bufora z odpowiedziami.
+    const char *input; /**< Ścieżka do pliku z poleceniami lub NULL,
+        jeśli polecenia są wczytywane ze standardowego wejścia. */
+    bool pipeline; /**< Czy po rozpoczęciu gry w trybie wsadowym polecenia
+        mają być wykonywane potokowo w trzech wątkach. */
+    uint parse_jobs; /**< Liczba wątków analizujących równolegle linie
+        po rozpoczęciu gry w trybie wsadowym. */
+    uint multi_jobs; /**< Liczba wątków wykonujących polecenia wielu gier
+        lub zero, jeśli program prowadzi jedną grę. */
+    const char *server; /**< Ścieżka gniazda serwera gier lub NULL,
+        jeśli program nie działa jako serwer. */
+    uint server_jobs; ///< Liczba wątków obsługujących połączenia serwera.
+    const char *wal; /**< Ścieżka dziennika ruchów lub NULL, jeśli ruchy
+        nie są zapisywane w dzienniku. */
+    const char *snapshot; /**< Ścieżka migawki, z której gra jest odtwarzana
+        i do której jest zapisywana na końcu, lub NULL. */
+    muint checkpoint_every; /**< Liczba ruchów w dzienniku, po których
+        migawka jest zapisywana w tle, lub zero. */
+    bool archive; /**< Czy zapisy gier z wejścia mają zostać zapisane
+        w archiwum na standardowym wyjściu. */
+    bool summary; ///< Czy wypisać podsumowania gier z archiwum na wejściu.
+} options;
+
 /**
- * Makro wymagane do poprawnego działania funkcji @ref getline.
+ * Przedrostek opcji wskazującej plik z poleceniami.
  */
-#define _GNU_SOURCE
+#define INPUT_OPTION "--input="
 
 /**
- * Oznaczenie końca pliku.
+ * Przedrostek opcji ustalającej liczbę wątków analizujących linie.
  */
-#define END -1
+#define PARSE_JOBS_OPTION "--parse-jobs="
 
 /**
- * Największa liczba dostępna w formacie uint.
+ * Przedrostek opcji włączającej tryb wielu gier.
  */
-#define MAXUINT 4294967295
+#define MULTI_OPTION "--multi"
 
-#include "gamma.h"
-#include "parser.h"
-#include "interactive.h"
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
+/**
+ * Przedrostek opcji uruchamiającej serwer gier na gnieździe lokalnym.
+ */
+#define SERVER_OPTION "--server="
+
+/**
+ * Przedrostek opcji ustalającej liczbę wątków serwera gier.
+ */
+#define SERVER_JOBS_OPTION "--server-jobs="
+
+/**
+ * Przedrostek opcji wskazującej dziennik ruchów.
+ */
+#define WAL_OPTION "--wal="
+
+/**
+ * Przedrostek opcji wskazującej migawkę stanu gry.
+ */
+#define SNAPSHOT_OPTION "--snapshot="
+
+/**
+ * Przedrostek opcji ustalającej, co ile ruchów zapisywać migawkę w tle.
+ */
+#define CHECKPOINT_OPTION "--checkpoint-every="
+
+/**
+ * Największa liczba wątków analizujących linie lub wykonujących polecenia.
+ */
+#define MAX_JOBS 256
 
-/** @brief Sprawdzenie czy dwa ciągi znaków są identyczne.
- * Funkcja pomocnicza w @ref interactive_game.
- * @param[in] A – pierwszy ciąg znaków,
- * @param[in] B – drugi ciąg znaków,
- * @return Wartość @p true
+/** @brief Wczytuje liczbę wątków podaną w opcji.
+ * Funkcja pomocnicza w @ref parse_options.
+ * @param[in] s     – napis z liczbą wątków,
+ * @param[out] jobs – wskaźnik na liczbę wątków.
+ * @return Wartość @p true, jeśli napis jest liczbą z przedziału
+ * od 1 do @ref MAX_JOBS, a @p false w przeciwnym razie.
  */
-inline static bool same_string(char *A, char *B)
+static bool parse_jobs(const char *s, uint *jobs)
 {
-    return strcmp(A, B) == 0;
+    char *end;
+    unsigned long value = strtoul(s, &end, 10);
+    if (*s < '0' || '9' < *s || *end != '\0' || value == 0 || MAX_JOBS < value)
+        return false;
+    *jobs = value;
+    return true;
 }
 
-/** @brief Funkcja konwertuje napis na liczbę.
- * Ciag znaków przy użyciu funkcji @ref strtoull jest przerabiany na liczbę
- * z zakresu uint, funkcja dodatkowo sprawdza też czy liczba nie jest zbyt
- * duża jak na ograniczenia w zadaniu.
+/** @brief Wczytuje dodatnią liczbę podaną w opcji.
+ * Funkcja pomocnicza w @ref parse_options.
+ * @param[in] s      – napis z liczbą,
+ * @param[out] count – wskaźnik na liczbę.
+ * @return Wartość @p true, jeśli napis jest liczbą dodatnią mieszczącą się
+ * w zakresie, a @p false w przeciwnym razie.
+ */
+static bool parse_count(const char *s, muint *count)
+{
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(s, &end, 10);
+    if (*s < '0' || '9' < *s || *end != '\0' || value == 0 || errno == ERANGE)
+        return false;
+    *count = value;
+    return true;
+}
+
+/** @brief Podaje domyślną liczbę wątków trybu wielu gier.
+ * Funkcja pomocnicza w @ref parse_options.
+ * @return Liczba dostępnych procesorów ograniczona przez @ref MAX_JOBS.
+ */
+static uint default_jobs(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+        return 1;
+    return cpus < MAX_JOBS ? cpus : MAX_JOBS;
+}
+
+/** @brief Analizuje argumenty wiersza poleceń.
+ * Domyślnie odpowiedzi wypisywane do terminala są przekazywane po każdym
+ * poleceniu, a wypisywane do pliku lub potoku dopiero po zapełnieniu bufora.
+ * Opcja @p --flush=line lub @p --flush=size wymusza jeden z tych sposobów.
+ * Opcja @p --input=plik powoduje wczytywanie poleceń z odwzorowanego
+ * w pamięci pliku zamiast ze standardowego wejścia.
+ * Opcja @p --pipeline włącza potokowe wykonywanie poleceń, a opcja
+ * @p --parse-jobs=n równoległe analizowanie linii przez @p n wątków.
+ * Opcja @p --multi lub @p --multi=n włącza tryb wielu gier, w którym
+ * polecenia są wykonywane przez @p n wątków, domyślnie po jednym
+ * na procesor, a każda linia odpowiedzi jest poprzedzona identyfikatorem
+ * gry. Opcja @p --server=ścieżka uruchamia serwer gier na gnieździe
+ * lokalnym, obsługiwany przez tyle wątków, ile podano w opcji
+ * @p --server-jobs=n, domyślnie po jednym na procesor.
+ * Opcja @p --snapshot=ścieżka odtwarza grę wsadową z migawki i zapisuje ją
+ * tam na końcu. Migawka jest zaufanym plikiem zapisanym przez program:
+ * przy starcie sprawdzani są tylko właściciele pól i liczniki graczy.
+ * Opcja @p --wal=ścieżka zapisuje udane ruchy w dzienniku odtwarzanym
+ * po awarii. Obie opcje dotyczą sekwencyjnego wykonywania poleceń jednej
+ * gry. Razem z nimi opcja @p --checkpoint-every=n zapisuje migawkę w tle
+ * co @p n ruchów zapisanych w dzienniku. Opcja @p --archive zapisuje gry
+ * z zapisów tekstowych w archiwum, a opcja @p --summary wypisuje
+ * podsumowania gier z archiwum.
  * Funkcja pomocnicza w @ref main.
- * @param[in] arg     – ciag znaków zawierający liczbę,
- * @param[in] result  – liczba wynikowa (referencja na nią),
- * @return Wartość @p true, jeśli napis @p arg zawierał poprawną liczbę
- * w formacie uint, a @p false w przeciwnym razie.
+ * @param[in] argc  – liczba argumentów wiersza poleceń,
+ * @param[in] argv  – argumenty wiersza poleceń,
+ * @param[out] opt  – wskaźnik na strukturę z ustawieniami programu.
+ * @return Wartość @p true, jeśli argumenty są poprawne,
+ * a @p false w przeciwnym razie.
  */
-static bool convert(char *arg, uint *result)
+static bool parse_options(int argc, char *argv[], options *opt)
 {
-    // Przypadek brzegowy - liczba zero,
-    if (same_string(arg, "\0"))
+    opt->flush = isatty(STDOUT_FILENO) ? FLUSH_LINE : FLUSH_SIZE;
+    opt->input = NULL;
+    opt->pipeline = false;
+    opt->parse_jobs = 1;
+    opt->multi_jobs = 0;
+    opt->server = NULL;
+    opt->server_jobs = default_jobs();
+    opt->wal = NULL;
+    opt->snapshot = NULL;
+    opt->checkpoint_every = 0;
+    opt->archive = false;
+    opt->summary = false;
+
+    for (int i = 1; i < argc; ++i)
     {
-        *result = 0;
-        return true;
+        if (strcmp(argv[i], "--flush=line") == 0)
+            opt->flush = FLUSH_LINE;
+        else if (strcmp(argv[i], "--flush=size") == 0)
+            opt->flush = FLUSH_SIZE;
+        else if (strcmp(argv[i], "--pipeline") == 0)
+            opt->pipeline = true;
+        else if (strncmp(argv[i], INPUT_OPTION, strlen(INPUT_OPTION)) == 0)
+            opt->input = argv[i] + strlen(INPUT_OPTION);
+        else if (strncmp(argv[i], PARSE_JOBS_OPTION, strlen(PARSE_JOBS_OPTION)) == 0)
+        {
+            if (parse_jobs(argv[i] + strlen(PARSE_JOBS_OPTION), &opt->parse_jobs) == false)
+                return false;
+        }
+        else if (strncmp(argv[i], SERVER_OPTION, strlen(SERVER_OPTION)) == 0)
+            opt->server = argv[i] + strlen(SERVER_OPTION);
+        else if (strncmp(argv[i], SERVER_JOBS_OPTION, strlen(SERVER_JOBS_OPTION)) == 0)
+        {
+            if (parse_jobs(argv[i] + strlen(SERVER_JOBS_OPTION), &opt->server_jobs) == false)
+                return false;
+        }
+        else if (strcmp(argv[i], MULTI_OPTION) == 0)
+            opt->multi_jobs = default_jobs();
+        else if (strncmp(argv[i], MULTI_OPTION "=", strlen(MULTI_OPTION "=")) == 0)
+        {
+            if (parse_jobs(argv[i] + strlen(MULTI_OPTION "="), &opt->multi_jobs) == false)
+                return false;
+        }
+        else if (strcmp(argv[i], "--archive") == 0)
+            opt->archive = true;
+        else if (strcmp(argv[i], "--summary") == 0)
+            opt->summary = true;
+        else if (strncmp(argv[i], WAL_OPTION, strlen(WAL_OPTION)) == 0)
+            opt->wal = argv[i] + strlen(WAL_OPTION);
+        else if (strncmp(argv[i], SNAPSHOT_OPTION, strlen(SNAPSHOT_OPTION)) == 0)
+            opt->snapshot = argv[i] + strlen(SNAPSHOT_OPTION);
+        else if (strncmp(argv[i], CHECKPOINT_OPTION, strlen(CHECKPOINT_OPTION)) == 0)
+        {
+            if (parse_count(argv[i] + strlen(CHECKPOINT_OPTION), &opt->checkpoint_every) == false)
+                return false;
+        }
+        else
+            return false;
     }
 
-    muint preresult = strtoull(arg, NULL, 10);
-    if (preresult <= MAXUINT)
+    // Archiwum jest zapisywane w całości na standardowe wyjście,
+    // więc nie ma sensu opróżniać bufora po każdej grze.
+    if (opt->archive)
+        opt->flush = FLUSH_SIZE;
+
+    // Archiwum i podsumowania wyłączają pozostałe tryby.
+    if ((opt->archive || opt->summary)
+        && ((opt->archive && opt->summary) || opt->multi_jobs != 0
+            || opt->server != NULL || opt->wal != NULL || opt->snapshot != NULL))
+        return false;
+
+    // Migawka w tle kończy dziennik, więc wymaga obu plików.
+    if (opt->checkpoint_every != 0 && (opt->wal == NULL || opt->snapshot == NULL))
+        return false;
+
+    // Dziennik i migawka opisują jedną grę wykonywaną sekwencyjnie.
+    return (opt->wal == NULL && opt->snapshot == NULL)
+        || (opt->pipeline == false && opt->parse_jobs == 1
+            && opt->multi_jobs == 0 && opt->server == NULL);
+}
+
+/** @brief Zapisuje w dzienniku polecenie, które zmieniło stan gry.
+ * Funkcja pomocnicza w @ref text_session.
+ * @param[in,out] log – wskaźnik na dziennik lub NULL,
+ * @param[in] cmd     – wskaźnik na wykonane polecenie,
+ * @param[in] res     – wskaźnik na odpowiedź na polecenie.
+ */
+static void log_command(wal *log, const command *cmd, const response *res)
+{
+    if (log == NULL)
+        return;
+
+    if (res->kind == RESPONSE_OK
+        || ((cmd->type == 'm' || cmd->type == 'g')
+            && res->kind == RESPONSE_NUMBER && res->value == 1))
     {
-        *result = (uint) preresult;
-        return true;
+        wal_append(log, cmd->type, cmd->args, cmd->arguments);
     }
-    return false;
 }
 
-/** @brief Funkcja wypisująca błąd (error).
- * Funkcja wypisuje wiadomosć na wyjscie stderr o błędzie podczas działania
- * programu, tj. że została wczytana błędna linia z argumentami.
+/** @brief Przeprowadza rozgrywkę w protokole tekstowym.
+ * Wczytuje kolejne linie poleceń aż do końca danych wejściowych i wykonuje
+ * je w trybie wsadowym, chyba że pierwszym poprawnym poleceniem jest @p I,
+ * które rozpoczyna rozgrywkę w trybie interaktywnym.
  * Funkcja pomocnicza w @ref main.
- * @param[in] line – numer linii gdzie nastąpił błąd.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err   – wskaźnik na strukturę zapisującą błędy,
+ * @param[in] opt       – wskaźnik na ustawienia programu, określające
+ *                        sposób wykonywania poleceń gry w trybie wsadowym,
+ * @param[in] game      – wskaźnik na grę odtworzoną z migawki i dziennika
+ *                        lub NULL, jeśli gra nie została jeszcze utworzona,
+ * @param[in,out] log   – wskaźnik na dziennik ruchów lub NULL.
+ * @return Wartość @p true, jeśli rozgrywka przebiegła bez błędów, a @p false,
+ * jeśli zabrakło pamięci, nie udało się zapisać dziennika lub migawki
+ * albo gra interaktywna zakończyła się błędem.
  */
-inline static void call_error(int line)
+static bool text_session(reader *input, writer *out, writer *err,
+                         const options *opt, gamma_t *game, wal *log)
 {
-    fprintf(stderr,"ERROR %d\n", line);
+    const char *line;
+    size_t len;
+    command cmd;
+    response res;
+    int line_cnt = 0, read, dir;
+    bool fine = true;
+
+    // Wczytywanie kolejnych linii poleceń aż do końca danych wejściowych.
+    while ((read = reader_next_line(input, &line, &len)) == 1)
+    {
+        // Licznik linii.
+        line_cnt++;
+
+        // Analiza wczytanego polecenia i przeparsowanie jego na argumenty.
+        dir = parse_line(line, len, &cmd);
+
+        // Pusta linia lub komentarz.
+        if (dir == -1)
+        {
+            continue;
+        }
+
+        // Wywołanie trybu interaktywnego,
+        // po grze interaktywnej program kończy działanie.
+        if (dir == 1 && game == NULL && cmd.type == 'I' && cmd.arguments == 4
+            && (game = gamma_new(cmd.args[0], cmd.args[1],
+                                 cmd.args[2], cmd.args[3])) != NULL)
+        {
+            writer_flush(err);
+            fine = interactive_game(game, cmd.args[0], cmd.args[1],
+                                    cmd.args[2], cmd.args[3]);
+            gamma_delete(game);
+            game = NULL;
+            break;
+        }
+
+        // Komenda trybu wsadowego lub błędne polecenie.
+        if (dir == 1)
+        {
+            execute_command(&game, &cmd, &res);
+            log_command(log, &cmd, &res);
+
+            // Co zadaną liczbę ruchów migawka jest zapisywana w tle.
+            if (log != NULL && game != NULL && opt->checkpoint_every != 0
+                && opt->checkpoint_every <= log->since_checkpoint)
+                wal_checkpoint_start(log, game, opt->snapshot, err);
+        }
+        else
+        {
+            response_init(&res);
+        }
+        print_response(out, err, line_cnt, &res);
+
+        // Bez działającego dziennika nie potwierdzamy kolejnych ruchów.
+        if (log != NULL && log->failed)
+        {
+            fine = false;
+            break;
+        }
+
+        // Dalsze polecenia gry w trybie wsadowym mogą być
+        // analizowane równolegle albo wykonywane potokowo.
+        if (game != NULL && 1 < opt->parse_jobs)
+        {
+            fine = parallel_session(input, out, err, game, line_cnt, opt->parse_jobs);
+            break;
+        }
+        else if (game != NULL && opt->pipeline)
+        {
+            fine = pipeline_session(input, out, err, game, line_cnt);
+            break;
+        }
+    }
+
+    // Migawka kończy dziennik, który od tej chwili zaczyna się od nowa.
+    if (game != NULL && opt->snapshot != NULL)
+    {
+        if (log != NULL)
+            fine = wal_checkpoint(log, game, opt->snapshot) && fine;
+        else
+            fine = gamma_save(game, opt->snapshot) && fine;
+    }
+
+    gamma_delete(game);
+    return fine && read != -1;
 }
 
 /** @brief Główna część programu - wykonywanie działań zadanych przez wczytane komendy.
@@ -90,161 +394,101 @@ inline static void call_error(int line)
  * @return Wartość @p 0, jeśli program zakończył wykonywanie
  * poleceń bez żadnych błedów, a @p 1 jeśli napotkał błąd z alokacją pamięci.
  */
-int main()
+int main(int argc, char *argv[])
 {
     // Deklaracja zmiennych używanych przez program.
-    size_t mem;
-    char *line = NULL, *command = NULL,
-         *arg1 = NULL, *arg2 = NULL, *arg3 = NULL, *arg4 = NULL;
-    int line_cnt = 0, com_len = 0, arg_len1 = 0,
-        arg_len2 = 0, arg_len3 = 0, arg_len4 = 0,
-        read, dir, arguments;
-    uint argument1, argument2, argument3, argument4;
+    options opt;
+    reader input;
+    writer out, err;
+    wal log;
     gamma_t *game = NULL;
     bool error_occured = false;
-    bool game_allocated = false;
 
-    // Wczytywanie kolejnych linii poleceń aż do momentu wczytanie End of File.
-    while (error_occured == false && (read = getline(&line, &mem, stdin)) != END)
+    if (parse_options(argc, argv, &opt) == false)
     {
-        // Licznik linii.
-        line_cnt++;
-
-        // Analiza wczytanego polecenia i przeparsowanie jego na argumenty.
-        dir = analyse_line(line, read, &command, &arg1, &arg2, &arg3, &arg4,
-               &com_len, &arg_len1, &arg_len2, &arg_len3, &arg_len4, &arguments, &error_occured);
+        fprintf(stderr, "Usage: %s [--flush=line|--flush=size] [--input=FILE]"
+                " [--pipeline] [--parse-jobs=N] [--multi[=N]]"
+                " [--server=PATH [--server-jobs=N]]"
+                " [--snapshot=FILE] [--wal=FILE] [--checkpoint-every=N]"
+                " [--archive|--summary]\n"
+                "A --snapshot FILE is trusted input: it must be written by"
+                " this program; only board owners and player counts are checked.\n",
+                argv[0]);
+        exit(1);
+    }
 
-        // Wyjście awaryjne z powodu braku pamięci.
-        if (error_occured)
+    // Serwer gier nie korzysta ze standardowego wejścia i wyjścia.
+    if (opt.server != NULL)
+    {
+        if (server_session(opt.server, opt.server_jobs) == false)
         {
-            break;
+            perror(opt.server);
+            exit(1);
         }
+        return 0;
+    }
 
-        // Próba rozpoczecia jednego z dwóch rodzai rozgrywki.
-        if (dir == 1 && convert(arg1, &argument1) && convert(arg2, &argument2)
-            && convert(arg3, &argument3) && convert(arg4, &argument4))
-        {
-            if (game == NULL && arguments == 4)
-            {
-                if (same_string(command,"B"))
-                {
-                    // Wywołanie trybu wsadowego.
-                    if ((game = gamma_new(argument1, argument2,
-                            argument3, argument4)) != NULL)
-                    {
-                        game_allocated = true;
-                        printf("OK %d\n", line_cnt);
-                    }
-                    else
-                    {
-                        call_error(line_cnt);
-                    }
-                }
-                else if (same_string(command,"I"))
-                {
-                    // Wywołanie trybu interaktywnego.
-                    if ((game = gamma_new(argument1, argument2,
-                            argument3, argument4)) != NULL)
-                    {
-                        game_allocated = true;
-                        error_occured = interactive_game(game, argument1, argument2,
-                                argument3, argument4) == false;
-
-                        // Po grze interaktywnej program kończy działanie.
-                        free(command);
-                        free(arg1);
-                        free(arg2);
-                        free(arg3);
-                        free(arg4);
-                        break;
-                    }
-                    else
-                    {
-                        call_error(line_cnt);
-                    }
-                }
-                else
-                {
-                    call_error(line_cnt);
-                }
-            }
-            // Komenda modyfikująca rozgrywkę w trybie wsadowym.
-            else if (game != NULL)
-            {
-                // Wywołanie zwykłego ruchu.
-                if (same_string(command, "m") && arguments == 3)
-                {
-                    bool response = gamma_move(game, argument1, argument2, argument3);
-                    printf("%d\n",response);
-                }
-                // Wywołanie złotego ruchu.
-                else if (same_string(command, "g") && arguments == 3)
-                {
-                    bool response = gamma_golden_move(game, argument1, argument2, argument3);
-                    printf("%d\n",response);
-                }
-                // Wywołanie liczby zajętych pól.
-                else if (same_string(command, "b") && arguments == 1)
-                {
-                    muint response = gamma_busy_fields(game, argument1);
-                    printf("%ld\n", response);
-                }
-                // Wywołanie liczby wolnych pól danego gracza.
-                else if (same_string(command, "f") && arguments == 1)
-                {
-                    muint response = gamma_free_fields(game, argument1);
-                    printf("%ld\n", response);
-                }
-                // Pytanie o możliwość wykonania złotego ruchu.
-                else if (same_string(command, "q") && arguments == 1)
-                {
-                    bool response = gamma_golden_possible(game, argument1);
-                    printf("%d\n", response);
-                }
-                // Wyświetlenie planszy aktualnego stanu rozgrywki.
-                else if (same_string(command, "p") && arguments == 0)
-                {
-                    char *response = gamma_board(game);
-                    if (response == NULL)
-                    {
-                        call_error(line_cnt);
-                    }
-                    else
-                    {
-                        printf("%s", response);
-                        free(response);
-                    }
-                }
-                else
-                {
-                    call_error(line_cnt);
-                }
-            }
-            else
-            {
-                call_error(line_cnt);
-            }
-        }
-        // Błędne polecenie.
-        else if (dir != -1)
-        {
-            call_error(line_cnt);
-        }
+    // Odtworzenie gry z ostatniej migawki i dopisanych po niej ruchów.
+    // Właściciele pól są sprawdzani raz, zanim gra zacznie ich używać.
+    if (opt.snapshot != NULL && access(opt.snapshot, F_OK) == 0
+        && ((game = gamma_map(opt.snapshot)) == NULL || gamma_check(game) == false))
+    {
+        gamma_delete(game);
+        fprintf(stderr, "%s: invalid snapshot\n", opt.snapshot);
+        exit(1);
+    }
+    if (opt.wal != NULL && wal_open(&log, opt.wal, &game) == false)
+    {
+        perror(opt.wal);
+        exit(1);
+    }
 
-        // Przygotowanie pamięci pod kolejne polecenie.
-        free(command);
-        free(arg1);
-        free(arg2);
-        free(arg3);
-        free(arg4);
+    if (opt.input != NULL && reader_init_file(&input, opt.input) == false)
+    {
+        perror(opt.input);
+        exit(1);
     }
 
-    // Oczyszczenie pamieci pod koniec programu.
-    free(line);
-    if (game_allocated)
+    if ((opt.input == NULL && reader_init(&input, STDIN_FILENO) == false)
+        || writer_init(&out, STDOUT_FILENO, opt.flush) == false
+        || writer_init(&err, STDERR_FILENO, opt.flush) == false)
     {
-        gamma_delete(game);
+        exit(1);
+    }
+
+    if (opt.wal != NULL)
+        wal_attach(&log, &out);
+
+    // Wybór protokołu na podstawie początku danych wejściowych.
+    // Dziennik i migawka obsługują tylko protokół tekstowy.
+    if (opt.archive)
+    {
+        error_occured = archive_session(&input, &out) == false;
+    }
+    else if (opt.summary)
+    {
+        error_occured = summary_session(&input, &out, &err) == false;
     }
+    else if (opt.wal == NULL && opt.snapshot == NULL && binary_magic(&input))
+    {
+        binary_session(&input, &out);
+    }
+    else if (0 < opt.multi_jobs)
+    {
+        error_occured = multi_session(&input, &out, &err, opt.multi_jobs) == false;
+    }
+    else
+    {
+        error_occured = text_session(&input, &out, &err, &opt, game,
+                                     opt.wal != NULL ? &log : NULL) == false;
+    }
+
+    // Oczyszczenie pamieci pod koniec programu.
+    reader_free(&input);
+    writer_free(&out);
+    writer_free(&err);
+    if (opt.wal != NULL && wal_close(&log) == false)
+        error_occured = true;
 
     // Zakomunikowanie błędu.
     if (error_occured)
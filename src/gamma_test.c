@@ -32,6 +32,21 @@ static const char board[] =
         "1221......\n"
         "1.........\n";
 
+/**
+ * Tak ma wyglądać plansza zakodowana długościami serii.
+ */
+static const char rle_board[] =
+        "1 .*9\n"
+        ".*10\n"
+        "=1\n"
+        ".*6 2 .*3\n"
+        ".*5 2 .*4\n"
+        ".*10\n"
+        "=1\n"
+        "1 .*9\n"
+        "1 2*2 1 .*6\n"
+        "1 .*9\n";
+
 /** @brief Testuje silnik gry gamma.
  * Przeprowadza przykładowe testy silnika gry gamma.
  * @return Zero, gdy wszystkie testy przebiegły poprawnie,
@@ -95,7 +110,196 @@ int main()
     printf("%s", p);
     free(p);
 
+    p = gamma_board_rle(g);
+    assert(p);
+    assert(strcmp(p, rle_board) == 0);
+    free(p);
+
+    muint count;
+    field_change *changes = gamma_changes(g, 0, &count);
+    assert(changes != NULL);
+    assert(count == 9);
+    assert(changes[0].x == 0 && changes[0].y == 0 && changes[0].owner == 1);
+    free(changes);
+
+    muint epoch = gamma_epoch(g);
+    assert(gamma_move(g, 2, 7, 6));
+    assert(gamma_move(g, 2, 8, 6));
+    changes = gamma_changes(g, epoch, &count);
+    assert(changes != NULL);
+    assert(count == 2);
+    assert(changes[0].x == 7 && changes[0].y == 6 && changes[0].owner == 2);
+    assert(changes[1].x == 8 && changes[1].y == 6 && changes[1].owner == 2);
+    free(changes);
+    assert(gamma_changes(g, epoch + 3, &count) == NULL);
+
+    gamma_delete(g);
+
+    g = gamma_new(1200, 1000, 1, 1);
+    assert(gamma_move(g, 1, 0, 0));
+    epoch = gamma_epoch(g);
+    for (uint x = 0; x < 1200; ++x)
+        for (uint y = x == 0; y < 1000; ++y)
+            assert(gamma_move(g, 1, x, y));
+    assert(gamma_changes(g, epoch, &count) == NULL);
+    changes = gamma_changes(g, gamma_epoch(g) - 1000, &count);
+    assert(changes != NULL && count == 1000);
+    assert(changes[0].x == 1199 && changes[0].y == 0 && changes[0].owner == 1);
+    free(changes);
+    gamma_delete(g);
+
+    const move moves[] = {{1, 0, 0}, {2, 3, 1}, {1, 0, 0}, {3, 1, 1},
+                          {1, 10, 0}, {1, 0, 1}, {2, 2, 1}};
+    bool results[7];
+    g = gamma_new(10, 10, 2, 3);
+    assert(gamma_move_batch(g, moves, 7, results) == 4);
+    assert(results[0] && results[1] && !results[2] && !results[3]);
+    assert(!results[4] && results[5] && results[6]);
+    assert(gamma_busy_fields(g, 1) == 2);
+    const move golden[] = {{1, 3, 1}, {1, 2, 1}, {2, 0, 0}};
+    assert(gamma_golden_move_batch(g, golden, 3, results) == 2);
+    assert(results[0] && !results[1] && results[2]);
+    assert(gamma_move_batch(NULL, moves, 7, NULL) == 0);
+    gamma_delete(g);
+
+    const field_change position[] = {{0, 0, 1}, {1, 0, 1}, {0, 1, 2},
+                                     {2, 2, 1}, {2, 2, 2}, {1, 2, 2}};
+    g = gamma_new(3, 3, 2, 2);
+    assert(gamma_set_fields(g, position, 6));
+    assert(gamma_busy_fields(g, 1) == 2);
+    assert(gamma_busy_fields(g, 2) == 3);
+    assert(gamma_owner(g, 2, 2) == 2 && gamma_owner(g, 1, 1) == 0);
+    assert(gamma_owner(g, 3, 0) == 0 && gamma_owner(NULL, 0, 0) == 0);
+    assert(gamma_areas(g, 2) == 2);
+    assert(gamma_free_fields(g, 2) == 3);
+    assert(!gamma_move(g, 2, 2, 0));
+    assert(gamma_move(g, 2, 1, 1));
+    assert(gamma_areas(g, 2) == 1);
+    const field_change scattered[] = {{0, 2, 1}, {2, 1, 1}};
+    assert(!gamma_set_fields(g, scattered, 2));
+    assert(gamma_busy_fields(g, 1) == 2);
+    assert(gamma_rebuild_areas(g, 2));
+    assert(gamma_areas(g, 1) == 1 && gamma_areas(g, 2) == 1);
+    assert(gamma_free_fields(g, 2) == 3);
+    assert(!gamma_rebuild_areas(NULL, 2));
+    gamma_t *wide = gamma_new(1000, 1, 2, 1);
+    bool answers[3];
+    assert(gamma_move(wide, 1, 0, 0) && gamma_move(wide, 2, 1, 0));
+    assert(gamma_rebuild_areas(wide, 100000));
+    assert(gamma_areas(wide, 1) == 1 && gamma_areas(wide, 2) == 1);
+    assert(gamma_golden_possible_all(wide, answers, 100000));
+    assert(answers[1] && answers[2]);
+    gamma_delete(wide);
+
+    assert(gamma_save(g, "gamma_test.snapshot"));
+    gamma_t *loaded = gamma_load("gamma_test.snapshot");
+    assert(loaded != NULL);
+    assert(remove("gamma_test.snapshot") == 0);
+    char *before = gamma_board(g);
+    char *after = gamma_board(loaded);
+    assert(strcmp(before, after) == 0);
+    free(before);
+    free(after);
+    assert(gamma_change_count(loaded) == gamma_change_count(g));
+    assert(gamma_change_count(NULL) == 0);
+    assert(gamma_areas(loaded, 2) == 1 && gamma_free_fields(loaded, 2) == 3);
+    assert(gamma_golden_possible(loaded, 1));
+    assert(gamma_move(loaded, 1, 2, 0) == gamma_move(g, 1, 2, 0));
+    assert(gamma_busy_fields(loaded, 1) == gamma_busy_fields(g, 1));
+    assert(gamma_save(g, "gamma_test.snapshot"));
+    gamma_t *mapped = gamma_map("gamma_test.snapshot");
+    assert(mapped != NULL);
+    assert(gamma_busy_fields(mapped, 2) == gamma_busy_fields(g, 2));
+    assert(gamma_move(mapped, 1, 0, 2) && gamma_areas(mapped, 1) == 2);
+    gamma_delete(mapped);
+    mapped = gamma_map("gamma_test.snapshot");
+    assert(mapped != NULL && gamma_areas(mapped, 1) == 1);
+    assert(gamma_check(mapped) && gamma_check(g) && !gamma_check(NULL));
+    gamma_delete(mapped);
+    const unsigned owner = 9;
+    FILE *file = fopen("gamma_test.snapshot", "r+b");
+    assert(file != NULL && fseek(file, 4096, SEEK_SET) == 0);
+    assert(fwrite(&owner, sizeof(owner), 1, file) == 1);
+    fclose(file);
+    mapped = gamma_map("gamma_test.snapshot");
+    assert(mapped != NULL && !gamma_check(mapped));
+    gamma_delete(mapped);
+    assert(gamma_load("gamma_test.snapshot") == NULL);
+    char page[4096];
+    file = fopen("gamma_test.snapshot", "rb");
+    assert(file != NULL);
+    size_t kept = fread(page, 1, sizeof(page), file);
+    fclose(file);
+    file = fopen("gamma_test.snapshot", "wb");
+    assert(file != NULL && fwrite(page, 1, kept, file) == kept);
+    fclose(file);
+    assert(gamma_load("gamma_test.snapshot") == NULL);
+    assert(gamma_map("gamma_test.snapshot") == NULL);
+    // Wymiary 2^31 x 2^31, dla których rozmiar tablic przekręca licznik.
+    const unsigned char huge[] = {0, 0, 0, 0x80, 0, 0, 0, 0x80};
+    const unsigned char wrapped[] = {0, 0x10, 0, 0, 0, 0, 0, 0};
+    file = fopen("gamma_test.snapshot", "r+b");
+    assert(file != NULL && fseek(file, 16, SEEK_SET) == 0);
+    assert(fwrite(huge, sizeof(huge), 1, file) == 1);
+    assert(fseek(file, 72, SEEK_SET) == 0);
+    assert(fwrite(wrapped, sizeof(wrapped), 1, file) == 1);
+    fclose(file);
+    assert(gamma_load("gamma_test.snapshot") == NULL);
+    assert(gamma_map("gamma_test.snapshot") == NULL);
+    assert(remove("gamma_test.snapshot") == 0);
+    assert(gamma_load("gamma_test.snapshot") == NULL);
+    assert(gamma_map("gamma_test.snapshot") == NULL);
+    assert(!gamma_save(NULL, "gamma_test.snapshot"));
+    gamma_delete(loaded);
+    gamma_delete(g);
+
+    g = gamma_new(4, 4, 2, 4);
+    assert(gamma_history(g, 2));
+    assert(gamma_move(g, 1, 0, 0) && gamma_move(g, 2, 1, 0));
+    assert(!gamma_move(g, 1, 1, 0));
+    assert(gamma_move_batch(g, moves, 3, NULL) == 1);
+    assert(gamma_golden_move(g, 1, 1, 0));
+    assert(gamma_history_length(g) == 4);
+    gamma_t *past = gamma_seek(g, 3);
+    assert(past != NULL && gamma_busy_fields(past, 2) == 2);
+    assert(gamma_golden_possible(past, 1));
+    gamma_delete(past);
+    assert(gamma_history(g, 3));
+    past = gamma_seek(g, 4);
+    before = gamma_board(g);
+    after = gamma_board(past);
+    assert(strcmp(before, after) == 0);
+    free(before);
+    free(after);
+    gamma_delete(past);
+    assert(gamma_seek(g, 5) == NULL);
+    assert(gamma_set_fields(g, position, 1));
+    assert(gamma_history_length(g) == 0 && gamma_seek(g, 0) == NULL);
     gamma_delete(g);
+
+    g = gamma_new(3, 1, 2, 1);
+    assert(gamma_history(g, 1) && gamma_move(g, 1, 0, 0));
+    const field_change apart[] = {{2, 0, 1}};
+    assert(!gamma_set_fields(g, apart, 1));
+    assert(gamma_set_fields(g, NULL, 0));
+    assert(gamma_history_length(g) == 1 && gamma_owner(g, 2, 0) == 0);
+    gamma_delete(g);
+
+    g = gamma_new(2, 1, 2, 1);
+    assert(gamma_move(g, 1, 0, 0));
+    assert(!gamma_game_over(g));
+    assert(gamma_move(g, 2, 1, 0));
+    assert(gamma_golden_possible(g, 1) && !gamma_game_over(g));
+    bool possible[3];
+    assert(gamma_golden_possible_all(g, possible, 2));
+    assert(!possible[0] && possible[1] && possible[2]);
+    assert(!gamma_golden_possible_all(g, possible, 0));
+    assert(gamma_golden_move(g, 1, 1, 0));
+    assert(gamma_golden_move(g, 2, 0, 0));
+    assert(!gamma_golden_possible(g, 1) && gamma_game_over(g));
+    assert(gamma_game_over(NULL));
+    gamma_delete(g);
+
     printf("Engine test conclude with success.\n");
     return 0;
 }
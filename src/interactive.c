@@ -7,6 +7,11 @@
  * @date 22 maja 2020
  */
 
+/**
+ * Makro wymagane do poprawnego działania funkcji @ref clock_gettime.
+ */
+#define _GNU_SOURCE
+
 /**
  * Stała oznaczająca naciśnięcie kombinacji klawiszy Ctrl-D.
  */
@@ -17,11 +22,26 @@
  */
 #define ESC '\033'
 
+/**
+ * Rozmiar bufora wczytywanych klawiszy.
+ */
+#define INPUT_SIZE 4096
+
+/**
+ * Najmniejszy odstęp w milisekundach między klatkami rysowanymi
+ * podczas obsługi serii klawiszy.
+ */
+#define FRAME_INTERVAL 16
+
+#include <errno.h>
+#include <poll.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <sys/ioctl.h>
 #include "gamma.h"
+#include "screen.h"
 
 /**
  * Numer wiersza na którym znajduje się aktualnie kursor.
@@ -43,6 +63,56 @@ static uint width;
  */
 static uint height;
 
+/**
+ * Numer pierwszej kolumny planszy widocznej na ekranie.
+ */
+static uint view_x;
+
+/**
+ * Numer najniższego wiersza planszy widocznego na ekranie.
+ */
+static uint view_y;
+
+/**
+ * Liczba kolumn planszy widocznych na ekranie.
+ */
+static uint view_width;
+
+/**
+ * Liczba wierszy planszy widocznych na ekranie.
+ */
+static uint view_height;
+
+/**
+ * Liczba kolumn ekranu zajmowanych przez jedno pole planszy.
+ */
+static uint cell_size;
+
+/**
+ * Maksymalna liczba obszarów, jakie może zająć jeden gracz.
+ */
+static uint areas_limit;
+
+/**
+ * Ekran, na którym rysowane są kolejne klatki gry.
+ */
+static screen display;
+
+/**
+ * Bufor wczytanych, jeszcze nieprzetworzonych klawiszy.
+ */
+static char input[INPUT_SIZE];
+
+/**
+ * Liczba bajtów w buforze klawiszy.
+ */
+static size_t input_len;
+
+/**
+ * Numer pierwszego nieprzetworzonego bajtu w buforze klawiszy.
+ */
+static size_t input_pos;
+
 /**
  * Pomocnicza zmienna do trzymania ustawień konsoli
  * sprzed wywowałaniem funkcji @ref interactive_game.
@@ -64,6 +134,7 @@ static void setup_console()
     new_term.c_lflag &= ~(ICANON | ECHO);
     tcsetattr(STDIN_FILENO, TCSANOW, &new_term);
     printf("\x1b[?25l");
+    fflush(stdout);
 }
 
 /** @brief Wycofuje zmiany w konsoli.
@@ -72,17 +143,62 @@ static void restore_console()
 {
     printf("\x1b[?25h");
     printf("\x1b[0m");
+    fflush(stdout);
     tcsetattr(STDIN_FILENO, TCSANOW, &old_term);
 }
 
-/** @brief Czyści konsole.
+/** @brief Podaje czas zegara monotonicznego.
+ * @return Liczba milisekund od ustalonej chwili w przeszłości.
  */
-static void clear_screen()
+static muint clock_ms()
 {
-    printf("\033[2J");
-    printf("\033[J");
-    printf("\033[H");
-    printf("\033[1;1H");
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (muint) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/** @brief Wczytuje do pustego bufora wszystkie dostępne klawisze.
+ * Czeka na klawisze najwyżej @p timeout milisekund, a dla wartości ujemnej
+ * bez ograniczenia, po czym jednym wywołaniem @p read pobiera wszystko,
+ * co jest dostępne.
+ * @param[in] timeout – najdłuższy czas oczekiwania w milisekundach.
+ * @return Wartość @p 1, jeśli wczytano klawisze, @p 0, jeśli upłynął czas
+ * oczekiwania, a @p -1, jeśli wejście się skończyło lub wystąpił błąd.
+ */
+static int fill_input(int timeout)
+{
+    struct pollfd fd = {STDIN_FILENO, POLLIN, 0};
+    int ready;
+    do
+    {
+        ready = poll(&fd, 1, timeout);
+    } while (ready == -1 && errno == EINTR);
+    if (ready <= 0)
+        return ready;
+
+    ssize_t got;
+    do
+    {
+        got = read(STDIN_FILENO, input, INPUT_SIZE);
+    } while (got == -1 && errno == EINTR);
+    if (got <= 0)
+        return -1;
+
+    input_len = got;
+    input_pos = 0;
+    return 1;
+}
+
+/** @brief Podaje kolejny klawisz z bufora.
+ * Jeśli bufor jest pusty, czeka na kolejne klawisze.
+ * @return Kolejny bajt wejścia lub @ref INSTANT_END, jeśli wejście
+ * się skończyło.
+ */
+static char next_key()
+{
+    if (input_pos == input_len && fill_input(-1) != 1)
+        return INSTANT_END;
+    return input[input_pos++];
 }
 
 /** @brief Funkcja pobiera wartość długości terminala.
@@ -137,48 +253,110 @@ inline static void down_move()
         cursor_x++;
 }
 
-/** @brief Wyświetla aktualny stan planszy.
- * Funkcja najpierw czyści konsole, potem wyświetla aktualny stan planszy.
- * Część pomocnicza w @ref interactive_game.
- * @param[in] game             – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] current_player   – identyfikator gracza, którego jest tura.
- * @param[in] margin         – zmienna pomocnicza do środkowa planszy,
- *                           tj. odległość planszy od lewej ściany terminala.
+/** @brief Przesuwa widoczny fragment planszy tak, żeby zawierał kursor.
+ * Fragment jest przesuwany o najmniejszą możliwą liczbę pól.
  */
-inline static void show(gamma_t *game, uint current_player, uint margin)
+static void follow_cursor()
 {
-    clear_screen();
-    show_board(game, cursor_x, cursor_y, current_player, margin);
+    if (cursor_y < view_x)
+        view_x = cursor_y;
+    else if (cursor_y >= view_x + view_width)
+        view_x = cursor_y - view_width + 1;
+    if (cursor_x < view_y)
+        view_y = cursor_x;
+    else if (cursor_x >= view_y + view_height)
+        view_y = cursor_x - view_height + 1;
 }
 
-/** @brief Sprawdzenie czy na planszy są pola niezajęte przez graczy.
- * Funkcja pomocnicza w @ref interactive_game.
- * @param[in] game   – wskaźnik na strukturę przechowującą stan gry.
- * @return Wartość @p true, jeśli są jeszcze niezajęte pola w tej rozgrywce,
- * a @p false w przeciwnym przypadku.
+/** @brief Ustawia widoczny fragment planszy na środku względem kursora.
+ * @param[in] first   – numer pola pod kursorem,
+ * @param[in] visible – liczba widocznych pól,
+ * @param[in] total   – liczba wszystkich pól.
+ * @return Numer pierwszego widocznego pola.
  */
-inline static bool free_fields_available(gamma_t *game)
+static uint center_view(uint first, uint visible, uint total)
 {
-    muint area = width;
-    area *= height;
-    return gamma_all_busy_fields(game) < area;
+    if (first < visible/2)
+        return 0;
+    first -= visible/2;
+    return first + visible > total ? total - visible : first;
 }
 
-/** @brief Sprawdzenie czy można kontynuowąć rozgrywkę.
- * Funkcja pomocnicza w @ref interactive_game.
- * @param[in] game     – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] players  – liczba graczy biorących udział w grze.
- * @return Wartość @p true, jeśli są jeszcze niezajęte pola w tej rozgrywce,
- * a @p false w przeciwnym przypadku.
+/** @brief Rysuje zawartość jednego pola planszy.
+ * Numer gracza jest wyrównany do prawej krawędzi pola, a puste pole
+ * jest oznaczone kropką.
+ * @param[in] owner – numer gracza zajmującego pole lub zero.
  */
-inline static bool game_in_progress(gamma_t *game, uint players)
+static void draw_cell(uint owner)
 {
-    if (free_fields_available(game))
-        return true;
-    for (uint i = 1; i <= players; ++i)
-        if (gamma_golden_possible(game, i))
-            return true;
-    return false;
+    uint len = owner == 0 ? 1 : ceil_log(owner);
+    if (len < cell_size)
+        screen_repeat(&display, " ", cell_size - len);
+    if (owner == 0)
+        screen_put(&display, ".");
+    else
+        screen_put_number(&display, owner);
+}
+
+/** @brief Rysuje widoczny fragment planszy w ramce.
+ * Ramka zaczyna się w drugim wierszu ekranu. Jeśli plansza nie mieści się
+ * w terminalu, w pierwszym wierszu wypisywana jest pozycja kursora.
+ * Pola gracza @p player są
+ * podświetlone na zielono, a jeśli gracz zajął już wszystkie dozwolone
+ * obszary, na czerwono. Pole pod kursorem jest podświetlone na niebiesko.
+ * Część pomocnicza w @ref interactive_game.
+ * @param[in] game   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – identyfikator gracza, którego jest tura, lub zero,
+ * @param[in] margin – odległość planszy od lewej ściany terminala,
+ * @param[in] cursor – czy rysować kursor.
+ */
+static void draw_board(gamma_t *game, uint player, uint margin, bool cursor)
+{
+    style own = STYLE_PLAIN;
+    if (player != 0)
+        own = gamma_areas(game, player) < areas_limit ? STYLE_OWN : STYLE_OWN_FULL;
+
+    screen_style(&display, STYLE_PLAIN);
+    if (view_width < width || view_height < height)
+    {
+        screen_move(&display, 0, margin);
+        screen_put(&display, "x: ");
+        screen_put_number(&display, cursor_y);
+        screen_put(&display, "/");
+        screen_put_number(&display, width - 1);
+        screen_put(&display, "  y: ");
+        screen_put_number(&display, cursor_x);
+        screen_put(&display, "/");
+        screen_put_number(&display, height - 1);
+    }
+
+    screen_move(&display, 1, margin);
+    screen_put(&display, "╔");
+    screen_repeat(&display, "═", view_width * cell_size);
+    screen_put(&display, "╗");
+
+    for (uint row = 0; row < view_height; ++row)
+    {
+        uint y = view_y + view_height - row - 1;
+        screen_move(&display, row + 2, margin);
+        screen_put(&display, "║");
+        for (uint x = view_x; x < view_x + view_width; ++x)
+        {
+            uint owner = gamma_owner(game, x, y);
+            if (cursor && y == cursor_x && x == cursor_y)
+                screen_style(&display, STYLE_CURSOR);
+            else if (player != 0 && owner == player)
+                screen_style(&display, own);
+            draw_cell(owner);
+            screen_style(&display, STYLE_PLAIN);
+        }
+        screen_put(&display, "║");
+    }
+
+    screen_move(&display, view_height + 2, margin);
+    screen_put(&display, "╚");
+    screen_repeat(&display, "═", view_width * cell_size);
+    screen_put(&display, "╝");
 }
 
 /** @brief Wyświetla aktualny stan gry gracza @p current_player.
@@ -198,32 +376,78 @@ static void general_info(gamma_t *game, uint current_player, uint max_areas, uin
 {
     uint cur_areas = gamma_areas(game, current_player);
     uint cur_fields = gamma_busy_fields(game, current_player);
+    uint row = view_height + 3;
 
-    // Poniższe spacje przed kodem koloru
+    // Poniższe spacje przed opisami
     // mają na celu zrównąć połeżenie wszystkich poleceń.
-    push(margin);
-    printf("        \e[1;36mGame Status:\n");
-
-    push(margin);
-    printf("         \e[0;37mPlayer:\e[1;37m %d\n", current_player);
-
-    push(margin);
-    printf("         \e[0;37mPoints:\e[1;37m %d\n", cur_fields);
-
-    push(margin);
-    printf("          \e[0;37mAreas: \e[1;32m");
-    if (cur_areas == max_areas)
-        printf("\e[1;31m");
-    printf("%d/%d\n", cur_areas, max_areas);
-
-    push(margin);
+    screen_move(&display, row++, margin);
+    screen_put(&display, "        ");
+    screen_style(&display, STYLE_TITLE);
+    screen_put(&display, "Game Status:");
+
+    screen_move(&display, row++, margin);
+    screen_style(&display, STYLE_PLAIN);
+    screen_put(&display, "         ");
+    screen_style(&display, STYLE_LABEL);
+    screen_put(&display, "Player:");
+    screen_style(&display, STYLE_VALUE);
+    screen_put(&display, " ");
+    screen_put_number(&display, current_player);
+
+    screen_move(&display, row++, margin);
+    screen_style(&display, STYLE_PLAIN);
+    screen_put(&display, "         ");
+    screen_style(&display, STYLE_LABEL);
+    screen_put(&display, "Points:");
+    screen_style(&display, STYLE_VALUE);
+    screen_put(&display, " ");
+    screen_put_number(&display, cur_fields);
+
+    screen_move(&display, row++, margin);
+    screen_style(&display, STYLE_PLAIN);
+    screen_put(&display, "          ");
+    screen_style(&display, STYLE_LABEL);
+    screen_put(&display, "Areas: ");
+    screen_style(&display, cur_areas == max_areas ? STYLE_BAD : STYLE_GOOD);
+    screen_put_number(&display, cur_areas);
+    screen_put(&display, "/");
+    screen_put_number(&display, max_areas);
+
+    screen_move(&display, row, margin);
+    screen_style(&display, STYLE_LABEL);
+    screen_put(&display, "Golden Possible: ");
     if (gamma_golden_possible(game, current_player))
-        printf("\e[0;37mGolden Possible: \e[1;32mYes\n");
+    {
+        screen_style(&display, STYLE_GOOD);
+        screen_put(&display, "Yes");
+    }
     else
-        printf("\e[0;37mGolden Possible: \e[1;31mNo\n");
-    printf("\033[0m");
+    {
+        screen_style(&display, STYLE_BAD);
+        screen_put(&display, "No");
+    }
+    screen_style(&display, STYLE_PLAIN);
+}
+
+/** @brief Wyświetla aktualny stan planszy.
+ * Funkcja rysuje nową klatkę z widocznym fragmentem planszy i stanem gry
+ * gracza, a następnie
+ * wysyła do terminala tylko pola, które zmieniły się od poprzedniej klatki.
+ * Część pomocnicza w @ref interactive_game.
+ * @param[in] game             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] current_player   – identyfikator gracza, którego jest tura.
+ * @param[in] margin         – zmienna pomocnicza do środkowa planszy,
+ *                           tj. odległość planszy od lewej ściany terminala.
+ */
+static void show(gamma_t *game, uint current_player, uint margin)
+{
+    screen_clear(&display);
+    draw_board(game, current_player, margin, true);
+    general_info(game, current_player, areas_limit, terminal_width()/2 - 15);
+    screen_present(&display);
 }
 
+
 /** @brief Funkcja wywołuje funkcje @ref gamma_move.
  * Na pozycji kursora wywoływania jest funkcja @ref gamma_move.
  * dla gracza @p current_player.
@@ -303,9 +527,11 @@ inline static bool player_can_play(gamma_t *game, uint current_player)
  */
 bool interactive_game(gamma_t *game, uint _width, uint _height, uint players, uint max_areas)
 {
-    // Sprawdzenie czy gra się miesci w terminalu
-    uint game_len = ((players > WIDE) + ceil_log(players)) * _width + 2;
-    if (terminal_width() < game_len + 4 || terminal_height() < _height + players + 6)
+    // Sprawdzenie czy w terminalu mieści się choć jedno pole planszy
+    // wraz ze stanem gry.
+    uint term_width = terminal_width(), term_height = terminal_height();
+    cell_size = ceil_log(players) + (WIDE < players);
+    if (term_width < cell_size + 6 || term_height < 9)
     {
        printf("\e[1;31mError - Terminal screen not large enough.\n\033[0m");
        return false;
@@ -316,39 +542,71 @@ bool interactive_game(gamma_t *game, uint _width, uint _height, uint players, ui
     height = _height;
     cursor_y = width/2;
     cursor_x = height/2;
+    areas_limit = max_areas;
+
+    // Plansza, która nie mieści się w terminalu razem z wynikami, jest
+    // wyświetlana fragmentami podążającymi za kursorem.
+    view_width = width;
+    view_height = height;
+    if (term_width < cell_size * width + 6)
+        view_width = (term_width - 6) / cell_size;
+    if (term_height < height + players + 6)
+    {
+        uint spare = players + 6 < term_height ? players + 6 : 8;
+        if (spare < 8)
+            spare = 8;
+        view_height = height < term_height - spare ? height : term_height - spare;
+    }
+    view_x = center_view(cursor_y, view_width, width);
+    view_y = center_view(cursor_x, view_height, height);
+    uint game_len = cell_size * view_width + 2;
+    if (screen_init(&display, STDOUT_FILENO, term_height, term_width) == false)
+        return false;
     setup_console();
-    bool fine_move;
+    bool fine_move, drawn = false;
+    muint last_frame = 0;
     char command;
     uint current_player = 1;
-    uint margin = (terminal_width() - game_len + 1)/2;
+    uint margin = (term_width - game_len + 1)/2;
 
     // Gra sie toczy dopóki są możliwe ruchy.
-    while (game_in_progress(game, players))
+    while (gamma_game_over(game) == false)
     {
-        show(game, current_player, margin);
-        general_info(game, current_player, max_areas, terminal_width()/2 - 15);
-        fine_move = false;
-
-        // Sprawdzenie czy gracz może grać w tej turze.
-        if (player_can_play(game, current_player))
+        // Tura gracza, który nie może grać, jest pomijana bez rysowania.
+        if (player_can_play(game, current_player) == false)
         {
-            // Jeśli może to wczytanie jego ruchu.
-            command = getchar();
+            next_turn(&current_player, players);
+            continue;
         }
-        else
+
+        // Klatka jest rysowana przed oczekiwaniem na klawisz. Klawisze, które
+        // nadejdą w krótszym odstępie, są obsługiwane bez rysowania, a serie
+        // klawiszy z bufora są rysowane najwyżej co FRAME_INTERVAL ms.
+        if (drawn == false)
         {
-            // W przeciwnym razie jego tura jest pomijana.
-            command = 'c';
+            muint elapsed = clock_ms() - last_frame;
+            if (input_pos == input_len && elapsed < FRAME_INTERVAL)
+                fill_input(FRAME_INTERVAL - elapsed);
+            if (input_pos == input_len || FRAME_INTERVAL <= clock_ms() - last_frame)
+            {
+                show(game, current_player, margin);
+                last_frame = clock_ms();
+                drawn = true;
+            }
         }
 
+        fine_move = false;
+        drawn = false;
+        command = next_key();
+
         // Analiza wczytanego ruchu:
         // Przemieszczenie kursora w odpowiednią stronę.
         if (command == ESC)
         {
-            command = getchar();
+            command = next_key();
             if (command == '[')
             {
-                command = getchar();
+                command = next_key();
                 if (command == 'A')
                 {
                     down_move();
@@ -369,6 +627,9 @@ bool interactive_game(gamma_t *game, uint _width, uint _height, uint players, ui
                     left_move();
                 }
             }
+            // Widoczny fragment planszy podąża za każdym ruchem kursora,
+            // również takim, po którym klatka nie jest rysowana.
+            follow_cursor();
         }
         // Złoty ruch.
         if (command == 'G' || command == 'g')
@@ -399,27 +660,29 @@ bool interactive_game(gamma_t *game, uint _width, uint _height, uint players, ui
 
     // Wypisanie wyników.
     uint best_result = gamma_best_result(game);
-    clear_screen();
-    show_board(game, width, height, players+1, margin);
+    screen_clear(&display);
+    draw_board(game, 0, margin, false);
 
-    push(terminal_width()/2 - 6);
-    printf("\e[1;36mFinal Results:\033[0m\n");
+    uint row = view_height + 3;
+    screen_move(&display, row++, terminal_width()/2 - 6);
+    screen_style(&display, STYLE_TITLE);
+    screen_put(&display, "Final Results:");
     for (current_player = 1; current_player <= players; ++current_player)
     {
-        push(terminal_width()/2 - 8);
+        // Gracz lub gracze z najlepszym wynikiem są podkreśleni na złoto.
+        screen_move(&display, row++, terminal_width()/2 - 8);
         if (gamma_busy_fields(game, current_player) != best_result)
-        {
-            printf("Player %d - %ld pts.\n", current_player,
-                   gamma_busy_fields(game, current_player));
-        }
+            screen_style(&display, STYLE_PLAIN);
         else
-        {
-            // Gracz lub gracze z najlepszym wynikiem są podkreśleni na złoto.
-            printf("\e[1;33mPlayer %d - %ld pts.\n", current_player,
-                   gamma_busy_fields(game, current_player));
-            printf("\x1b[0m");
-        }
+            screen_style(&display, STYLE_BEST);
+        screen_put(&display, "Player ");
+        screen_put_number(&display, current_player);
+        screen_put(&display, " - ");
+        screen_put_number(&display, gamma_busy_fields(game, current_player));
+        screen_put(&display, " pts.");
     }
+    screen_present(&display);
+    screen_free(&display);
 
     // Przywrócenie zwykłych ustawienień konsoli.
     restore_console();
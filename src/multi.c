@@ -0,0 +1,306 @@
+/** @file
+ * Implementacja trybu wsadowego obsługującego wiele gier jednocześnie.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#include "multi.h"
+#include "batch.h"
+#include "parser.h"
+#include "ring.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+/**
+ * Pojemność buforów cyklicznych z poleceniami dla wątków.
+ */
+#define MULTI_CAPACITY 4096
+
+/**
+ * Numer linii oznaczający koniec poleceń przesyłanych do wątku.
+ */
+#define LINES_END 0
+
+/**
+ * Początkowy rozmiar tablicy gier jednego wątku, potęga dwójki.
+ */
+#define GAMES_INITIAL 64
+
+/** @brief Przeanalizowana linia wraz z identyfikatorem gry.
+ */
+typedef struct tagged_line
+{
+    uint game; ///< Identyfikator gry.
+    parsed_line parsed; ///< Przeanalizowana linia.
+} tagged_line;
+
+/** @brief Element tablicy haszującej gry jednego wątku.
+ */
+typedef struct game_slot
+{
+    bool used; ///< Czy element jest zajęty.
+    uint id; ///< Identyfikator gry.
+    gamma_t *game; ///< Stan gry lub NULL, jeśli gra nie została utworzona.
+} game_slot;
+
+/** @brief Stan wątku wykonującego polecenia części gier.
+ */
+typedef struct worker
+{
+    pthread_t thread; ///< Wątek wykonujący polecenia.
+    ring lines; ///< Bufor z poleceniami dla wątku.
+    writer out; ///< Struktura zapisująca odpowiedzi wątku.
+    writer err; ///< Struktura zapisująca błędy wątku.
+    game_slot *games; ///< Tablica haszująca gry wątku.
+    size_t games_mem; ///< Rozmiar tablicy gier, potęga dwójki.
+    size_t games_cnt; ///< Liczba zajętych elementów tablicy gier.
+    bool memory_error; ///< Czy zabrakło pamięci na tablicę gier.
+} worker;
+
+/** @brief Wyznacza pozycję gry w tablicy haszującej.
+ * Funkcja pomocnicza w @ref find_game.
+ * @param[in] games – tablica haszująca gry,
+ * @param[in] mem   – rozmiar tablicy, potęga dwójki,
+ * @param[in] id    – identyfikator gry.
+ * @return Wskaźnik na element z grą @p id lub na wolny element,
+ * w którym powinna się znaleźć.
+ */
+static game_slot *probe(game_slot *games, size_t mem, uint id)
+{
+    size_t i = (id * 2654435761u) & (mem - 1);
+    while (games[i].used && games[i].id != id)
+        i = (i + 1) & (mem - 1);
+    return &games[i];
+}
+
+/** @brief Podwaja rozmiar tablicy gier wątku.
+ * Funkcja pomocnicza w @ref find_game.
+ * @param[in,out] w – wskaźnik na stan wątku.
+ * @return Wartość @p true, jeśli udało się zaalokować pamięć,
+ * a @p false w przeciwnym razie.
+ */
+static bool grow_games(worker *w)
+{
+    size_t mem = w->games_mem == 0 ? GAMES_INITIAL : 2 * w->games_mem;
+    game_slot *games = calloc(mem, sizeof(game_slot));
+    if (games == NULL)
+        return false;
+
+    for (size_t i = 0; i < w->games_mem; ++i)
+        if (w->games[i].used)
+            *probe(games, mem, w->games[i].id) = w->games[i];
+
+    free(w->games);
+    w->games = games;
+    w->games_mem = mem;
+    return true;
+}
+
+/** @brief Wyszukuje grę o podanym identyfikatorze.
+ * Funkcja pomocnicza w @ref worker_loop.
+ * @param[in,out] w    – wskaźnik na stan wątku,
+ * @param[in] id       – identyfikator gry,
+ * @param[in] create   – czy dodać grę, jeśli jej jeszcze nie ma.
+ * @return Wskaźnik na wskaźnik na stan gry lub NULL, jeśli gry nie ma
+ * i nie należało jej dodawać albo zabrakło pamięci.
+ */
+static gamma_t **find_game(worker *w, uint id, bool create)
+{
+    if (w->games_mem > 0)
+    {
+        game_slot *slot = probe(w->games, w->games_mem, id);
+        if (slot->used)
+            return &slot->game;
+    }
+    if (create == false)
+        return NULL;
+
+    if (2 * (w->games_cnt + 1) > w->games_mem && grow_games(w) == false)
+    {
+        w->memory_error = true;
+        return NULL;
+    }
+    game_slot *slot = probe(w->games, w->games_mem, id);
+    slot->used = true;
+    slot->id = id;
+    slot->game = NULL;
+    w->games_cnt++;
+    return &slot->game;
+}
+
+/** @brief Wątek wykonujący polecenia przydzielonych mu gier.
+ * Każda linia odpowiedzi jest poprzedzona identyfikatorem gry, a błąd
+ * wypisywany z numerem linii tak jak w zwykłym trybie wsadowym.
+ * @param[in,out] arg – wskaźnik na stan wątku.
+ * @return Wartość NULL.
+ */
+static void *worker_loop(void *arg)
+{
+    worker *w = arg;
+    tagged_line item;
+    response res;
+
+    ring_pop(&w->lines, &item);
+    while (item.parsed.line != LINES_END)
+    {
+        // Polecenia gry, która nie istnieje, są wykonywane jak przed
+        // rozpoczęciem rozgrywki, a brak pamięci na nową grę jest błędem.
+        bool create = item.parsed.cmd.type == 'B';
+        gamma_t *none = NULL;
+        gamma_t **game = find_game(w, item.game, create);
+        if (game == NULL && create)
+            response_init(&res);
+        else
+            execute_command(game != NULL ? game : &none, &item.parsed.cmd, &res);
+
+        print_tagged_response(&w->out, &w->err, item.parsed.line, &res, item.game);
+        ring_pop(&w->lines, &item);
+    }
+
+    return NULL;
+}
+
+/** @brief Przygotowuje stan wątku.
+ * Funkcja pomocnicza w @ref multi_session.
+ * @param[out] w        – wskaźnik na inicjowany stan wątku,
+ * @param[in] out       – struktura, której plik i sposób opróżniania
+ *                        przejmuje struktura zapisująca odpowiedzi wątku,
+ * @param[in] err       – struktura, której plik i sposób opróżniania
+ *                        przejmuje struktura zapisująca błędy wątku,
+ * @param[in] out_lock  – blokada pliku z odpowiedziami,
+ * @param[in] err_lock  – blokada pliku z błędami.
+ * @return Wartość @p true, jeśli udało się zaalokować pamięć,
+ * a @p false w przeciwnym razie.
+ */
+static bool worker_init(worker *w, const writer *out, const writer *err,
+                        pthread_mutex_t *out_lock, pthread_mutex_t *err_lock)
+{
+    w->games = NULL;
+    w->games_mem = 0;
+    w->games_cnt = 0;
+    w->memory_error = false;
+
+    if (ring_init(&w->lines, MULTI_CAPACITY, sizeof(tagged_line)) == false)
+        return false;
+    if (writer_init(&w->out, out->fd, out->policy) == false)
+    {
+        ring_free(&w->lines);
+        return false;
+    }
+    if (writer_init(&w->err, err->fd, err->policy) == false)
+    {
+        writer_free(&w->out);
+        ring_free(&w->lines);
+        return false;
+    }
+    writer_share(&w->out, out_lock);
+    writer_share(&w->err, err_lock);
+    return true;
+}
+
+/** @brief Zwalnia stan wątku wraz z jego grami.
+ * Zapisuje odpowiedzi pozostałe w buforach wątku.
+ * Funkcja pomocnicza w @ref multi_session.
+ * @param[in,out] w – wskaźnik na stan wątku.
+ */
+static void worker_free(worker *w)
+{
+    for (size_t i = 0; i < w->games_mem; ++i)
+        if (w->games[i].used)
+            gamma_delete(w->games[i].game);
+    free(w->games);
+    writer_free(&w->out);
+    writer_free(&w->err);
+    ring_free(&w->lines);
+}
+
+/** @brief Wykonuje polecenia wielu gier w trybie wsadowym.
+ * Każda linia ma postać "identyfikator polecenie", a polecenia różnych gier
+ * są rozdzielane między @p jobs wątków według identyfikatora gry. Każda gra
+ * rozpoczyna się własnym poleceniem @p B i ma własny licznik zmian planszy.
+ * Każda linia odpowiedzi, także wielolinijkowych odpowiedzi na polecenia
+ * @p p, @p r i @p d, jest poprzedzona identyfikatorem gry i spacją.
+ * Odpowiedzi jednej gry są wypisywane w kolejności linii, a linie jednej
+ * odpowiedzi nie przeplatają się z liniami innych odpowiedzi. Błędy mają postać
+ * "ERROR numer_linii" z numerem linii w całych danych wejściowych.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err   – wskaźnik na strukturę zapisującą błędy,
+ * @param[in] jobs      – liczba wątków wykonujących polecenia.
+ * @return Wartość @p true, jeśli wszystkie polecenia zostały wykonane,
+ * a @p false, jeśli nie udało się zaalokować pamięci.
+ */
+bool multi_session(reader *input, writer *out, writer *err, uint jobs)
+{
+    pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_mutex_t err_lock = PTHREAD_MUTEX_INITIALIZER;
+    worker *workers = malloc(jobs * sizeof(worker));
+    uint started = 0;
+
+    if (workers == NULL)
+        return false;
+
+    // Uruchomienie wątków, przy braku zasobów działamy na mniejszej liczbie.
+    while (started < jobs)
+    {
+        worker *w = &workers[started];
+        if (worker_init(w, out, err, &out_lock, &err_lock) == false)
+            break;
+        if (pthread_create(&w->thread, NULL, worker_loop, w) != 0)
+        {
+            worker_free(w);
+            break;
+        }
+        started++;
+    }
+    if (started == 0)
+    {
+        free(workers);
+        return false;
+    }
+
+    // Błędy wykryte podczas analizy linii są wypisywane przez ten wątek.
+    writer_flush(out);
+    writer_flush(err);
+    writer_share(err, &err_lock);
+
+    tagged_line item;
+    response res;
+    const char *line;
+    size_t len;
+    int read;
+
+    item.parsed.line = 0;
+    while ((read = reader_next_line(input, &line, &len)) == 1)
+    {
+        item.parsed.line++;
+        item.parsed.dir = parse_tagged_line(line, len, &item.game, &item.parsed.cmd);
+        if (item.parsed.dir == 1)
+        {
+            ring_push(&workers[item.game % started].lines, &item);
+        }
+        else if (item.parsed.dir == 0)
+        {
+            response_init(&res);
+            print_response(out, err, item.parsed.line, &res);
+        }
+    }
+
+    bool fine = read != -1;
+    item.parsed.line = LINES_END;
+    for (uint i = 0; i < started; ++i)
+        ring_push(&workers[i].lines, &item);
+    for (uint i = 0; i < started; ++i)
+    {
+        pthread_join(workers[i].thread, NULL);
+        fine = fine && workers[i].memory_error == false;
+        worker_free(&workers[i]);
+    }
+
+    writer_flush(err);
+    writer_share(err, NULL);
+    free(workers);
+    return fine;
+}
@@ -0,0 +1,35 @@
+/** @file
+ * Interfejs trybu wsadowego obsługującego wiele gier jednocześnie.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#ifndef GAMMA_MULTI_H
+#define GAMMA_MULTI_H
+
+#include <stdbool.h>
+#include "gamma.h"
+#include "reader.h"
+#include "writer.h"
+
+/** @brief Wykonuje polecenia wielu gier w trybie wsadowym.
+ * Każda linia ma postać "identyfikator polecenie", a polecenia różnych gier
+ * są rozdzielane między @p jobs wątków według identyfikatora gry. Każda gra
+ * rozpoczyna się własnym poleceniem @p B i ma własny licznik zmian planszy.
+ * Każda linia odpowiedzi, także wielolinijkowych odpowiedzi na polecenia
+ * @p p, @p r i @p d, jest poprzedzona identyfikatorem gry i spacją.
+ * Odpowiedzi jednej gry są wypisywane w kolejności linii, a linie jednej
+ * odpowiedzi nie przeplatają się z liniami innych odpowiedzi. Błędy mają postać
+ * "ERROR numer_linii" z numerem linii w całych danych wejściowych.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err   – wskaźnik na strukturę zapisującą błędy,
+ * @param[in] jobs      – liczba wątków wykonujących polecenia.
+ * @return Wartość @p true, jeśli wszystkie polecenia zostały wykonane,
+ * a @p false, jeśli nie udało się zaalokować pamięci.
+ */
+bool multi_session(reader *input, writer *out, writer *err, uint jobs);
+
+#endif //GAMMA_MULTI_H
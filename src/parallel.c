@@ -0,0 +1,206 @@
+/** @file
+ * Implementacja równoległego analizowania poleceń trybu wsadowego.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#include "parallel.h"
+#include "batch.h"
+#include "parser.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Początkowy rozmiar okna danych wejściowych analizowanego równolegle.
+ */
+#define WINDOW_SIZE (1 << 24)
+
+/** @brief Część okna analizowana przez jeden wątek.
+ */
+typedef struct chunk
+{
+    const char *begin; ///< Początek części.
+    const char *end; ///< Koniec części.
+    parsed_line *items; /**< Przeanalizowane linie, z numerami liczonymi
+        od początku części. */
+    size_t count; ///< Liczba przeanalizowanych linii.
+    size_t mem; ///< Liczba linii, na które zaalokowano pamięć.
+    int lines; ///< Liczba wszystkich linii części, także tych pominiętych.
+    bool memory_error; ///< Czy zabrakło pamięci.
+} chunk;
+
+/** @brief Analizuje wszystkie linie jednej części okna.
+ * Puste linie i komentarze są tylko liczone.
+ * @param[in,out] arg – wskaźnik na analizowaną część.
+ * @return Wartość NULL.
+ */
+static void *parse_chunk(void *arg)
+{
+    chunk *c = arg;
+    const char *line = c->begin;
+    parsed_line item;
+
+    c->count = 0;
+    c->lines = 0;
+    c->memory_error = false;
+    while (line < c->end)
+    {
+        const char *newline = memchr(line, '\n', c->end - line);
+        size_t len = newline == NULL ? (size_t) (c->end - line) : (size_t) (newline - line + 1);
+
+        item.line = ++c->lines;
+        item.dir = parse_line(line, len, &item.cmd);
+        line += len;
+        if (item.dir == -1)
+            continue;
+
+        if (c->count == c->mem)
+        {
+            size_t mem = 2 * c->mem + 1024;
+            parsed_line *items = realloc(c->items, mem * sizeof(parsed_line));
+            if (items == NULL)
+            {
+                c->memory_error = true;
+                return NULL;
+            }
+            c->items = items;
+            c->mem = mem;
+        }
+        c->items[c->count++] = item;
+    }
+    return NULL;
+}
+
+/** @brief Wyznacza kolejne okno danych wejściowych.
+ * Okno kończy się na granicy linii, chyba że obejmuje koniec danych.
+ * Funkcja pomocnicza w @ref parallel_session.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[out] data     – wskaźnik na początek okna.
+ * @return Długość okna, zero jeśli dane się skończyły.
+ */
+static size_t next_window(reader *input, const char **data)
+{
+    size_t want = WINDOW_SIZE;
+    while (true)
+    {
+        size_t available = reader_available(input, want, data);
+        if (available < want)
+            return available;
+
+        // Szukamy ostatniego znaku nowej linii w oknie.
+        size_t len = want;
+        while (len > 0 && (*data)[len - 1] != '\n')
+            len--;
+        if (len > 0)
+            return len;
+
+        // Linia dłuższa od okna.
+        want *= 2;
+    }
+}
+
+/** @brief Dzieli okno na części kończące się na granicy linii.
+ * Funkcja pomocnicza w @ref parallel_session.
+ * @param[in] data    – wskaźnik na początek okna,
+ * @param[in] len     – długość okna,
+ * @param[out] chunks – tablica części,
+ * @param[in] jobs    – liczba części.
+ */
+static void split_window(const char *data, size_t len, chunk *chunks, uint jobs)
+{
+    const char *end = data + len;
+    const char *begin = data;
+    for (uint i = 0; i < jobs; ++i)
+    {
+        const char *cut = data + len / jobs * (i + 1);
+        if (i + 1 == jobs)
+        {
+            cut = end;
+        }
+        else if (cut <= begin)
+        {
+            // Poprzednia część objęła już długą linię.
+            cut = begin;
+        }
+        else
+        {
+            const char *newline = memchr(cut, '\n', end - cut);
+            cut = newline == NULL ? end : newline + 1;
+        }
+        chunks[i].begin = begin;
+        chunks[i].end = cut;
+        begin = cut;
+    }
+}
+
+/** @brief Wykonuje pozostałe polecenia trybu wsadowego, analizując je równolegle.
+ * Dane wejściowe są dzielone na duże okna, a każde okno na @p jobs części
+ * kończących się na granicy linii. Części są analizowane równolegle do tablic
+ * gotowych poleceń, które następnie są wykonywane po kolei na strukturze
+ * @p game. Numery linii w komunikatach o błędach są takie same jak przy
+ * wykonywaniu sekwencyjnym.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err   – wskaźnik na strukturę zapisującą błędy,
+ * @param[in,out] game  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] line_cnt  – liczba już przetworzonych linii,
+ * @param[in] jobs      – liczba wątków analizujących linie.
+ * @return Wartość @p true, jeśli wszystkie polecenia zostały wykonane,
+ * a @p false, jeśli nie udało się zaalokować pamięci.
+ */
+bool parallel_session(reader *input, writer *out, writer *err,
+                      gamma_t *game, int line_cnt, uint jobs)
+{
+    chunk *chunks = calloc(jobs, sizeof(chunk));
+    pthread_t *threads = malloc(jobs * sizeof(pthread_t));
+    bool fine = chunks != NULL && threads != NULL;
+    const char *data;
+    size_t len;
+    response res;
+
+    while (fine && (len = next_window(input, &data)) > 0)
+    {
+        split_window(data, len, chunks, jobs);
+
+        // Pierwszą część analizuje wątek wywołujący.
+        uint started = 1;
+        while (started < jobs
+               && pthread_create(&threads[started], NULL,
+                                 parse_chunk, &chunks[started]) == 0)
+            started++;
+        parse_chunk(&chunks[0]);
+        for (uint i = started; i < jobs; ++i)
+            parse_chunk(&chunks[i]);
+        for (uint i = 1; i < started; ++i)
+            pthread_join(threads[i], NULL);
+        reader_consume(input, len);
+
+        // Polecenia są wykonywane w kolejności linii.
+        for (uint i = 0; i < jobs && fine; ++i)
+        {
+            fine = chunks[i].memory_error == false;
+            for (size_t j = 0; j < chunks[i].count && fine; ++j)
+            {
+                parsed_line *item = &chunks[i].items[j];
+                if (item->dir == 1)
+                    execute_command(&game, &item->cmd, &res);
+                else
+                    response_init(&res);
+                print_response(out, err, line_cnt + item->line, &res);
+            }
+            line_cnt += chunks[i].lines;
+        }
+    }
+
+    if (chunks != NULL)
+    {
+        for (uint i = 0; i < jobs; ++i)
+            free(chunks[i].items);
+    }
+    free(chunks);
+    free(threads);
+    return fine;
+}
@@ -0,0 +1,35 @@
+/** @file
+ * Interfejs równoległego analizowania poleceń trybu wsadowego.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#ifndef GAMMA_PARALLEL_H
+#define GAMMA_PARALLEL_H
+
+#include <stdbool.h>
+#include "gamma.h"
+#include "reader.h"
+#include "writer.h"
+
+/** @brief Wykonuje pozostałe polecenia trybu wsadowego, analizując je równolegle.
+ * Dane wejściowe są dzielone na duże okna, a każde okno na @p jobs części
+ * kończących się na granicy linii. Części są analizowane równolegle do tablic
+ * gotowych poleceń, które następnie są wykonywane po kolei na strukturze
+ * @p game. Numery linii w komunikatach o błędach są takie same jak przy
+ * wykonywaniu sekwencyjnym.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err   – wskaźnik na strukturę zapisującą błędy,
+ * @param[in,out] game  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] line_cnt  – liczba już przetworzonych linii,
+ * @param[in] jobs      – liczba wątków analizujących linie.
+ * @return Wartość @p true, jeśli wszystkie polecenia zostały wykonane,
+ * a @p false, jeśli nie udało się zaalokować pamięci.
+ */
+bool parallel_session(reader *input, writer *out, writer *err,
+                      gamma_t *game, int line_cnt, uint jobs);
+
+#endif //GAMMA_PARALLEL_H
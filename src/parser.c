@@ -6,51 +6,37 @@
  * @date 12 maja 2020
  */
 
-#include <stdbool.h>
-#include <string.h>
-#include <ctype.h>
-#include <stdlib.h>
-
-/** @brief Funkcja sprawdza czy napis reprezentuje poprawną liczbę.
- * Funkcja sprawdza czy podany napis zawiera same cyfry,
- * bez zer wiodących oraz czy liczba tworzona przez uint mieści się
- * w zakresie wartości liczby uint.
- * Funkcja pomocnicza w @ref analyse_line.
- * @param[in] arg  – wskaźnik na ciag znaków do sprawdzenia,
- * @param[in] len  – długość napisu (ciągu znaków),
- * @return Wartość @p true, jeśli napis @p arg reprezentuje poprawną
- * liczbę w systemie uint, a @p false w przeciwnym razie.
+#include "parser.h"
+
+/**
+ * Największa liczba dostępna w formacie uint.
  */
-static bool is_fine_number(char **arg , int len)
-{
-    // Pomijamy doczepiony znak końca linii.
-    len--;
-
-    // Brak argumentu.
-    if (len == 0)
-        return true;
-    // Liczba 0.
-    else if (len == 1 && isdigit((*arg)[0]))
-        return true;
-    // Niepoprawna liczba z zerem wiodącym.
-    else if (len > 1 && (*arg)[0] == '0')
-        return false;
-    // Argument za duży.
-    else if (len > 10)
-        return false;
+#define MAXUINT 4294967295
 
-    // Sprawdzenie czy argument składa się z samych cyfr.
-    for (int i = 0; i < len; ++i)
-    {
-        if (isdigit((*arg)[i]) == false)
-            return false;
-    }
+/**
+ * Największa liczba cyfr liczby w formacie uint.
+ */
+#define MAX_DIGITS 10
 
-    return true;
+/**
+ * Największa liczba dostępna w formacie muint.
+ */
+#define MAXMUINT 18446744073709551615u
+
+/** @brief Funkcja sprawdza czy podany znak jest białym znakiem.
+ * Odpowiada funkcji @ref isspace w domyślnych ustawieniach lokalnych.
+ * Funkcja pomocnicza w @ref parse_line.
+ * @param[in] c  – znak do sprawdzenia,
+ * @return Wartość @p true, jeśli znak @p c jest białym znakiem,
+ * a @p false w przeciwnym razie.
+ */
+static inline bool is_blank(char c)
+{
+    return c == ' ' || ('\t' <= c && c <= '\r');
 }
 
 /** @brief Funkcja sprawdza czy podany znak jest niedozwolony.
- * Funkcja pomocnicza w @ref analyse_line.
+ * Funkcja pomocnicza w @ref parse_line.
  * @param[in] c  – znak do sprawdzenia,
  * @return Wartość @p true, jeśli znak @p c reprezentuje niedozwolony
  * znak, a @p false w przeciwnym razie.
@@ -58,154 +44,164 @@ static bool is_fine_number(char **arg , int len)
 static inline bool wrong_sign(char c)
 {
     unsigned short _c = c;
-    return _c < 33;
+    return _c < 33 && is_blank(c) == false;
 }
 
-/** @brief Funkcja alokuje pamieć na napis.
- * Funkcja pomocnicza w @ref analyse_line.
- * @param[in] tab  – wskaźnik na bufor na napis.
- * @param[in] mem  – rozmiar bufora który ma zostać zaalokowany.
- * @return Wartość @p true jeśli alokacja zakończyła się
- * pomyślnie, a @p false w przeciwnym razie.
+/** @brief Funkcja wczytuje liczbę z zakresu uint zapisaną od pozycji @p i.
+ * Sprawdzenie i obliczenie wartości odbywa się w jednym przejściu. Liczba
+ * kończy się na pierwszym białym znaku lub na końcu linii.
+ * Funkcja pomocnicza w @ref parse_line i @ref parse_tagged_line.
+ * @param[in] line      – analizowana linia,
+ * @param[in] len       – długość linii,
+ * @param[in,out] i     – wskaźnik na pozycję w linii, po wywołaniu
+ *                        wskazuje znak za liczbą,
+ * @param[out] value    – wskaźnik na wczytaną liczbę.
+ * @return Wartość @p true, jeśli liczba jest poprawna, a @p false, jeśli
+ * zawiera inne znaki niż cyfry, ma zero wiodące lub jest spoza zakresu uint.
  */
-static bool safe_challoc(char **tab, size_t mem)
+static inline bool read_number(const char *line, size_t len, size_t *i, uint *value)
 {
-    *tab = malloc(mem);
-    if (mem > 0 && *tab == NULL)
+    size_t start = *i, j = *i;
+    muint result = 0;
+    while (j < len && is_blank(line[j]) == false)
+    {
+        if (line[j] < '0' || '9' < line[j] || j - start == MAX_DIGITS)
+            return false;
+        result = result * 10 + (line[j] - '0');
+        j++;
+    }
+
+    // Niepoprawna liczba z zerem wiodącym lub spoza zakresu uint.
+    if ((j - start > 1 && line[start] == '0') || MAXUINT < result)
         return false;
+
+    *i = j;
+    *value = result;
     return true;
 }
 
-/** @brief Funkcja wstępnie analizuje linie polecą wczytaną przez program.
- * Funkcja przerabia wczytaną do konsoli linię na identyfikator komendy
- * oraz jej argumenty, alokuje w sposób kontrolowany pamieć na te argumenty,
- * wstępnie sprawdza czy wczytania linii nadaje się do wykonania czy też
- * jest błędna albo pusta - powinna zostać zignorowana.
- * Funkcja pomocnicza w @ref main.
- * @param[in] line          – linia z poleceniem wczytana do programu,
- * @param[in] read          – długość wczytanej linii,
- * @param[out] command      – wskaźnik na bufor identyfikator komendy,
- * @param[out] arg1         – wskaźnik na bufor pierwszego argumentu polecenia,
- * @param[out] arg2         – wskaźnik na bufor drugiego argumentu polecenia,
- * @param[out] arg3         – wskaźnik na bufor trzeciego argumentu polecenia,
- * @param[out] arg4         – wskaźnik na bufor czwartego argumentu polecenia,
- * @param[out] com_len      – wskaźnik na długość identyfikatora komendy,
- * @param[out] arg_len1     – wskaźnik na długość pierwszego argumentu,
- * @param[out] arg_len2     – wskaźnik na długość drugiego argumentu,
- * @param[out] arg_len3     – wskaźnik na długość trzeciego argumentu,
- * @param[out] arg_len4     – wskaźnik na długość czwartego argumentu,
- * @param[out] arguments    – wskaźnik na liczbe argumentów na wczytanej linii,
- * @param[out] memory_error – wskaźnik na zmienna logiczną w której,
- * zanotowywane jest wystąpienie błędu z alokacją pamieci.
- * @return Wartość @p -1 kiedy linia powinna być zignorowana tj. jest pusta
- * lub wystąpił błąd z alokacją pamięci, @p 0 kiedy linia jest błedna
- * i program powinnien zasygnalizować to funkcją @ref call_error,
- * @p 1 jeśli linia reprezentuje poprawne polecenie po wstępnej analizie.
+/** @brief Funkcja wczytuje liczbę z zakresu muint zapisaną od pozycji @p i.
+ * Działa jak @ref read_number, ale dla większego zakresu liczb.
+ * Funkcja pomocnicza w @ref parse_line.
+ * @param[in] line      – analizowana linia,
+ * @param[in] len       – długość linii,
+ * @param[in,out] i     – wskaźnik na pozycję w linii, po wywołaniu
+ *                        wskazuje znak za liczbą,
+ * @param[out] value    – wskaźnik na wczytaną liczbę.
+ * @return Wartość @p true, jeśli liczba jest poprawna, a @p false, jeśli
+ * zawiera inne znaki niż cyfry, ma zero wiodące lub jest spoza zakresu muint.
  */
-int analyse_line(char *line, int read, char **command, char **arg1,
-                 char **arg2, char **arg3, char **arg4, int *com_len,
-                 int *arg_len1, int *arg_len2, int *arg_len3, int *arg_len4,
-                 int *arguments, bool *memory_error)
+static bool read_wide_number(const char *line, size_t len, size_t *i, muint *value)
 {
-    // Alokacja pamięci na komendę i argumenty.
-    size_t mem = read * sizeof(char);
-    if (safe_challoc(command, mem) == false)
-    {
-        *memory_error = true;
-        return -1;
-    }
-    if (safe_challoc(arg1, mem) == false)
-    {
-        free(command);
-        *memory_error = true;
-        return -1;
-    }
-    if (safe_challoc(arg2, mem) == false)
-    {
-        free(command);
-        free(arg1);
-        *memory_error = true;
-        return -1;
-    }
-    if (safe_challoc(arg3, mem) == false)
-    {
-        free(command);
-        free(arg1);
-        free(arg2);
-        *memory_error = true;
-        return -1;
-    }
-    if (safe_challoc(arg4, mem) == false)
+    size_t start = *i, j = *i;
+    muint result = 0;
+    while (j < len && is_blank(line[j]) == false)
     {
-        free(command);
-        free(arg1);
-        free(arg2);
-        free(arg3);
-        *memory_error = true;
-        return -1;
+        if (line[j] < '0' || '9' < line[j])
+            return false;
+        muint digit = line[j] - '0';
+        if ((MAXMUINT - digit) / 10 < result)
+            return false;
+        result = result * 10 + digit;
+        j++;
     }
 
+    if (j - start > 1 && line[start] == '0')
+        return false;
+
+    *i = j;
+    *value = result;
+    return true;
+}
+
+/** @brief Funkcja analizuje linię poleceń wczytaną przez program.
+ * Funkcja w jednym przejściu po linii, bez alokowania pamięci, wyznacza
+ * identyfikator komendy oraz wartości jej argumentów, sprawdzając przy tym
+ * czy linia nadaje się do wykonania czy też jest błędna albo pusta - powinna
+ * zostać zignorowana. Argumenty muszą być liczbami z zakresu uint zapisanymi
+ * bez zer wiodących, z wyjątkiem argumentu polecenia @p d, który jest
+ * liczbą z zakresu muint zapisywaną w polu @p epoch.
+ * Funkcja pomocnicza w @ref main.
+ * @param[in] line  – linia z poleceniem wczytana do programu,
+ * @param[in] len   – długość wczytanej linii,
+ * @param[out] cmd  – wskaźnik na strukturę, w której zapisywane
+ *                    jest przeanalizowane polecenie.
+ * @return Wartość @p -1 kiedy linia powinna być zignorowana tj. jest pusta,
+ * @p 0 kiedy linia jest błedna i program powinnien zasygnalizować to
+ * błędem, @p 1 jeśli linia reprezentuje poprawne polecenie.
+ */
+int parse_line(const char *line, size_t len, command *cmd)
+{
     // Sprawdzenie skrajnych przypadków - pomijanie linii z komendą.
-    if (read == 0 || line[0] == '#' || (read == 1 && line[0] == '\n'))
+    if (len == 0 || line[0] == '#' || (len == 1 && line[0] == '\n'))
         return -1;
-    else if (line[read - 1] != '\n')
+    else if (line[len - 1] != '\n')
         return 0;
 
-    for (int i = 0; i < read; ++i)
-        if (wrong_sign(line[i]) && isspace(line[i]) == false)
-            return 0;
-
-    // Krojenie linii z getline'a na komendę i argumenty.
-    // Stworzenie pomocniczych zmiennych liczących długość każdego argumentu i komendy.
-    int i = 0;
-    int cl = 0, al1 = 0, al2 = 0, al3 = 0, al4 = 0;
-
-    // Białe znaki na poczatku.
-    if (i < read && isspace(line[i]))
+    // Identyfikator komendy to dokładnie jeden znak na początku linii.
+    if (is_blank(line[0]) || wrong_sign(line[0]) || is_blank(line[1]) == false)
         return 0;
 
-    while (i < read && isspace(line[i]) == false)
-        (*command)[cl++] = line[i++];
+    cmd->type = line[0];
+    cmd->arguments = 0;
 
-    while (i < read && isspace(line[i]))
-        i++;
-    while (i < read && isspace(line[i]) == false)
-        (*arg1)[al1++] = line[i++];
+    size_t i = 1;
+    while (true)
+    {
+        // Białe znaki przed argumentem.
+        while (i < len && is_blank(line[i]))
+            i++;
+        if (i == len)
+            break;
+        if (cmd->arguments == MAX_ARGUMENTS)
+            return 0;
 
-    while (i < read && isspace(line[i]))
-        i++;
-    while (i < read && isspace(line[i]) == false)
-        (*arg2)[al2++] = line[i++];
+        // Argument polecenia d jest wartością licznika zmian planszy.
+        if (cmd->type == 'd' && cmd->arguments == 0)
+        {
+            if (read_wide_number(line, len, &i, &cmd->epoch) == false)
+                return 0;
+            cmd->args[0] = 0;
+        }
+        else if (read_number(line, len, &i, &cmd->args[cmd->arguments]) == false)
+        {
+            return 0;
+        }
+        cmd->arguments++;
+    }
 
-    while (i < read && isspace(line[i]))
-        i++;
-    while (i < read && isspace(line[i]) == false)
-        (*arg3)[al3++] = line[i++];
+    return 1;
+}
 
-    while (i < read && isspace(line[i]))
-        i++;
-    while (i < read && isspace(line[i]) == false)
-        (*arg4)[al4++] = line[i++];
+/** @brief Funkcja analizuje linię poleceń oznaczoną identyfikatorem gry.
+ * Linia ma postać "identyfikator polecenie", gdzie identyfikator jest liczbą
+ * z zakresu uint zapisaną bez zer wiodących, oddzieloną od polecenia jednym
+ * białym znakiem, a polecenie ma postać akceptowaną przez @ref parse_line.
+ * Linia z identyfikatorem, ale bez polecenia jest błędna.
+ * Funkcja pomocnicza w @ref multi_session.
+ * @param[in] line  – linia z poleceniem wczytana do programu,
+ * @param[in] len   – długość wczytanej linii,
+ * @param[out] game – wskaźnik na identyfikator gry,
+ * @param[out] cmd  – wskaźnik na strukturę, w której zapisywane
+ *                    jest przeanalizowane polecenie.
+ * @return Wartość @p -1 kiedy linia powinna być zignorowana tj. jest pusta,
+ * @p 0 kiedy linia jest błedna, @p 1 jeśli linia reprezentuje poprawne
+ * polecenie dla gry @p game.
+ */
+int parse_tagged_line(const char *line, size_t len, uint *game, command *cmd)
+{
+    // Puste linie i komentarze są pomijane tak jak w zwykłym trybie.
+    if (len == 0 || line[0] == '#' || (len == 1 && line[0] == '\n'))
+        return -1;
+    else if (line[len - 1] != '\n')
+        return 0;
 
-    while (i < read && isspace(line[i]))
-        i++;
-    if (i != read)
+    // Identyfikator gry oddziela od polecenia dokładnie jeden biały znak,
+    // a reszta linii musi być zwykłym poleceniem.
+    size_t i = 0;
+    if (read_number(line, len, &i, game) == false || i == 0 || line[i] == '\n')
         return 0;
+    i++;
 
-    // Dodanie końcowki umożliwiającej poprawne porównywanie stringów
-    (*command)[cl++] = '\0';
-    (*arg1)[al1++] = '\0';
-    (*arg2)[al2++] = '\0';
-    (*arg3)[al3++] = '\0';
-    (*arg4)[al4++] = '\0';
-    *com_len = cl;
-    *arg_len1 = al1;
-    *arg_len2= al2;
-    *arg_len3 = al3;
-    *arg_len4 = al4;
-
-    *arguments = (al1 > 1) + (al2 > 1) + (al3 > 1) + (al4 > 1);
-
-    return cl == 2 && is_fine_number(arg1, al1) && is_fine_number(arg2, al2)
-           && is_fine_number(arg3, al3) && is_fine_number(arg4, al4);
-}
\ No newline at end of file
+    return parse_line(line + i, len - i, cmd) == 1 ? 1 : 0;
+}
@@ -10,36 +10,69 @@
 #define GAMMA_PARSER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "gamma.h"
 
-/** @brief Funkcja wstępnie analizuje linie polecą wczytaną przez program.
- * Funkcja przerabia wczytaną do konsoli linię na identyfikator komendy
- * oraz jej argumenty, alokuje w sposób kontrolowany pamieć na te argumenty,
- * wstępnie sprawdza czy wczytania linii nadaje się do wykonania czy też
- * jest błędna albo pusta - powinna zostać zignorowana.
+/**
+ * Maksymalna liczba argumentów polecenia.
+ */
+#define MAX_ARGUMENTS 4
+
+/** @brief Struktura przechowująca przeanalizowane polecenie.
+ */
+typedef struct command
+{
+    char type; ///< Jednoznakowy identyfikator komendy.
+    int arguments; ///< Liczba argumentów polecenia.
+    uint args[MAX_ARGUMENTS]; ///< Argumenty polecenia.
+    muint epoch; /**< Argument polecenia @p d, wartość licznika zmian
+        planszy z zakresu muint. */
+} command;
+
+/** @brief Przeanalizowana linia wraz z jej numerem.
+ * Wykorzystywana przy analizowaniu linii w innym wątku niż ten,
+ * który wykonuje polecenia.
+ */
+typedef struct parsed_line
+{
+    int line; ///< Numer linii.
+    int dir; ///< Wynik funkcji @ref parse_line.
+    command cmd; ///< Przeanalizowane polecenie.
+} parsed_line;
+
+/** @brief Funkcja analizuje linię poleceń wczytaną przez program.
+ * Funkcja w jednym przejściu po linii, bez alokowania pamięci, wyznacza
+ * identyfikator komendy oraz wartości jej argumentów, sprawdzając przy tym
+ * czy linia nadaje się do wykonania czy też jest błędna albo pusta - powinna
+ * zostać zignorowana. Argumenty muszą być liczbami z zakresu uint zapisanymi
+ * bez zer wiodących, z wyjątkiem argumentu polecenia @p d, który jest
+ * liczbą z zakresu muint zapisywaną w polu @p epoch.
  * Funkcja pomocnicza w @ref main.
- * @param[in] line          – linia z poleceniem wczytana do programu,
- * @param[in] read          – długość wczytanej linii,
- * @param[out] command      – wskaźnik na bufor identyfikator komendy,
- * @param[out] arg1         – wskaźnik na bufor pierwszego argumentu polecenia,
- * @param[out] arg2         – wskaźnik na bufor drugiego argumentu polecenia,
- * @param[out] arg3         – wskaźnik na bufor trzeciego argumentu polecenia,
- * @param[out] arg4         – wskaźnik na bufor czwartego argumentu polecenia,
- * @param[out] com_len      – wskaźnik na długość identyfikatora komendy,
- * @param[out] arg_len1     – wskaźnik na długość pierwszego argumentu,
- * @param[out] arg_len2     – wskaźnik na długość drugiego argumentu,
- * @param[out] arg_len3     – wskaźnik na długość trzeciego argumentu,
- * @param[out] arg_len4     – wskaźnik na długość czwartego argumentu,
- * @param[out] arguments    – wskaźnik na liczbe argumentów na wczytanej linii,
- * @param[out] memory_error – wskaźnik na zmienna logiczną w której,
- * zanotowywane jest wystąpienie błędu z alokacją pamieci.
- * @return Wartość @p -1 kiedy linia powinna być zignorowana tj. jest pusta
- * lub wystąpił błąd z alokacją pamięci, @p 0 kiedy linia jest błedna
- * i program powinnien zasygnalizować to funkcją @ref call_error,
- * @p 1 jeśli linia reprezentuje poprawne polecenie po wstępnej analizie.
+ * @param[in] line  – linia z poleceniem wczytana do programu,
+ * @param[in] len   – długość wczytanej linii,
+ * @param[out] cmd  – wskaźnik na strukturę, w której zapisywane
+ *                    jest przeanalizowane polecenie.
+ * @return Wartość @p -1 kiedy linia powinna być zignorowana tj. jest pusta,
+ * @p 0 kiedy linia jest błedna i program powinnien zasygnalizować to
+ * błędem, @p 1 jeśli linia reprezentuje poprawne polecenie.
+ */
+int parse_line(const char *line, size_t len, command *cmd);
+
+/** @brief Funkcja analizuje linię poleceń oznaczoną identyfikatorem gry.
+ * Linia ma postać "identyfikator polecenie", gdzie identyfikator jest liczbą
+ * z zakresu uint zapisaną bez zer wiodących, oddzieloną od polecenia jednym
+ * białym znakiem, a polecenie ma postać akceptowaną przez @ref parse_line.
+ * Linia z identyfikatorem, ale bez polecenia jest błędna.
+ * Funkcja pomocnicza w @ref multi_session.
+ * @param[in] line  – linia z poleceniem wczytana do programu,
+ * @param[in] len   – długość wczytanej linii,
+ * @param[out] game – wskaźnik na identyfikator gry,
+ * @param[out] cmd  – wskaźnik na strukturę, w której zapisywane
+ *                    jest przeanalizowane polecenie.
+ * @return Wartość @p -1 kiedy linia powinna być zignorowana tj. jest pusta,
+ * @p 0 kiedy linia jest błedna, @p 1 jeśli linia reprezentuje poprawne
+ * polecenie dla gry @p game.
  */
-int analyse_line(char *line, int read, char **command, char **arg1,
-                 char **arg2, char **arg3, char **arg4, int *com_len,
-                 int *arg_len1, int *arg_len2, int *arg_len3, int *arg_len4,
-                 int *arguments, bool *memory_error);
+int parse_tagged_line(const char *line, size_t len, uint *game, command *cmd);
 
 #endif //GAMMA_PARSER_H
@@ -0,0 +1,158 @@
+/** @file
+ * Implementacja potokowego wykonywania poleceń trybu wsadowego.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#include "pipeline.h"
+#include "batch.h"
+#include "parser.h"
+#include "ring.h"
+#include <pthread.h>
+
+/**
+ * Pojemność buforów cyklicznych łączących wątki.
+ */
+#define PIPELINE_CAPACITY 4096
+
+/**
+ * Numer linii oznaczający koniec danych przesyłanych między wątkami.
+ */
+#define LINES_END 0
+
+/** @brief Odpowiedź przekazywana do wątku wypisującego.
+ */
+typedef struct answered_line
+{
+    int line; ///< Numer linii.
+    response res; ///< Odpowiedź na polecenie.
+} answered_line;
+
+/** @brief Stan potoku współdzielony przez wątki.
+ */
+typedef struct pipeline
+{
+    reader *input; ///< Struktura wczytująca dane.
+    gamma_t *game; ///< Struktura przechowująca stan gry.
+    int line_cnt; ///< Liczba linii przetworzonych przed uruchomieniem potoku.
+    ring parsed; ///< Bufor z przeanalizowanymi liniami.
+    ring answered; ///< Bufor z odpowiedziami.
+    bool memory_error; ///< Czy podczas wczytywania zabrakło pamięci.
+} pipeline;
+
+/** @brief Wątek wczytujący i analizujący kolejne linie.
+ * @param[in,out] arg – wskaźnik na stan potoku.
+ * @return Wartość NULL.
+ */
+static void *parse_stage(void *arg)
+{
+    pipeline *p = arg;
+    parsed_line item;
+    const char *line;
+    size_t len;
+    int read;
+
+    item.line = p->line_cnt;
+    while ((read = reader_next_line(p->input, &line, &len)) == 1)
+    {
+        item.line++;
+        item.dir = parse_line(line, len, &item.cmd);
+        if (item.dir != -1)
+            ring_push(&p->parsed, &item);
+    }
+
+    p->memory_error = read == -1;
+    item.line = LINES_END;
+    ring_push(&p->parsed, &item);
+    return NULL;
+}
+
+/** @brief Wątek wykonujący kolejne polecenia.
+ * @param[in,out] arg – wskaźnik na stan potoku.
+ * @return Wartość NULL.
+ */
+static void *execute_stage(void *arg)
+{
+    pipeline *p = arg;
+    parsed_line item;
+    answered_line answer;
+
+    do
+    {
+        ring_pop(&p->parsed, &item);
+        answer.line = item.line;
+        if (item.line != LINES_END && item.dir == 1)
+            execute_command(&p->game, &item.cmd, &answer.res);
+        else
+            response_init(&answer.res);
+        ring_push(&p->answered, &answer);
+    } while (item.line != LINES_END);
+
+    return NULL;
+}
+
+/** @brief Wykonuje pozostałe polecenia trybu wsadowego w trzech wątkach.
+ * Pierwszy wątek wczytuje i analizuje linie, drugi wykonuje polecenia na
+ * strukturze @p game, a trzeci (wywołujący) wypisuje odpowiedzi. Wątki są
+ * połączone buforami cyklicznymi, więc odpowiedzi i błędy są wypisywane
+ * w kolejności linii, tak jak przy wykonywaniu sekwencyjnym.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err   – wskaźnik na strukturę zapisującą błędy,
+ * @param[in,out] game  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] line_cnt  – liczba już przetworzonych linii.
+ * @return Wartość @p true, jeśli wszystkie polecenia zostały wykonane,
+ * a @p false, jeśli nie udało się zaalokować pamięci.
+ */
+bool pipeline_session(reader *input, writer *out, writer *err,
+                      gamma_t *game, int line_cnt)
+{
+    pipeline p = {.input = input, .game = game, .line_cnt = line_cnt,
+                  .memory_error = false};
+    pthread_t parser, executor;
+
+    if (ring_init(&p.parsed, PIPELINE_CAPACITY, sizeof(parsed_line)) == false)
+        return false;
+    if (ring_init(&p.answered, PIPELINE_CAPACITY, sizeof(answered_line)) == false)
+    {
+        ring_free(&p.parsed);
+        return false;
+    }
+
+    if (pthread_create(&parser, NULL, parse_stage, &p) != 0)
+    {
+        ring_free(&p.parsed);
+        ring_free(&p.answered);
+        return false;
+    }
+    if (pthread_create(&executor, NULL, execute_stage, &p) != 0)
+    {
+        // Bez wątku wykonującego polecenia opróżniamy bufor samodzielnie,
+        // żeby wątek wczytujący mógł się zakończyć.
+        parsed_line item;
+        do
+            ring_pop(&p.parsed, &item);
+        while (item.line != LINES_END);
+        pthread_join(parser, NULL);
+        ring_free(&p.parsed);
+        ring_free(&p.answered);
+        return false;
+    }
+
+    // Wątek wywołujący wypisuje odpowiedzi.
+    answered_line answer;
+    ring_pop(&p.answered, &answer);
+    while (answer.line != LINES_END)
+    {
+        print_response(out, err, answer.line, &answer.res);
+        ring_pop(&p.answered, &answer);
+    }
+
+    pthread_join(parser, NULL);
+    pthread_join(executor, NULL);
+    ring_free(&p.parsed);
+    ring_free(&p.answered);
+    return p.memory_error == false;
+}
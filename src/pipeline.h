@@ -0,0 +1,33 @@
+/** @file
+ * Interfejs potokowego wykonywania poleceń trybu wsadowego.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#ifndef GAMMA_PIPELINE_H
+#define GAMMA_PIPELINE_H
+
+#include <stdbool.h>
+#include "gamma.h"
+#include "reader.h"
+#include "writer.h"
+
+/** @brief Wykonuje pozostałe polecenia trybu wsadowego w trzech wątkach.
+ * Pierwszy wątek wczytuje i analizuje linie, drugi wykonuje polecenia na
+ * strukturze @p game, a trzeci (wywołujący) wypisuje odpowiedzi. Wątki są
+ * połączone buforami cyklicznymi, więc odpowiedzi i błędy są wypisywane
+ * w kolejności linii, tak jak przy wykonywaniu sekwencyjnym.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in,out] out   – wskaźnik na strukturę zapisującą odpowiedzi,
+ * @param[in,out] err   – wskaźnik na strukturę zapisującą błędy,
+ * @param[in,out] game  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] line_cnt  – liczba już przetworzonych linii.
+ * @return Wartość @p true, jeśli wszystkie polecenia zostały wykonane,
+ * a @p false, jeśli nie udało się zaalokować pamięci.
+ */
+bool pipeline_session(reader *input, writer *out, writer *err,
+                      gamma_t *game, int line_cnt);
+
+#endif //GAMMA_PIPELINE_H
@@ -0,0 +1,246 @@
+/** @file
+ * Implementacja modułu wczytującego kolejne linie poleceń.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 12 maja 2020
+ */
+
+/**
+ * Makro wymagane do poprawnego działania funkcji @ref madvise.
+ */
+#define _GNU_SOURCE
+
+#include "reader.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Początkowy rozmiar bufora na dane wejściowe.
+ */
+#define READ_BUFFER_SIZE (1 << 20)
+
+/** @brief Przygotowuje strukturę do wczytywania danych.
+ * @param[out] input – wskaźnik na inicjowaną strukturę,
+ * @param[in] fd     – deskryptor pliku, z którego będą wczytywane dane.
+ * @return Wartość @p true, jeśli udało się zaalokować bufor,
+ * a @p false w przeciwnym razie.
+ */
+bool reader_init(reader *input, int fd)
+{
+    input->fd = fd;
+    input->mem = READ_BUFFER_SIZE;
+    input->begin = 0;
+    input->end = 0;
+    input->eof = false;
+    input->mapped = false;
+    input->owns_fd = false;
+    input->buffer = malloc(input->mem * sizeof(char));
+    return input->buffer != NULL;
+}
+
+/** @brief Przygotowuje strukturę do wczytywania danych z pliku.
+ * Zwykły plik jest odwzorowywany w pamięci tylko do odczytu i służy
+ * bezpośrednio jako bufor, z którego udostępniane są kolejne linie. Jądro
+ * systemu jest informowane, że plik będzie czytany sekwencyjnie. Pliki
+ * innego rodzaju, np. potoki i urządzenia, są wczytywane blokami tak jak
+ * w @ref reader_init.
+ * @param[out] input – wskaźnik na inicjowaną strukturę,
+ * @param[in] path   – ścieżka do pliku z danymi wejściowymi.
+ * @return Wartość @p true, jeśli udało się otworzyć i odwzorować plik
+ * lub zaalokować bufor, a @p false w przeciwnym razie.
+ */
+bool reader_init_file(reader *input, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) == -1)
+    {
+        close(fd);
+        return false;
+    }
+
+    // Rozmiar potoku czy urządzenia nie mówi nic o danych, więc takie
+    // pliki są czytane zwykłym buforem aż do końca danych.
+    if (S_ISREG(info.st_mode) == false)
+    {
+        if (reader_init(input, fd) == false)
+        {
+            close(fd);
+            return false;
+        }
+        input->owns_fd = true;
+        return true;
+    }
+
+    input->fd = -1;
+    input->mem = info.st_size;
+    input->begin = 0;
+    input->end = info.st_size;
+    input->eof = true;
+    input->mapped = true;
+    input->owns_fd = false;
+    input->buffer = NULL;
+
+    // Pustego pliku nie da się odwzorować, ale nie ma też czego czytać.
+    if (input->mem > 0)
+    {
+        void *map = mmap(NULL, input->mem, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+        madvise(map, input->mem, MADV_SEQUENTIAL);
+        input->buffer = map;
+    }
+
+    close(fd);
+    return true;
+}
+
+/** @brief Wczytuje kolejny blok danych do bufora.
+ * Przesuwa nieprzetworzone dane na początek bufora, a jeśli zajmują one
+ * cały bufor, podwaja jego rozmiar.
+ * Funkcja pomocnicza w @ref reader_next_line.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane.
+ * @return Wartość @p true, jeśli operacja się powiodła, a @p false,
+ * jeśli nie udało się zaalokować pamięci.
+ */
+static bool refill(reader *input)
+{
+    if (input->begin > 0)
+    {
+        memmove(input->buffer, input->buffer + input->begin,
+                input->end - input->begin);
+        input->end -= input->begin;
+        input->begin = 0;
+    }
+
+    if (input->end == input->mem)
+    {
+        char *buffer = realloc(input->buffer, 2 * input->mem * sizeof(char));
+        if (buffer == NULL)
+            return false;
+        input->buffer = buffer;
+        input->mem *= 2;
+    }
+
+    ssize_t got;
+    do
+    {
+        got = read(input->fd, input->buffer + input->end, input->mem - input->end);
+    } while (got == -1 && errno == EINTR);
+
+    // Błąd odczytu traktujemy tak jak koniec danych.
+    if (got <= 0)
+        input->eof = true;
+    else
+        input->end += got;
+    return true;
+}
+
+/** @brief Udostępnia kolejną linię danych wejściowych.
+ * Linia zawiera kończący ją znak nowej linii, o ile występuje on
+ * w danych wejściowych. Wskaźnik @p line jest ważny do kolejnego
+ * wywołania tej funkcji.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[out] line     – wskaźnik na początek linii w buforze,
+ * @param[out] len      – długość linii.
+ * @return Wartość @p 1, jeśli udostępniono kolejną linię, @p 0, jeśli
+ * dane wejściowe się skończyły, a @p -1, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+int reader_next_line(reader *input, const char **line, size_t *len)
+{
+    if (input->begin == input->end && input->eof)
+        return 0;
+
+    // Od tego miejsca szukamy znaku nowej linii w buforze.
+    size_t checked = input->begin;
+    char *newline;
+
+    while ((newline = memchr(input->buffer + checked, '\n',
+                             input->end - checked)) == NULL)
+    {
+        if (input->eof)
+        {
+            // Ostatnia linia bez znaku nowej linii.
+            *line = input->buffer + input->begin;
+            *len = input->end - input->begin;
+            input->begin = input->end;
+            return 1;
+        }
+
+        checked = input->end - input->begin;
+        if (refill(input) == false)
+            return -1;
+    }
+
+    *line = input->buffer + input->begin;
+    *len = newline - *line + 1;
+    input->begin += *len;
+    return 1;
+}
+
+/** @brief Udostępnia co najmniej @p n kolejnych bajtów danych wejściowych.
+ * Bajty nie są uznawane za przetworzone, do tego służy @ref reader_consume.
+ * Wskaźnik @p data jest ważny do kolejnego wywołania funkcji wczytujących.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in] n         – oczekiwana liczba bajtów,
+ * @param[out] data     – wskaźnik na początek dostępnych bajtów w buforze.
+ * @return Liczba dostępnych bajtów, mniejsza od @p n tylko wtedy, gdy
+ * dane wejściowe się skończyły lub zabrakło pamięci.
+ */
+size_t reader_available(reader *input, size_t n, const char **data)
+{
+    while (input->end - input->begin < n && input->eof == false)
+    {
+        if (refill(input) == false)
+            break;
+    }
+
+    if (input->begin == input->end)
+        return 0;
+    *data = input->buffer + input->begin;
+    return input->end - input->begin;
+}
+
+/** @brief Oznacza @p n kolejnych bajtów danych wejściowych jako przetworzone.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in] n         – liczba bajtów, nie większa od liczby zwróconej
+ *                        przez @ref reader_available.
+ */
+void reader_consume(reader *input, size_t n)
+{
+    input->begin += n;
+}
+
+/** @brief Zwalnia pamięć zajmowaną przez strukturę wczytującą dane.
+ * Zamyka plik otwarty przez @ref reader_init_file.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane.
+ */
+void reader_free(reader *input)
+{
+    if (input->mapped)
+    {
+        if (input->buffer != NULL)
+            munmap(input->buffer, input->mem);
+    }
+    else
+    {
+        free(input->buffer);
+    }
+    if (input->owns_fd)
+        close(input->fd);
+    input->owns_fd = false;
+    input->buffer = NULL;
+}
@@ -0,0 +1,88 @@
+/** @file
+ * Interfejs modułu wczytującego kolejne linie poleceń.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 12 maja 2020
+ */
+
+#ifndef GAMMA_READER_H
+#define GAMMA_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief Struktura wczytująca dane wejściowe dużymi blokami.
+ * Kolejne linie są udostępniane bezpośrednio z bufora, bez kopiowania.
+ */
+typedef struct reader
+{
+    int fd; ///< Deskryptor pliku, z którego wczytywane są dane.
+    char *buffer; ///< Bufor na wczytane dane.
+    size_t mem; ///< Rozmiar zaalokowanego bufora.
+    size_t begin; ///< Początek nieprzetworzonych danych w buforze.
+    size_t end; ///< Koniec wczytanych danych w buforze.
+    bool eof; ///< Czy wczytano już wszystkie dane.
+    bool mapped; ///< Czy bufor jest odwzorowaniem pliku w pamięci.
+    bool owns_fd; ///< Czy deskryptor pliku należy zamknąć przy zwalnianiu.
+} reader;
+
+/** @brief Przygotowuje strukturę do wczytywania danych.
+ * @param[out] input – wskaźnik na inicjowaną strukturę,
+ * @param[in] fd     – deskryptor pliku, z którego będą wczytywane dane.
+ * @return Wartość @p true, jeśli udało się zaalokować bufor,
+ * a @p false w przeciwnym razie.
+ */
+bool reader_init(reader *input, int fd);
+
+/** @brief Przygotowuje strukturę do wczytywania danych z pliku.
+ * Zwykły plik jest odwzorowywany w pamięci tylko do odczytu i służy
+ * bezpośrednio jako bufor, z którego udostępniane są kolejne linie. Jądro
+ * systemu jest informowane, że plik będzie czytany sekwencyjnie. Pliki
+ * innego rodzaju, np. potoki i urządzenia, są wczytywane blokami tak jak
+ * w @ref reader_init.
+ * @param[out] input – wskaźnik na inicjowaną strukturę,
+ * @param[in] path   – ścieżka do pliku z danymi wejściowymi.
+ * @return Wartość @p true, jeśli udało się otworzyć i odwzorować plik
+ * lub zaalokować bufor, a @p false w przeciwnym razie.
+ */
+bool reader_init_file(reader *input, const char *path);
+
+/** @brief Udostępnia kolejną linię danych wejściowych.
+ * Linia zawiera kończący ją znak nowej linii, o ile występuje on
+ * w danych wejściowych. Wskaźnik @p line jest ważny do kolejnego
+ * wywołania tej funkcji.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[out] line     – wskaźnik na początek linii w buforze,
+ * @param[out] len      – długość linii.
+ * @return Wartość @p 1, jeśli udostępniono kolejną linię, @p 0, jeśli
+ * dane wejściowe się skończyły, a @p -1, jeśli nie udało się
+ * zaalokować pamięci.
+ */
+int reader_next_line(reader *input, const char **line, size_t *len);
+
+/** @brief Udostępnia co najmniej @p n kolejnych bajtów danych wejściowych.
+ * Bajty nie są uznawane za przetworzone, do tego służy @ref reader_consume.
+ * Wskaźnik @p data jest ważny do kolejnego wywołania funkcji wczytujących.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in] n         – oczekiwana liczba bajtów,
+ * @param[out] data     – wskaźnik na początek dostępnych bajtów w buforze.
+ * @return Liczba dostępnych bajtów, mniejsza od @p n tylko wtedy, gdy
+ * dane wejściowe się skończyły lub zabrakło pamięci.
+ */
+size_t reader_available(reader *input, size_t n, const char **data);
+
+/** @brief Oznacza @p n kolejnych bajtów danych wejściowych jako przetworzone.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane,
+ * @param[in] n         – liczba bajtów, nie większa od liczby zwróconej
+ *                        przez @ref reader_available.
+ */
+void reader_consume(reader *input, size_t n);
+
+/** @brief Zwalnia pamięć zajmowaną przez strukturę wczytującą dane.
+ * Zamyka plik otwarty przez @ref reader_init_file.
+ * @param[in,out] input – wskaźnik na strukturę wczytującą dane.
+ */
+void reader_free(reader *input);
+
+#endif //GAMMA_READER_H
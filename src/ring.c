@@ -0,0 +1,141 @@
+/** @file
+ * Implementacja bufora cyklicznego łączącego dwa wątki.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+/**
+ * Makro wymagane do poprawnego działania funkcji @ref syscall.
+ */
+#define _GNU_SOURCE
+
+#include "ring.h"
+#include <linux/futex.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * Liczba oddań procesora, po których czekający wątek usypia na futeksie.
+ */
+#define RING_SPINS 128
+
+/** @brief Usypia wątek, dopóki flaga ma wartość jeden.
+ * @param[in] flag    – wskaźnik na flagę.
+ */
+static void ring_sleep(atomic_uint *flag)
+{
+    syscall(SYS_futex, (unsigned *) flag, FUTEX_WAIT_PRIVATE, 1, NULL, NULL, 0);
+}
+
+/** @brief Budzi wątek śpiący na fladze, jeśli taki jest.
+ * Wywoływana po opublikowaniu nowej wartości licznika. Bariera pełna
+ * paruje się z barierą w @ref ring_wait, więc albo śpiący zobaczy nowy
+ * licznik, albo ta funkcja zobaczy ustawioną flagę.
+ * @param[in,out] flag    – wskaźnik na flagę.
+ */
+static void ring_wake(atomic_uint *flag)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(flag, memory_order_relaxed) != 0)
+    {
+        atomic_store_explicit(flag, 0, memory_order_relaxed);
+        syscall(SYS_futex, (unsigned *) flag, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+/** @brief Czeka, aż licznik drugiej strony będzie różny od @p value.
+ * Najpierw oddaje procesor @ref RING_SPINS razy, a potem usypia na fladze.
+ * @param[in] counter – wskaźnik na licznik drugiej strony,
+ * @param[in] value   – wartość, przy której trzeba czekać,
+ * @param[in,out] flag    – wskaźnik na flagę snu czekającego wątku.
+ */
+static void ring_wait(atomic_size_t *counter, size_t value, atomic_uint *flag)
+{
+    for (int i = 0; i < RING_SPINS; i++)
+    {
+        if (atomic_load_explicit(counter, memory_order_acquire) != value)
+            return;
+        sched_yield();
+    }
+
+    for (;;)
+    {
+        atomic_store_explicit(flag, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load_explicit(counter, memory_order_acquire) != value)
+        {
+            atomic_store_explicit(flag, 0, memory_order_relaxed);
+            return;
+        }
+        ring_sleep(flag);
+    }
+}
+
+/** @brief Przygotowuje bufor cykliczny.
+ * @param[out] r        – wskaźnik na inicjowany bufor,
+ * @param[in] capacity  – pojemność bufora, potęga dwójki,
+ * @param[in] item_size – rozmiar jednego elementu.
+ * @return Wartość @p true, jeśli udało się zaalokować pamięć,
+ * a @p false w przeciwnym razie.
+ */
+bool ring_init(ring *r, size_t capacity, size_t item_size)
+{
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->consumer_sleeps, 0);
+    atomic_init(&r->producer_sleeps, 0);
+    r->mask = capacity - 1;
+    r->item_size = item_size;
+    r->items = malloc(capacity * item_size);
+    return r->items != NULL;
+}
+
+/** @brief Wkłada element do bufora.
+ * Jeśli bufor jest pełny, czeka aż konsument zwolni miejsce – najpierw
+ * aktywnie, a potem śpiąc. Budzi konsumenta, jeśli ten śpi.
+ * Może być wywoływana tylko przez wątek producenta.
+ * @param[in,out] r  – wskaźnik na bufor,
+ * @param[in] item   – wskaźnik na wkładany element.
+ */
+void ring_push(ring *r, const void *item)
+{
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&r->tail, memory_order_acquire) > r->mask)
+        ring_wait(&r->tail, head - r->mask - 1, &r->producer_sleeps);
+
+    memcpy(r->items + (head & r->mask) * r->item_size, item, r->item_size);
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    ring_wake(&r->consumer_sleeps);
+}
+
+/** @brief Wyjmuje element z bufora.
+ * Jeśli bufor jest pusty, czeka aż producent włoży element – najpierw
+ * aktywnie, a potem śpiąc. Budzi producenta, jeśli ten śpi.
+ * Może być wywoływana tylko przez wątek konsumenta.
+ * @param[in,out] r  – wskaźnik na bufor,
+ * @param[out] item  – wskaźnik na miejsce na wyjęty element.
+ */
+void ring_pop(ring *r, void *item)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (atomic_load_explicit(&r->head, memory_order_acquire) == tail)
+        ring_wait(&r->head, tail, &r->consumer_sleeps);
+
+    memcpy(item, r->items + (tail & r->mask) * r->item_size, r->item_size);
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    ring_wake(&r->producer_sleeps);
+}
+
+/** @brief Zwalnia pamięć zajmowaną przez bufor.
+ * @param[in,out] r  – wskaźnik na bufor.
+ */
+void ring_free(ring *r)
+{
+    free(r->items);
+    r->items = NULL;
+}
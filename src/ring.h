@@ -0,0 +1,64 @@
+/** @file
+ * Interfejs bufora cyklicznego łączącego dwa wątki.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#ifndef GAMMA_RING_H
+#define GAMMA_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief Bufor cykliczny bez blokad dla jednego producenta i jednego konsumenta.
+ * Elementy mają stały rozmiar i są kopiowane do bufora. Liczniki producenta
+ * i konsumenta leżą w osobnych liniach pamięci podręcznej. Wątek, który
+ * długo czeka na drugą stronę, usypia na futeksie zamiast kręcić się w pętli.
+ */
+typedef struct ring
+{
+    _Alignas(64) atomic_size_t head; ///< Liczba elementów włożonych do bufora.
+    atomic_uint consumer_sleeps; ///< Czy konsument śpi, czekając na element.
+    _Alignas(64) atomic_size_t tail; ///< Liczba elementów wyjętych z bufora.
+    atomic_uint producer_sleeps; ///< Czy producent śpi, czekając na miejsce.
+    _Alignas(64) size_t mask; ///< Pojemność bufora pomniejszona o jeden.
+    size_t item_size; ///< Rozmiar jednego elementu.
+    char *items; ///< Tablica na elementy.
+} ring;
+
+/** @brief Przygotowuje bufor cykliczny.
+ * @param[out] r        – wskaźnik na inicjowany bufor,
+ * @param[in] capacity  – pojemność bufora, potęga dwójki,
+ * @param[in] item_size – rozmiar jednego elementu.
+ * @return Wartość @p true, jeśli udało się zaalokować pamięć,
+ * a @p false w przeciwnym razie.
+ */
+bool ring_init(ring *r, size_t capacity, size_t item_size);
+
+/** @brief Wkłada element do bufora.
+ * Jeśli bufor jest pełny, czeka aż konsument zwolni miejsce – najpierw
+ * aktywnie, a potem śpiąc. Budzi konsumenta, jeśli ten śpi.
+ * Może być wywoływana tylko przez wątek producenta.
+ * @param[in,out] r  – wskaźnik na bufor,
+ * @param[in] item   – wskaźnik na wkładany element.
+ */
+void ring_push(ring *r, const void *item);
+
+/** @brief Wyjmuje element z bufora.
+ * Jeśli bufor jest pusty, czeka aż producent włoży element – najpierw
+ * aktywnie, a potem śpiąc. Budzi producenta, jeśli ten śpi.
+ * Może być wywoływana tylko przez wątek konsumenta.
+ * @param[in,out] r  – wskaźnik na bufor,
+ * @param[out] item  – wskaźnik na miejsce na wyjęty element.
+ */
+void ring_pop(ring *r, void *item);
+
+/** @brief Zwalnia pamięć zajmowaną przez bufor.
+ * @param[in,out] r  – wskaźnik na bufor.
+ */
+void ring_free(ring *r);
+
+#endif //GAMMA_RING_H
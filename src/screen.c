@@ -0,0 +1,340 @@
+/** @file
+ * Implementacja podwójnie buforowanego ekranu terminala.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 22 maja 2020
+ */
+
+#include "screen.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Największa liczba bajtów wysyłanych do terminala dla jednego znaku:
+ * przesunięcie kursora, zmiana stylu i sam znak.
+ */
+#define MAX_CELL_BYTES 32
+
+/**
+ * Liczba bajtów zarezerwowanych na sekwencje czyszczące ekran.
+ */
+#define EXTRA_BYTES 64
+
+/**
+ * Parametry sekwencji ANSI ustawiających kolejne style. Każda zaczyna się
+ * od przywrócenia domyślnych kolorów, więc nie zależy od stylu poprzedniego.
+ */
+static const char *const sgr[] = {
+    "0", "0;97;42", "0;97;41", "0;97;44", "0;1;36",
+    "0;37", "0;1;37", "0;1;32", "0;1;31", "0;1;33"
+};
+
+/** @brief Ustawia znak na pusty znak w domyślnym stylu.
+ * @param[out] c – wskaźnik na znak.
+ */
+static void blank(cell *c)
+{
+    memset(c->glyph, 0, sizeof(c->glyph));
+    c->glyph[0] = ' ';
+    c->len = 1;
+    c->style = STYLE_PLAIN;
+}
+
+/** @brief Porównuje dwa znaki na ekranie.
+ * @param[in] a – wskaźnik na pierwszy znak,
+ * @param[in] b – wskaźnik na drugi znak.
+ * @return Wartość @p true, jeśli znaki i ich style są równe,
+ * a @p false w przeciwnym razie.
+ */
+static inline bool same_cell(const cell *a, const cell *b)
+{
+    return a->len == b->len && a->style == b->style
+           && memcmp(a->glyph, b->glyph, sizeof(a->glyph)) == 0;
+}
+
+/** @brief Liczba znaków na całym ekranie.
+ * @param[in] s – wskaźnik na ekran.
+ * @return Iloczyn liczby wierszy i kolumn.
+ */
+static inline size_t cells(const screen *s)
+{
+    return (size_t) s->rows * s->cols;
+}
+
+/** @brief Przygotowuje ekran o danych wymiarach.
+ * @param[out] s   – wskaźnik na inicjowaną strukturę,
+ * @param[in] fd   – deskryptor terminala,
+ * @param[in] rows – liczba wierszy ekranu,
+ * @param[in] cols – liczba kolumn ekranu.
+ * @return Wartość @p true, jeśli ekran został przygotowany, a @p false,
+ * jeśli zabrakło pamięci.
+ */
+bool screen_init(screen *s, int fd, uint rows, uint cols)
+{
+    s->fd = fd;
+    s->rows = rows;
+    s->cols = cols;
+    s->drawn = false;
+    s->shown_style = -1;
+    s->row = 0;
+    s->col = 0;
+    s->pen = STYLE_PLAIN;
+    s->out_len = 0;
+    s->front = malloc(cells(s) * sizeof(cell) + 1);
+    s->back = malloc(cells(s) * sizeof(cell) + 1);
+    s->out = malloc(cells(s) * MAX_CELL_BYTES + EXTRA_BYTES);
+    if (s->front == NULL || s->back == NULL || s->out == NULL)
+    {
+        free(s->front);
+        free(s->back);
+        free(s->out);
+        s->front = s->back = NULL;
+        s->out = NULL;
+        return false;
+    }
+    for (size_t i = 0; i < cells(s); ++i)
+    {
+        blank(&s->front[i]);
+        blank(&s->back[i]);
+    }
+    return true;
+}
+
+/** @brief Rozpoczyna rysowanie nowej klatki od pustego ekranu.
+ * @param[in,out] s – wskaźnik na ekran.
+ */
+void screen_clear(screen *s)
+{
+    for (size_t i = 0; i < cells(s); ++i)
+        blank(&s->back[i]);
+    s->row = 0;
+    s->col = 0;
+    s->pen = STYLE_PLAIN;
+}
+
+/** @brief Ustawia miejsce rysowania kolejnych znaków.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] row   – numer wiersza, licząc od zera,
+ * @param[in] col   – numer kolumny, licząc od zera.
+ */
+void screen_move(screen *s, uint row, uint col)
+{
+    s->row = row;
+    s->col = col;
+}
+
+/** @brief Ustawia styl kolejnych rysowanych znaków.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] pen   – styl.
+ */
+void screen_style(screen *s, style pen)
+{
+    s->pen = pen;
+}
+
+/** @brief Rysuje jeden znak i przesuwa miejsce rysowania o kolumnę.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] glyph – wskaźnik na pierwszy bajt znaku,
+ * @param[in] len   – liczba bajtów znaku, od 1 do 4.
+ */
+static void put_glyph(screen *s, const char *glyph, uint len)
+{
+    if (s->row < s->rows && s->col < s->cols)
+    {
+        cell *c = &s->back[(size_t) s->row * s->cols + s->col];
+        memset(c->glyph, 0, sizeof(c->glyph));
+        memcpy(c->glyph, glyph, len);
+        c->len = len;
+        c->style = s->pen;
+    }
+    if (s->col < s->cols)
+        s->col++;
+}
+
+/** @brief Podaje liczbę bajtów znaku UTF-8.
+ * @param[in] text – wskaźnik na pierwszy bajt znaku.
+ * @return Liczba bajtów znaku, nie większa niż liczba bajtów do końca napisu.
+ */
+static uint glyph_len(const char *text)
+{
+    unsigned char lead = *text;
+    uint len = lead < 0x80 ? 1 : lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : 4;
+    for (uint i = 1; i < len; ++i)
+    {
+        if (text[i] == '\0')
+            return i;
+    }
+    return len;
+}
+
+/** @brief Rysuje napis w bieżącym wierszu.
+ * Każdy znak UTF-8 zajmuje jedną kolumnę. Znaki poza ekranem są pomijane.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] text  – napis zakończony znakiem zerowym.
+ */
+void screen_put(screen *s, const char *text)
+{
+    while (*text != '\0')
+    {
+        uint len = glyph_len(text);
+        put_glyph(s, text, len);
+        text += len;
+    }
+}
+
+/** @brief Rysuje znak powtórzony kilka razy.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] glyph – znak UTF-8 zakończony znakiem zerowym,
+ * @param[in] count – liczba powtórzeń.
+ */
+void screen_repeat(screen *s, const char *glyph, uint count)
+{
+    uint len = glyph_len(glyph);
+    for (uint i = 0; i < count && s->col < s->cols; ++i)
+        put_glyph(s, glyph, len);
+}
+
+/** @brief Rysuje liczbę w zapisie dziesiętnym.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] n     – liczba.
+ */
+void screen_put_number(screen *s, muint n)
+{
+    char digits[24];
+    snprintf(digits, sizeof(digits), "%lu", n);
+    screen_put(s, digits);
+}
+
+/** @brief Dopisuje napis do bufora sekwencji.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] text  – dopisywane bajty,
+ * @param[in] len   – liczba bajtów.
+ */
+static inline void emit(screen *s, const char *text, size_t len)
+{
+    memcpy(s->out + s->out_len, text, len);
+    s->out_len += len;
+}
+
+/** @brief Dopisuje do bufora sekwencję przesuwającą kursor terminala.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] row   – numer wiersza, licząc od zera,
+ * @param[in] col   – numer kolumny, licząc od zera.
+ */
+static void emit_move(screen *s, uint row, uint col)
+{
+    s->out_len += sprintf(s->out + s->out_len, "\033[%u;%uH", row + 1, col + 1);
+}
+
+/** @brief Dopisuje do bufora sekwencję ustawiającą styl.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] pen   – styl.
+ */
+static void emit_style(screen *s, int pen)
+{
+    s->out_len += sprintf(s->out + s->out_len, "\033[%sm", sgr[pen]);
+    s->shown_style = pen;
+}
+
+/** @brief Wysyła zawartość bufora sekwencji do terminala.
+ * @param[in,out] s – wskaźnik na ekran.
+ * @return Wartość @p true, jeśli wszystkie bajty zostały zapisane,
+ * a @p false w przeciwnym razie.
+ */
+static bool flush_out(screen *s)
+{
+    size_t done = 0;
+    while (done < s->out_len)
+    {
+        ssize_t n = write(s->fd, s->out + done, s->out_len - done);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            s->out_len = 0;
+            return false;
+        }
+        done += n;
+    }
+    s->out_len = 0;
+    return true;
+}
+
+/** @brief Wyświetla narysowaną klatkę.
+ * Wysyła do terminala jednym wywołaniem @p write tylko zmienione znaki,
+ * przesuwając kursor terminala i zmieniając styl wyłącznie wtedy, gdy
+ * jest to potrzebne.
+ * @param[in,out] s – wskaźnik na ekran.
+ * @return Wartość @p true, jeśli klatka została wyświetlona, a @p false,
+ * jeśli zapis do terminala się nie powiódł.
+ */
+bool screen_present(screen *s)
+{
+    // Pierwsza klatka zaczyna się od wyczyszczenia terminala,
+    // po którym wystarczy narysować niepuste znaki.
+    uint at_row = 0, at_col = 0;
+    if (s->drawn == false)
+    {
+        emit_style(s, STYLE_PLAIN);
+        emit(s, "\033[H\033[2J", 7);
+        s->drawn = true;
+    }
+    else
+    {
+        at_row = s->rows;
+    }
+
+    for (size_t i = 0; i < cells(s); ++i)
+    {
+        if (same_cell(&s->front[i], &s->back[i]))
+            continue;
+
+        uint row = i / s->cols, col = i % s->cols;
+        if (row != at_row || col != at_col)
+            emit_move(s, row, col);
+        if (s->back[i].style != s->shown_style)
+            emit_style(s, s->back[i].style);
+        emit(s, s->back[i].glyph, s->back[i].len);
+        at_row = row;
+        at_col = col + 1;
+        s->front[i] = s->back[i];
+    }
+
+    return flush_out(s);
+}
+
+/** @brief Zwalnia ekran i ustawia kursor terminala pod jego zawartością.
+ * @param[in,out] s – wskaźnik na ekran.
+ */
+void screen_free(screen *s)
+{
+    if (s->front == NULL)
+        return;
+
+    // Kursor trafia do wiersza pod ostatnim niepustym wierszem.
+    uint last = 0;
+    cell empty;
+    blank(&empty);
+    for (size_t i = 0; i < cells(s); ++i)
+    {
+        if (same_cell(&s->front[i], &empty) == false)
+            last = i / s->cols;
+    }
+    if (s->drawn)
+    {
+        emit_style(s, STYLE_PLAIN);
+        emit_move(s, last, 0);
+        emit(s, "\n", 1);
+        flush_out(s);
+    }
+
+    free(s->front);
+    free(s->back);
+    free(s->out);
+    s->front = s->back = NULL;
+    s->out = NULL;
+}
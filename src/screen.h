@@ -0,0 +1,125 @@
+/** @file
+ * Interfejs podwójnie buforowanego ekranu terminala.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 22 maja 2020
+ */
+
+#ifndef GAMMA_SCREEN_H
+#define GAMMA_SCREEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "gamma.h"
+
+/** @brief Styl znaku na ekranie.
+ * Każdy styl odpowiada jednej sekwencji ANSI ustawiającej kolory.
+ */
+typedef enum style
+{
+    STYLE_PLAIN, ///< Domyślne kolory terminala.
+    STYLE_OWN, ///< Pole gracza, który może zająć kolejny obszar.
+    STYLE_OWN_FULL, ///< Pole gracza, który zajął już wszystkie obszary.
+    STYLE_CURSOR, ///< Pole pod kursorem.
+    STYLE_TITLE, ///< Nagłówek.
+    STYLE_LABEL, ///< Opis wartości.
+    STYLE_VALUE, ///< Wartość.
+    STYLE_GOOD, ///< Wartość korzystna dla gracza.
+    STYLE_BAD, ///< Wartość niekorzystna dla gracza.
+    STYLE_BEST ///< Najlepszy wynik.
+} style;
+
+/** @brief Znak na ekranie wraz ze stylem.
+ */
+typedef struct cell
+{
+    char glyph[4]; ///< Znak zapisany w UTF-8.
+    unsigned char len; ///< Liczba bajtów znaku.
+    unsigned char style; ///< Styl znaku.
+} cell;
+
+/** @brief Ekran terminala z buforem rysowanej klatki.
+ * Klatka jest rysowana w pamięci, a do terminala trafiają tylko znaki,
+ * które różnią się od poprzednio wyświetlonej klatki.
+ */
+typedef struct screen
+{
+    int fd; ///< Deskryptor terminala.
+    uint rows; ///< Liczba wierszy ekranu.
+    uint cols; ///< Liczba kolumn ekranu.
+    cell *front; ///< Zawartość terminala po wyświetleniu ostatniej klatki.
+    cell *back; ///< Rysowana klatka.
+    bool drawn; ///< Czy @p front odpowiada zawartości terminala.
+    int shown_style; ///< Styl ustawiony w terminalu lub -1, jeśli nieznany.
+    uint row; ///< Wiersz, w którym zostanie narysowany kolejny znak.
+    uint col; ///< Kolumna, w której zostanie narysowany kolejny znak.
+    style pen; ///< Styl kolejnych rysowanych znaków.
+    char *out; ///< Bufor sekwencji wysyłanych do terminala.
+    size_t out_len; ///< Liczba bajtów w buforze sekwencji.
+} screen;
+
+/** @brief Przygotowuje ekran o danych wymiarach.
+ * @param[out] s   – wskaźnik na inicjowaną strukturę,
+ * @param[in] fd   – deskryptor terminala,
+ * @param[in] rows – liczba wierszy ekranu,
+ * @param[in] cols – liczba kolumn ekranu.
+ * @return Wartość @p true, jeśli ekran został przygotowany, a @p false,
+ * jeśli zabrakło pamięci.
+ */
+bool screen_init(screen *s, int fd, uint rows, uint cols);
+
+/** @brief Rozpoczyna rysowanie nowej klatki od pustego ekranu.
+ * @param[in,out] s – wskaźnik na ekran.
+ */
+void screen_clear(screen *s);
+
+/** @brief Ustawia miejsce rysowania kolejnych znaków.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] row   – numer wiersza, licząc od zera,
+ * @param[in] col   – numer kolumny, licząc od zera.
+ */
+void screen_move(screen *s, uint row, uint col);
+
+/** @brief Ustawia styl kolejnych rysowanych znaków.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] pen   – styl.
+ */
+void screen_style(screen *s, style pen);
+
+/** @brief Rysuje napis w bieżącym wierszu.
+ * Każdy znak UTF-8 zajmuje jedną kolumnę. Znaki poza ekranem są pomijane.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] text  – napis zakończony znakiem zerowym.
+ */
+void screen_put(screen *s, const char *text);
+
+/** @brief Rysuje znak powtórzony kilka razy.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] glyph – znak UTF-8 zakończony znakiem zerowym,
+ * @param[in] count – liczba powtórzeń.
+ */
+void screen_repeat(screen *s, const char *glyph, uint count);
+
+/** @brief Rysuje liczbę w zapisie dziesiętnym.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] n     – liczba.
+ */
+void screen_put_number(screen *s, muint n);
+
+/** @brief Wyświetla narysowaną klatkę.
+ * Wysyła do terminala jednym wywołaniem @p write tylko zmienione znaki,
+ * przesuwając kursor terminala i zmieniając styl wyłącznie wtedy, gdy
+ * jest to potrzebne.
+ * @param[in,out] s – wskaźnik na ekran.
+ * @return Wartość @p true, jeśli klatka została wyświetlona, a @p false,
+ * jeśli zapis do terminala się nie powiódł.
+ */
+bool screen_present(screen *s);
+
+/** @brief Zwalnia ekran i ustawia kursor terminala pod jego zawartością.
+ * @param[in,out] s – wskaźnik na ekran.
+ */
+void screen_free(screen *s);
+
+#endif //GAMMA_SCREEN_H
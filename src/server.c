@@ -0,0 +1,572 @@
+/** @file
+ * Implementacja serwera gry gamma działającego na gnieździe lokalnym.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+/**
+ * Makro wymagane do poprawnego działania funkcji @ref accept4.
+ */
+#define _GNU_SOURCE
+
+#include "server.h"
+#include "batch.h"
+#include "parser.h"
+#include "writer.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * Długość kolejki połączeń oczekujących na przyjęcie.
+ */
+#define SERVER_BACKLOG 128
+
+/**
+ * Największa liczba zdarzeń obsługiwanych po jednym wywołaniu epoll_wait.
+ */
+#define MAX_EVENTS 64
+
+/**
+ * Liczba bajtów wczytywanych z gniazda jednym wywołaniem read.
+ */
+#define INPUT_CHUNK (1 << 16)
+
+/**
+ * Największa długość linii przechowywanej w całości, dłuższe linie
+ * są pomijane i traktowane jako błędne.
+ */
+#define MAX_LINE (1 << 20)
+
+/**
+ * Liczba znaków oczekujących na wysłanie, po przekroczeniu której serwer
+ * przestaje wczytywać polecenia od klienta.
+ */
+#define OUTPUT_LIMIT (1 << 20)
+
+/** @brief Stan jednego połączenia z klientem.
+ */
+typedef struct connection
+{
+    int fd; ///< Deskryptor gniazda połączenia.
+    gamma_t *game; ///< Stan gry lub NULL, jeśli gra nie została utworzona.
+    muint line_cnt; ///< Liczba wczytanych linii.
+    char *input; ///< Bufor z niezakończoną linią.
+    size_t input_len; ///< Liczba znaków w buforze wejściowym.
+    size_t input_mem; ///< Rozmiar bufora wejściowego.
+    bool skipping; ///< Czy pomijana jest zbyt długa linia.
+    bool skipping_comment; ///< Czy pomijana linia jest komentarzem.
+    bool closing; ///< Czy klient zakończył wysyłanie poleceń.
+    uint32_t events; ///< Zdarzenia, na które aktualnie czeka połączenie.
+    writer out; ///< Bufor z odpowiedziami oczekującymi na wysłanie.
+    struct connection *prev; ///< Poprzednie połączenie tego samego wątku.
+    struct connection *next; ///< Następne połączenie tego samego wątku.
+} connection;
+
+struct server;
+
+/** @brief Stan wątku obsługującego połączenia.
+ */
+typedef struct server_thread
+{
+    pthread_t thread; ///< Wątek obsługujący połączenia.
+    int epoll_fd; ///< Deskryptor pętli zdarzeń wątku.
+    struct server *srv; ///< Serwer, do którego należy wątek.
+    connection *connections; ///< Lista połączeń obsługiwanych przez wątek.
+} server_thread;
+
+/** @brief Stan serwera współdzielony przez wątki.
+ */
+typedef struct server
+{
+    int listen_fd; ///< Deskryptor gniazda przyjmującego połączenia.
+    int stop_fd; ///< Deskryptor zdarzenia oznaczającego koniec pracy.
+    dev_t socket_dev; ///< Urządzenie pliku gniazda utworzonego przez serwer.
+    ino_t socket_ino; ///< Numer i-węzła pliku gniazda utworzonego przez serwer.
+} server;
+
+/** @brief Zamyka połączenie i zwalnia jego stan wraz z grą.
+ * Funkcja pomocnicza w @ref handle_connection i @ref serve.
+ * @param[in,out] t – wskaźnik na stan wątku,
+ * @param[in,out] c – wskaźnik na zamykane połączenie.
+ */
+static void connection_close(server_thread *t, connection *c)
+{
+    epoll_ctl(t->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+
+    if (c->prev != NULL)
+        c->prev->next = c->next;
+    else
+        t->connections = c->next;
+    if (c->next != NULL)
+        c->next->prev = c->prev;
+
+    // Odpowiedzi, których nie udało się wysłać, przepadają.
+    c->out.len = 0;
+    writer_free(&c->out);
+    gamma_delete(c->game);
+    free(c->input);
+    free(c);
+}
+
+/** @brief Przyjmuje oczekujące połączenia.
+ * Każde połączenie trafia do pętli zdarzeń wątku, który je przyjął.
+ * Funkcja pomocnicza w @ref serve.
+ * @param[in,out] t – wskaźnik na stan wątku.
+ */
+static void accept_clients(server_thread *t)
+{
+    int fd;
+    while ((fd = accept4(t->srv->listen_fd, NULL, NULL,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+    {
+        connection *c = calloc(1, sizeof(connection));
+        if (c == NULL || writer_init(&c->out, fd, FLUSH_MANUAL) == false)
+        {
+            free(c);
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->events = EPOLLIN;
+
+        struct epoll_event event = {.events = c->events, .data.ptr = c};
+        if (epoll_ctl(t->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+        {
+            writer_free(&c->out);
+            free(c);
+            close(fd);
+            continue;
+        }
+
+        c->next = t->connections;
+        if (c->next != NULL)
+            c->next->prev = c;
+        t->connections = c;
+    }
+}
+
+/** @brief Wykonuje jedno polecenie klienta.
+ * Odpowiedź oraz ewentualny błąd trafiają do bufora połączenia.
+ * Funkcja pomocnicza w @ref process_input.
+ * @param[in,out] c  – wskaźnik na połączenie,
+ * @param[in] line   – linia z poleceniem,
+ * @param[in] len    – długość linii.
+ */
+static void execute_line(connection *c, const char *line, size_t len)
+{
+    command cmd;
+    response res;
+
+    c->line_cnt++;
+    int dir = parse_line(line, len, &cmd);
+    if (dir == -1)
+        return;
+
+    if (dir == 1)
+        execute_command(&c->game, &cmd, &res);
+    else
+        response_init(&res);
+    print_response(&c->out, &c->out, c->line_cnt, &res);
+}
+
+/** @brief Kończy pomijanie zbyt długiej linii.
+ * Linia jest błędna, chyba że jest komentarzem.
+ * Funkcja pomocnicza w @ref process_input.
+ * @param[in,out] c  – wskaźnik na połączenie.
+ */
+static void end_skipping(connection *c)
+{
+    c->skipping = false;
+    c->line_cnt++;
+    if (c->skipping_comment == false)
+    {
+        response res;
+        response_init(&res);
+        print_response(&c->out, &c->out, c->line_cnt, &res);
+    }
+}
+
+/** @brief Wykonuje polecenia z pełnych linii w buforze wejściowym.
+ * Przerywa, gdy odpowiedzi oczekujących na wysłanie jest zbyt dużo.
+ * Po zakończeniu danych od klienta wykonuje też ostatnią linię bez znaku
+ * końca linii, tak jak w trybie wsadowym.
+ * Funkcja pomocnicza w @ref read_input i @ref handle_connection.
+ * @param[in,out] c  – wskaźnik na połączenie.
+ */
+static void process_input(connection *c)
+{
+    size_t begin = 0;
+    char *newline;
+
+    while ((newline = memchr(c->input + begin, '\n', c->input_len - begin)) != NULL)
+    {
+        if (OUTPUT_LIMIT <= c->out.len)
+            break;
+
+        size_t end = newline - c->input + 1;
+        if (c->skipping)
+            end_skipping(c);
+        else
+            execute_line(c, c->input + begin, end - begin);
+        begin = end;
+    }
+
+    memmove(c->input, c->input + begin, c->input_len - begin);
+    c->input_len -= begin;
+    if (newline != NULL)
+        return;
+
+    if (c->closing)
+    {
+        if (c->skipping)
+            end_skipping(c);
+        else if (0 < c->input_len)
+            execute_line(c, c->input, c->input_len);
+        c->input_len = 0;
+    }
+    else if (MAX_LINE <= c->input_len)
+    {
+        // Zbyt długa linia nie jest przechowywana, pamiętamy tylko jej początek.
+        if (c->skipping == false)
+        {
+            c->skipping = true;
+            c->skipping_comment = c->input[0] == '#';
+        }
+        c->input_len = 0;
+    }
+}
+
+/** @brief Wczytuje kolejną porcję danych od klienta.
+ * Funkcja pomocnicza w @ref handle_connection.
+ * @param[in,out] c  – wskaźnik na połączenie.
+ * @return Wartość @p false, jeśli wystąpił błąd połączenia lub zabrakło
+ * pamięci, a @p true w przeciwnym razie.
+ */
+static bool read_input(connection *c)
+{
+    if (c->input_mem - c->input_len < INPUT_CHUNK)
+    {
+        size_t mem = c->input_len + INPUT_CHUNK;
+        char *input = realloc(c->input, mem * sizeof(char));
+        if (input == NULL)
+            return false;
+        c->input = input;
+        c->input_mem = mem;
+    }
+
+    ssize_t done = read(c->fd, c->input + c->input_len, c->input_mem - c->input_len);
+    if (done == -1)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    if (done == 0)
+        c->closing = true;
+    c->input_len += done;
+    process_input(c);
+    return true;
+}
+
+/** @brief Wysyła klientowi odpowiedzi oczekujące w buforze.
+ * Funkcja pomocnicza w @ref handle_connection.
+ * @param[in,out] c  – wskaźnik na połączenie.
+ * @return Wartość @p false, jeśli wystąpił błąd połączenia,
+ * a @p true w przeciwnym razie.
+ */
+static bool write_output(connection *c)
+{
+    while (0 < c->out.len)
+    {
+        ssize_t done = write(c->fd, c->out.buffer, c->out.len);
+        if (done == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        writer_drain(&c->out, done);
+    }
+    return true;
+}
+
+/** @brief Ustawia zdarzenia, na które czeka połączenie.
+ * Połączenie czeka na dane od klienta, dopóki ten ich nie zakończył,
+ * a bufor z odpowiedziami nie jest przepełniony, oraz na możliwość
+ * zapisu, dopóki bufor z odpowiedziami nie jest pusty. Wstrzymane pełne
+ * linie zostają w buforze wejściowym tylko razem z przepełnionym buforem
+ * odpowiedzi, więc wtedy połączenie zawsze czeka na możliwość zapisu.
+ * Funkcja pomocnicza w @ref handle_connection.
+ * @param[in,out] t – wskaźnik na stan wątku,
+ * @param[in,out] c – wskaźnik na połączenie.
+ * @return Wartość @p true, jeśli udało się zmienić zdarzenia,
+ * a @p false w przeciwnym razie.
+ */
+static bool watch(server_thread *t, connection *c)
+{
+    uint32_t events = 0;
+    if (c->closing == false && c->out.len < OUTPUT_LIMIT)
+        events |= EPOLLIN;
+    if (0 < c->out.len)
+        events |= EPOLLOUT;
+    if (events == c->events)
+        return true;
+
+    struct epoll_event event = {.events = events, .data.ptr = c};
+    c->events = events;
+    return epoll_ctl(t->epoll_fd, EPOLL_CTL_MOD, c->fd, &event) == 0;
+}
+
+/** @brief Obsługuje zdarzenie na połączeniu z klientem.
+ * Funkcja pomocnicza w @ref serve.
+ * @param[in,out] t    – wskaźnik na stan wątku,
+ * @param[in,out] c    – wskaźnik na połączenie,
+ * @param[in] events   – zdarzenia zgłoszone przez epoll.
+ */
+static void handle_connection(server_thread *t, connection *c, uint32_t events)
+{
+    bool fine = true;
+
+    if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && c->closing == false
+        && c->out.len < OUTPUT_LIMIT)
+        fine = read_input(c);
+
+    // Po wysłaniu odpowiedzi wykonujemy polecenia wstrzymane przez ich nadmiar,
+    // dopóki są pełne linie, a gniazdo przyjmuje odpowiedzi. Inaczej czekające
+    // polecenia nie doczekałyby się żadnego zdarzenia.
+    while (fine)
+    {
+        fine = write_output(c);
+        if (fine == false || c->input_len == 0 || OUTPUT_LIMIT <= c->out.len)
+            break;
+
+        size_t waiting = c->input_len;
+        process_input(c);
+        if (c->input_len == waiting)
+            break;
+    }
+
+    if (fine == false || (c->closing && c->input_len == 0 && c->out.len == 0)
+        || watch(t, c) == false)
+        connection_close(t, c);
+}
+
+/** @brief Pętla zdarzeń jednego wątku serwera.
+ * @param[in,out] arg – wskaźnik na stan wątku.
+ * @return Wartość NULL.
+ */
+static void *serve(void *arg)
+{
+    server_thread *t = arg;
+    struct epoll_event events[MAX_EVENTS];
+    bool running = true;
+
+    while (running)
+    {
+        int ready = epoll_wait(t->epoll_fd, events, MAX_EVENTS, -1);
+        if (ready == -1 && errno == EINTR)
+            continue;
+        if (ready == -1)
+            break;
+
+        for (int i = 0; i < ready; ++i)
+        {
+            if (events[i].data.ptr == &t->srv->stop_fd)
+                running = false;
+            else if (events[i].data.ptr == &t->srv->listen_fd)
+                accept_clients(t);
+            else
+                handle_connection(t, events[i].data.ptr, events[i].events);
+        }
+    }
+
+    while (t->connections != NULL)
+        connection_close(t, t->connections);
+    return NULL;
+}
+
+/** @brief Tworzy gniazdo przyjmujące połączenia.
+ * Pozostałe po poprzednim serwerze gniazdo pod ścieżką @p path jest usuwane,
+ * ale plik innego rodzaju nie jest ruszany. Zapamiętuje plik utworzonego
+ * gniazda, aby na końcu usunąć tylko jego.
+ * Funkcja pomocnicza w @ref server_session.
+ * @param[in,out] srv – wskaźnik na stan serwera,
+ * @param[in] path    – ścieżka gniazda.
+ * @return Deskryptor gniazda lub @p -1, jeśli nie udało się go utworzyć;
+ * jeśli ścieżka wskazuje plik niebędący gniazdem, @p errno ma wartość
+ * @p EADDRINUSE.
+ */
+static int server_listen(server *srv, const char *path)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (sizeof(addr.sun_path) <= strlen(path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    struct stat st;
+    if (lstat(path, &st) == 0)
+    {
+        if (S_ISSOCK(st.st_mode) == false)
+        {
+            errno = EADDRINUSE;
+            return -1;
+        }
+        unlink(path);
+    }
+    else if (errno != ENOENT)
+    {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        return -1;
+
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    if (lstat(path, &st) == -1 || listen(fd, SERVER_BACKLOG) == -1)
+    {
+        int error = errno;
+        close(fd);
+        unlink(path);
+        errno = error;
+        return -1;
+    }
+    srv->socket_dev = st.st_dev;
+    srv->socket_ino = st.st_ino;
+    return fd;
+}
+
+/** @brief Usuwa plik gniazda, jeśli wciąż jest tym utworzonym przez serwer.
+ * Funkcja pomocnicza w @ref server_session.
+ * @param[in] srv  – wskaźnik na stan serwera,
+ * @param[in] path – ścieżka gniazda.
+ */
+static void server_unlink(const server *srv, const char *path)
+{
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)
+        && st.st_dev == srv->socket_dev && st.st_ino == srv->socket_ino)
+        unlink(path);
+}
+
+/** @brief Uruchamia wątek obsługujący połączenia.
+ * Funkcja pomocnicza w @ref server_session.
+ * @param[out] t   – wskaźnik na stan uruchamianego wątku,
+ * @param[in] srv  – wskaźnik na stan serwera.
+ * @return Wartość @p true, jeśli udało się uruchomić wątek,
+ * a @p false w przeciwnym razie.
+ */
+static bool start_thread(server_thread *t, server *srv)
+{
+    t->srv = srv;
+    t->connections = NULL;
+    t->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (t->epoll_fd == -1)
+        return false;
+
+    // Połączenie przyjmuje tylko jeden z czekających wątków.
+    struct epoll_event listen_event = {.events = EPOLLIN | EPOLLEXCLUSIVE,
+                                       .data.ptr = &srv->listen_fd};
+    struct epoll_event stop_event = {.events = EPOLLIN, .data.ptr = &srv->stop_fd};
+    if (epoll_ctl(t->epoll_fd, EPOLL_CTL_ADD, srv->listen_fd, &listen_event) == -1
+        || epoll_ctl(t->epoll_fd, EPOLL_CTL_ADD, srv->stop_fd, &stop_event) == -1
+        || pthread_create(&t->thread, NULL, serve, t) != 0)
+    {
+        close(t->epoll_fd);
+        return false;
+    }
+    return true;
+}
+
+/** @brief Prowadzi serwer gier na gnieździe lokalnym @p path.
+ * Każde połączenie jest osobną rozgrywką w trybie wsadowym: klient wysyła
+ * linie poleceń, a serwer odsyła odpowiedzi i błędy w tej samej postaci,
+ * w jakiej program wypisuje je na standardowe wyjście i wyjście błędów.
+ * Połączenia są obsługiwane przez @p jobs wątków, z których każdy ma własną
+ * pętlę zdarzeń epoll. Serwer działa do otrzymania sygnału SIGINT lub
+ * SIGTERM, po czym zamyka połączenia i usuwa gniazdo.
+ * @param[in] path – ścieżka gniazda; pozostałe po poprzednim serwerze
+ *                   gniazdo zostanie zastąpione, a inny plik nie,
+ * @param[in] jobs – liczba wątków obsługujących połączenia.
+ * @return Wartość @p true, jeśli serwer zakończył działanie po otrzymaniu
+ * sygnału, a @p false, jeśli nie udało się go uruchomić; wtedy @p errno
+ * opisuje przyczynę.
+ */
+bool server_session(const char *path, uint jobs)
+{
+    server srv;
+    server_thread *threads = malloc(jobs * sizeof(server_thread));
+    if (threads == NULL)
+        return false;
+
+    // Zapis do rozłączonego klienta ma zwracać błąd zamiast kończyć program.
+    signal(SIGPIPE, SIG_IGN);
+
+    srv.listen_fd = server_listen(&srv, path);
+    if (srv.listen_fd == -1)
+    {
+        free(threads);
+        return false;
+    }
+    srv.stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (srv.stop_fd == -1)
+    {
+        close(srv.listen_fd);
+        server_unlink(&srv, path);
+        free(threads);
+        return false;
+    }
+
+    // Sygnały kończące pracę odbiera tylko ten wątek.
+    sigset_t signals, previous;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &previous);
+
+    uint started = 0;
+    while (started < jobs && start_thread(&threads[started], &srv))
+        started++;
+
+    int error = errno;
+    if (0 < started)
+    {
+        int signal_number;
+        sigwait(&signals, &signal_number);
+
+        uint64_t stop = 1;
+        while (write(srv.stop_fd, &stop, sizeof(stop)) == -1 && errno == EINTR)
+            continue;
+        for (uint i = 0; i < started; ++i)
+        {
+            pthread_join(threads[i].thread, NULL);
+            close(threads[i].epoll_fd);
+        }
+    }
+
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    close(srv.stop_fd);
+    close(srv.listen_fd);
+    server_unlink(&srv, path);
+    free(threads);
+    errno = error;
+    return 0 < started;
+}
@@ -0,0 +1,31 @@
+/** @file
+ * Interfejs serwera gry gamma działającego na gnieździe lokalnym.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#ifndef GAMMA_SERVER_H
+#define GAMMA_SERVER_H
+
+#include <stdbool.h>
+#include "gamma.h"
+
+/** @brief Prowadzi serwer gier na gnieździe lokalnym @p path.
+ * Każde połączenie jest osobną rozgrywką w trybie wsadowym: klient wysyła
+ * linie poleceń, a serwer odsyła odpowiedzi i błędy w tej samej postaci,
+ * w jakiej program wypisuje je na standardowe wyjście i wyjście błędów.
+ * Połączenia są obsługiwane przez @p jobs wątków, z których każdy ma własną
+ * pętlę zdarzeń epoll. Serwer działa do otrzymania sygnału SIGINT lub
+ * SIGTERM, po czym zamyka połączenia i usuwa gniazdo.
+ * @param[in] path – ścieżka gniazda; pozostałe po poprzednim serwerze
+ *                   gniazdo zostanie zastąpione, a inny plik nie,
+ * @param[in] jobs – liczba wątków obsługujących połączenia.
+ * @return Wartość @p true, jeśli serwer zakończył działanie po otrzymaniu
+ * sygnału, a @p false, jeśli nie udało się go uruchomić; wtedy @p errno
+ * opisuje przyczynę.
+ */
+bool server_session(const char *path, uint jobs);
+
+#endif //GAMMA_SERVER_H
@@ -0,0 +1,141 @@
+/** @file
+ * Testy serwera gier działającego na gnieździe lokalnym.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+/**
+ * Makro wymagane do poprawnego działania funkcji @ref kill.
+ */
+#define _GNU_SOURCE
+
+// CMake w wersji release wyłącza asercje.
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include "server.h"
+#include <assert.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Ścieżka gniazda testowanego serwera.
+ */
+#define SOCKET_PATH "gamma_server_test.sock"
+
+/**
+ * Czas w milisekundach, po którym brak danych od serwera oznacza zawieszenie.
+ */
+#define STALL_TIMEOUT 10000
+
+/**
+ * Polecenia, na które odpowiedzi wielokrotnie przepełniają bufor połączenia.
+ */
+static const char commands[] = "B 1000 1000 2 2\n"
+                               "p\np\np\np\np\np\np\np\np\np\n";
+
+/**
+ * Długość odpowiedzi na @ref commands: potwierdzenie i dziesięć plansz.
+ */
+static const size_t answer_len = sizeof("OK 1\n") - 1 + 10 * 1000 * 1001;
+
+/** @brief Łączy się z serwerem, czekając aż utworzy on gniazdo.
+ * @return Deskryptor połączenia.
+ */
+static int connect_server(void)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    strcpy(addr.sun_path, SOCKET_PATH);
+    struct timespec pause = {0, 10 * 1000 * 1000};
+
+    for (int attempt = 0; attempt < 500; ++attempt)
+    {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        assert(fd != -1);
+        if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0)
+            return fd;
+        close(fd);
+        nanosleep(&pause, NULL);
+    }
+    assert(false);
+    return -1;
+}
+
+/** @brief Wczytuje odpowiedzi serwera.
+ * Kończy po wczytaniu @p expected bajtów, a jeśli @p until_eof ma wartość
+ * @p true, dopiero po zamknięciu połączenia przez serwer.
+ * @param[in] fd        – deskryptor połączenia,
+ * @param[in] expected  – oczekiwana liczba bajtów,
+ * @param[in] until_eof – czy czekać na zamknięcie połączenia.
+ * @return Liczba wczytanych bajtów.
+ */
+static size_t receive(int fd, size_t expected, bool until_eof)
+{
+    static char chunk[1 << 16];
+    size_t got = 0;
+
+    while (got < expected || until_eof)
+    {
+        struct pollfd p = {.fd = fd, .events = POLLIN};
+        assert(poll(&p, 1, STALL_TIMEOUT) == 1);
+        ssize_t done = read(fd, chunk, sizeof(chunk));
+        assert(done != -1);
+        if (done == 0)
+            break;
+        got += done;
+    }
+    return got;
+}
+
+/** @brief Wysyła wszystkie polecenia naraz i czeka na wszystkie odpowiedzi.
+ * Polecenia czekające w buforze wejściowym serwera muszą zostać wykonane,
+ * choć po opróżnieniu bufora odpowiedzi nie przychodzą już nowe dane.
+ * @param[in] half_close – czy zakończyć wysyłanie przed czytaniem odpowiedzi.
+ */
+static void pipelined_commands(bool half_close)
+{
+    int fd = connect_server();
+    assert(write(fd, commands, sizeof(commands) - 1) == sizeof(commands) - 1);
+    if (half_close)
+        assert(shutdown(fd, SHUT_WR) == 0);
+    assert(receive(fd, answer_len, half_close) == answer_len);
+    close(fd);
+}
+
+/** @brief Uruchamia serwer w procesie potomnym i sprawdza jego działanie.
+ * @return Zero, jeśli wszystkie testy się powiodły.
+ */
+int main(void)
+{
+    unlink(SOCKET_PATH);
+    pid_t server = fork();
+    assert(server != -1);
+    if (server == 0)
+        _exit(server_session(SOCKET_PATH, 2) ? 0 : 1);
+
+    for (int i = 0; i < 5; ++i)
+    {
+        pipelined_commands(true);
+        pipelined_commands(false);
+    }
+
+    int status;
+    assert(kill(server, SIGTERM) == 0);
+    assert(waitpid(server, &status, 0) == server);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(access(SOCKET_PATH, F_OK) == -1);
+
+    printf("Server test conclude with success.\n");
+    return 0;
+}
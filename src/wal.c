@@ -0,0 +1,791 @@
+/** @file
+ * Implementacja dziennika ruchów zapisywanego z wyprzedzeniem.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+/**
+ * Makro wymagane do poprawnego działania funkcji @ref fdatasync
+ * i @ref clock_gettime.
+ */
+#define _GNU_SOURCE
+
+#include "wal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Znacznik początku pliku dziennika.
+ */
+#define WAL_MAGIC "GAMMAWAL"
+
+/**
+ * Długość znacznika początku pliku dziennika.
+ */
+#define WAL_MAGIC_LEN 8
+
+/**
+ * Wersja formatu dziennika.
+ */
+#define WAL_VERSION 1
+
+/**
+ * Długość nagłówka dziennika: znacznik, wersja, zarezerwowane pole,
+ * stan licznika zmian planszy migawki, od której zaczyna się dziennik,
+ * i kolejne zarezerwowane pole.
+ */
+#define WAL_HEADER_LEN 32
+
+/**
+ * Liczba argumentów zapisywanych w każdym rekordzie.
+ */
+#define WAL_ARGS 4
+
+/**
+ * Długość rekordu: rodzaj polecenia, argumenty i suma kontrolna,
+ * wszystkie jako liczby 32-bitowe little-endian.
+ */
+#define WAL_RECORD_LEN (4 * (WAL_ARGS + 2))
+
+/**
+ * Liczba rekordów mieszczących się w buforze dziennika.
+ */
+#define WAL_BUFFER_RECORDS 4096
+
+/**
+ * Przyrostek nazwy pliku tymczasowego, z którego powstaje nowy dziennik.
+ */
+#define WAL_SUFFIX ".tmp"
+
+/**
+ * Przyrostek nazwy pliku, do którego trafiają rekordy w trakcie zapisu
+ * migawki w tle.
+ */
+#define WAL_NEXT_SUFFIX ".next"
+
+/** @brief Odczytuje liczbę 32-bitową zapisaną w porządku little-endian.
+ * @param[in] data – wskaźnik na pierwszy bajt liczby.
+ * @return Odczytana liczba.
+ */
+static inline uint get_u32(const unsigned char *data)
+{
+    return (uint) data[0] | (uint) data[1] << 8
+           | (uint) data[2] << 16 | (uint) data[3] << 24;
+}
+
+/** @brief Odczytuje liczbę 64-bitową zapisaną w porządku little-endian.
+ * @param[in] data – wskaźnik na pierwszy bajt liczby.
+ * @return Odczytana liczba.
+ */
+static inline muint get_u64(const unsigned char *data)
+{
+    return (muint) get_u32(data) | (muint) get_u32(data + 4) << 32;
+}
+
+/** @brief Zapisuje liczbę w porządku little-endian.
+ * @param[out] data – wskaźnik na pierwszy bajt liczby,
+ * @param[in] n     – zapisywana liczba,
+ * @param[in] len   – liczba bajtów liczby.
+ */
+static inline void put_le(unsigned char *data, muint n, uint len)
+{
+    for (uint i = 0; i < len; ++i)
+    {
+        data[i] = n & 0xff;
+        n >>= 8;
+    }
+}
+
+/** @brief Wyznacza sumę kontrolną rekordu.
+ * Odmiana metody FNV-1a działająca na liczbach 32-bitowych zamiast
+ * na bajtach. Pozwala rozpoznać rekord zapisany tylko częściowo przed awarią.
+ * @param[in] words – pola rekordu objęte sumą,
+ * @param[in] count – liczba pól.
+ * @return Suma kontrolna.
+ */
+static uint checksum(const uint *words, int count)
+{
+    uint hash = 2166136261u;
+    for (int i = 0; i < count; ++i)
+        hash = (hash ^ words[i]) * 16777619u;
+    return hash;
+}
+
+/** @brief Zapisuje do pliku cały ciąg bajtów.
+ * @param[in] fd   – deskryptor pliku,
+ * @param[in] data – wskaźnik na zapisywane bajty,
+ * @param[in] len  – liczba zapisywanych bajtów.
+ * @return Wartość @p true, jeśli wszystkie bajty zostały zapisane,
+ * a @p false, jeśli wystąpił błąd zapisu.
+ */
+static bool write_all(int fd, const unsigned char *data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t done = write(fd, data, len);
+        if (done == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += done;
+        len -= done;
+    }
+    return true;
+}
+
+/** @brief Wczytuje z pliku ciąg bajtów.
+ * @param[in] fd    – deskryptor pliku,
+ * @param[out] data – wskaźnik na miejsce na wczytane bajty,
+ * @param[in] len   – liczba bajtów do wczytania.
+ * @return Liczba wczytanych bajtów, mniejsza od @p len tylko na końcu
+ * pliku lub po błędzie odczytu.
+ */
+static size_t read_all(int fd, unsigned char *data, size_t len)
+{
+    size_t done = 0;
+    while (done < len)
+    {
+        ssize_t got = read(fd, data + done, len - done);
+        if (got == -1 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            break;
+        done += got;
+    }
+    return done;
+}
+
+/** @brief Utrwala na dysku zawartość katalogu zawierającego dany plik.
+ * Dzięki temu zmiana nazwy pliku przetrwa awarię systemu.
+ * @param[in] path – ścieżka do pliku.
+ * @return Wartość @p true, jeśli katalog został zsynchronizowany,
+ * a @p false w przeciwnym razie.
+ */
+static bool sync_directory(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    char *dir = slash == NULL ? strdup(".") : strndup(path, slash - path + 1);
+    if (dir == NULL)
+        return false;
+
+    int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    free(dir);
+    if (fd < 0)
+        return false;
+    bool result = fsync(fd) == 0;
+    close(fd);
+    return result;
+}
+
+/** @brief Tworzy ścieżkę powstałą z dopisania przyrostka do innej ścieżki.
+ * @param[in] path   – ścieżka,
+ * @param[in] suffix – przyrostek.
+ * @return Wskaźnik na zaalokowany napis, który trzeba zwolnić, lub NULL,
+ * jeśli zabrakło pamięci.
+ */
+static char *with_suffix(const char *path, const char *suffix)
+{
+    size_t path_len = strlen(path), suffix_len = strlen(suffix);
+    char *result = malloc(path_len + suffix_len + 1);
+    if (result != NULL)
+    {
+        memcpy(result, path, path_len);
+        memcpy(result + path_len, suffix, suffix_len + 1);
+    }
+    return result;
+}
+
+/** @brief Zastępuje plik dziennika pustym dziennikiem.
+ * Nowy dziennik jest zapisywany do pliku tymczasowego, który po
+ * zsynchronizowaniu z dyskiem zastępuje plik @p path.
+ * @param[in] path – ścieżka do pliku dziennika,
+ * @param[in] base – stan licznika zmian planszy, od którego zaczyna się
+ *                   dziennik.
+ * @return Deskryptor nowego pliku dziennika ustawiony na jego końcu
+ * lub -1, jeśli wystąpił błąd.
+ */
+static int reset_log(const char *path, muint base)
+{
+    char *temporary = with_suffix(path, WAL_SUFFIX);
+    if (temporary == NULL)
+        return -1;
+
+    unsigned char header[WAL_HEADER_LEN] = {0};
+    memcpy(header, WAL_MAGIC, WAL_MAGIC_LEN);
+    put_le(header + 8, WAL_VERSION, 4);
+    put_le(header + 16, base, 8);
+
+    int fd = open(temporary, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0 && (write_all(fd, header, WAL_HEADER_LEN) == false
+                    || fdatasync(fd) != 0 || rename(temporary, path) != 0
+                    || sync_directory(path) == false))
+    {
+        close(fd);
+        unlink(temporary);
+        fd = -1;
+    }
+    free(temporary);
+    return fd;
+}
+
+/** @brief Wykonuje polecenie zapisane w rekordzie dziennika.
+ * @param[in,out] game – wskaźnik na wskaźnik na strukturę przechowującą
+ *                       stan gry, NULL jeśli gra nie została utworzona,
+ * @param[in] record   – wskaźnik na początek rekordu.
+ * @return Wartość @p true, jeśli polecenie się powiodło, a @p false,
+ * jeśli dziennik nie pasuje do stanu gry.
+ */
+static bool replay(gamma_t **game, const unsigned char *record)
+{
+    uint args[WAL_ARGS];
+    for (int i = 0; i < WAL_ARGS; ++i)
+        args[i] = get_u32(record + 4 * (i + 1));
+
+    switch (get_u32(record))
+    {
+        case 'B':
+            if (*game != NULL)
+                return false;
+            *game = gamma_new(args[0], args[1], args[2], args[3]);
+            return *game != NULL;
+
+        case 'm':
+            return *game != NULL && gamma_move(*game, args[0], args[1], args[2]);
+
+        case 'g':
+            return *game != NULL && gamma_golden_move(*game, args[0], args[1], args[2]);
+
+        default:
+            return false;
+    }
+}
+
+/** @brief Wykonuje wszystkie kompletne rekordy dziennika.
+ * Rekordy są wczytywane do bufora dziennika dużymi porcjami. Wykonywanie
+ * kończy się na pierwszym niepełnym rekordzie lub rekordzie z niepoprawną
+ * sumą kontrolną, czyli na rekordzie przerwanym przez awarię.
+ * @param[in,out] log  – wskaźnik na dziennik,
+ * @param[in] fd       – deskryptor pliku ustawionego tuż za nagłówkiem,
+ * @param[in,out] game – wskaźnik na wskaźnik na strukturę przechowującą
+ *                       stan gry,
+ * @param[out] end     – długość poprawnej części pliku.
+ * @return Wartość @p true, jeśli wszystkie kompletne rekordy zostały
+ * wykonane, a @p false, jeśli któreś polecenie się nie powiodło.
+ */
+static bool replay_log(wal *log, int fd, gamma_t **game, off_t *end)
+{
+    size_t chunk = WAL_BUFFER_RECORDS * WAL_RECORD_LEN;
+    *end = WAL_HEADER_LEN;
+    size_t got;
+    do
+    {
+        got = read_all(fd, log->buffer, chunk);
+        for (size_t pos = 0; pos + WAL_RECORD_LEN <= got; pos += WAL_RECORD_LEN)
+        {
+            const unsigned char *record = log->buffer + pos;
+            uint words[WAL_ARGS + 1];
+            for (int i = 0; i <= WAL_ARGS; ++i)
+                words[i] = get_u32(record + 4 * i);
+            if (checksum(words, WAL_ARGS + 1) != get_u32(record + 4 * (WAL_ARGS + 1)))
+                return true;
+            if (replay(game, record) == false)
+                return false;
+            *end += WAL_RECORD_LEN;
+        }
+    } while (got == chunk);
+    return true;
+}
+
+/** @brief Kopiuje fragment jednego pliku na koniec drugiego.
+ * Bajty są przenoszone przez bufor dziennika, który musi być pusty.
+ * Funkcja pomocnicza w @ref merge_logs.
+ * @param[in,out] log – wskaźnik na dziennik,
+ * @param[in] from    – deskryptor pliku źródłowego,
+ * @param[in] start   – początek kopiowanego fragmentu,
+ * @param[in] end     – koniec kopiowanego fragmentu,
+ * @param[in] to      – deskryptor pliku docelowego.
+ * @return Wartość @p true, jeśli fragment został skopiowany,
+ * a @p false, jeśli wystąpił błąd odczytu lub zapisu.
+ */
+static bool copy_range(wal *log, int from, off_t start, off_t end, int to)
+{
+    size_t chunk = WAL_BUFFER_RECORDS * WAL_RECORD_LEN;
+    while (start < end)
+    {
+        size_t want = end - start < (off_t) chunk ? (size_t) (end - start) : chunk;
+        ssize_t got = pread(from, log->buffer, want, start);
+        if (got == -1 && errno == EINTR)
+            continue;
+        if (got <= 0 || write_all(to, log->buffer, got) == false)
+            return false;
+        start += got;
+    }
+    return true;
+}
+
+/** @brief Łączy dziennik z rekordami dopisanymi w trakcie zapisu migawki.
+ * Połączony dziennik powstaje w pliku tymczasowym, który po
+ * zsynchronizowaniu z dyskiem zastępuje dziennik. Dopiero potem usuwany
+ * jest plik z dopisanymi rekordami, dzięki czemu po awarii w dowolnej
+ * chwili każdy rekord znajduje się w którymś z plików.
+ * Funkcja pomocnicza w @ref absorb_next i @ref wal_checkpoint_poll.
+ * @param[in,out] log – wskaźnik na dziennik z pustym buforem,
+ * @param[in] first   – deskryptor dziennika,
+ * @param[in] first_end  – długość poprawnej części dziennika,
+ * @param[in] second     – deskryptor pliku z dopisanymi rekordami,
+ * @param[in] second_end – długość poprawnej części tego pliku.
+ * @return Deskryptor połączonego dziennika ustawiony na jego końcu
+ * lub -1, jeśli wystąpił błąd.
+ */
+static int merge_logs(wal *log, int first, off_t first_end,
+                      int second, off_t second_end)
+{
+    char *temporary = with_suffix(log->path, WAL_SUFFIX);
+    if (temporary == NULL)
+        return -1;
+
+    int fd = open(temporary, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0 && (copy_range(log, first, 0, first_end, fd) == false
+                    || copy_range(log, second, WAL_HEADER_LEN, second_end, fd) == false
+                    || fdatasync(fd) != 0 || rename(temporary, log->path) != 0
+                    || sync_directory(log->path) == false))
+    {
+        close(fd);
+        unlink(temporary);
+        fd = -1;
+    }
+    free(temporary);
+
+    if (fd >= 0)
+        unlink(log->next_path);
+    return fd;
+}
+
+/** @brief Przejmuje rekordy pozostawione przez przerwany zapis migawki w tle.
+ * Plik z rekordami dopisanymi w trakcie zapisu migawki zaczyna się od stanu,
+ * na którym kończy się dziennik. Jego rekordy są wykonywane i przenoszone
+ * do dziennika. Plik zaczynający się od wcześniejszego stanu pozostał po
+ * awarii tuż po przeniesieniu rekordów i jest tylko usuwany.
+ * Funkcja pomocnicza w @ref wal_open.
+ * @param[in,out] log  – wskaźnik na dziennik ustawiony na końcu pliku,
+ * @param[in,out] game – wskaźnik na wskaźnik na strukturę przechowującą
+ *                       stan gry.
+ * @return Wartość @p true, jeśli takiego pliku nie było lub rekordy zostały
+ * przeniesione, a @p false, jeśli plik nie pasuje do dziennika lub wystąpił
+ * błąd wejścia-wyjścia.
+ */
+static bool absorb_next(wal *log, gamma_t **game)
+{
+    int fd = open(log->next_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return errno == ENOENT;
+
+    unsigned char header[WAL_HEADER_LEN];
+    muint count = gamma_change_count(*game);
+    bool fine = read_all(fd, header, WAL_HEADER_LEN) == WAL_HEADER_LEN
+        && memcmp(header, WAL_MAGIC, WAL_MAGIC_LEN) == 0
+        && get_u32(header + 8) == WAL_VERSION;
+    muint base = fine ? get_u64(header + 16) : 0;
+
+    int merged = -1;
+    off_t end = 0;
+    if (fine && base < count)
+    {
+        close(fd);
+        return unlink(log->next_path) == 0 && sync_directory(log->path);
+    }
+    else if (fine && base == count && replay_log(log, fd, game, &end))
+    {
+        merged = merge_logs(log, log->fd, lseek(log->fd, 0, SEEK_CUR), fd, end);
+    }
+    close(fd);
+
+    if (merged < 0)
+        return false;
+    close(log->fd);
+    log->fd = merged;
+    return true;
+}
+
+/** @brief Otwiera dziennik i odtwarza na jego podstawie stan gry.
+ * Jeśli plik nie istnieje, tworzy pusty dziennik dla gry @p *game. W przeciwnym
+ * razie wykonuje zapisane polecenia na grze odtworzonej z migawki (lub na
+ * nowej grze, gdy dziennik zaczyna się od jej utworzenia) i obcina
+ * niedokończony rekord z końca pliku. Dziennik starszy niż migawka jest
+ * zastępowany pustym. Rekordy pozostawione przez przerwany zapis migawki
+ * w tle są wykonywane i przenoszone do dziennika.
+ * @param[out] log      – wskaźnik na inicjowaną strukturę,
+ * @param[in] path      – ścieżka do pliku dziennika,
+ * @param[in,out] game  – wskaźnik na wskaźnik na grę odtworzoną z migawki
+ *                        lub na NULL, jeśli migawki nie ma.
+ * @return Wartość @p true, jeśli dziennik został otwarty, a @p false, jeśli
+ * wystąpił błąd wejścia-wyjścia, zabrakło pamięci lub dziennik nie pasuje
+ * do migawki.
+ */
+bool wal_open(wal *log, const char *path, gamma_t **game)
+{
+    log->path = path;
+    log->len = 0;
+    log->dirty = false;
+    log->failed = false;
+    log->since_checkpoint = 0;
+    log->base_fd = -1;
+    log->child = 0;
+    log->report = NULL;
+    log->next_path = with_suffix(path, WAL_NEXT_SUFFIX);
+    log->buffer = malloc(WAL_BUFFER_RECORDS * WAL_RECORD_LEN);
+    if (log->buffer == NULL || log->next_path == NULL)
+    {
+        free(log->buffer);
+        free(log->next_path);
+        return false;
+    }
+
+    muint snapshot = gamma_change_count(*game);
+    log->fd = open(path, O_RDWR | O_CLOEXEC);
+    if (log->fd < 0 && errno == ENOENT)
+        log->fd = reset_log(path, snapshot);
+    else if (log->fd >= 0)
+    {
+        unsigned char header[WAL_HEADER_LEN];
+        muint base = 0;
+        off_t end = 0;
+        bool fine = read_all(log->fd, header, WAL_HEADER_LEN) == WAL_HEADER_LEN
+            && memcmp(header, WAL_MAGIC, WAL_MAGIC_LEN) == 0
+            && get_u32(header + 8) == WAL_VERSION;
+        if (fine)
+            base = get_u64(header + 16);
+
+        // Dziennik starszy niż migawka pozostał po przerwanym zapisie
+        // migawki i wszystkie jego ruchy są już w migawce.
+        if (fine && base < snapshot)
+        {
+            close(log->fd);
+            log->fd = reset_log(path, snapshot);
+        }
+        else if (fine == false || base != snapshot
+                 || replay_log(log, log->fd, game, &end) == false
+                 || ftruncate(log->fd, end) != 0
+                 || lseek(log->fd, end, SEEK_SET) != end)
+        {
+            close(log->fd);
+            log->fd = -1;
+            errno = EINVAL;
+        }
+    }
+
+    if (log->fd >= 0 && absorb_next(log, game) == false)
+    {
+        close(log->fd);
+        log->fd = -1;
+        errno = EINVAL;
+    }
+
+    if (log->fd < 0)
+    {
+        free(log->buffer);
+        free(log->next_path);
+        return false;
+    }
+    log->len = 0;
+    return true;
+}
+
+/** @brief Dopisuje do dziennika udane polecenie.
+ * Pełny bufor jest zapisywany do pliku bez synchronizacji z dyskiem.
+ * @param[in,out] log – wskaźnik na dziennik,
+ * @param[in] type    – rodzaj polecenia: @p B, @p m lub @p g,
+ * @param[in] args    – argumenty polecenia,
+ * @param[in] count   – liczba argumentów, co najwyżej cztery.
+ */
+void wal_append(wal *log, char type, const uint *args, int count)
+{
+    if (log->len == WAL_BUFFER_RECORDS * WAL_RECORD_LEN)
+    {
+        if (log->failed == false)
+            log->failed = write_all(log->fd, log->buffer, log->len) == false;
+        log->dirty = true;
+        log->len = 0;
+    }
+
+    uint words[WAL_ARGS + 1] = {(uint) type};
+    for (int i = 0; i < count && i < WAL_ARGS; ++i)
+        words[i + 1] = args[i];
+
+    unsigned char *record = log->buffer + log->len;
+    for (int i = 0; i <= WAL_ARGS; ++i)
+        put_le(record + 4 * i, words[i], 4);
+    put_le(record + 4 * (WAL_ARGS + 1), checksum(words, WAL_ARGS + 1), 4);
+    log->len += WAL_RECORD_LEN;
+    log->since_checkpoint++;
+}
+
+/** @brief Utrwala na dysku wszystkie dopisane rekordy.
+ * Funkcja pomocnicza w @ref wal_commit i funkcjach zapisujących migawki.
+ * @param[in,out] log – wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli rekordy zostały utrwalone,
+ * a @p false, jeśli zapis dziennika się nie powiódł.
+ */
+static bool commit_records(wal *log)
+{
+    if (log->failed)
+        return false;
+
+    if (log->len > 0)
+    {
+        log->failed = write_all(log->fd, log->buffer, log->len) == false;
+        log->dirty = true;
+        log->len = 0;
+    }
+    if (log->dirty && log->failed == false)
+    {
+        log->failed = fdatasync(log->fd) != 0;
+        log->dirty = false;
+    }
+    return log->failed == false;
+}
+
+/** @brief Utrwala na dysku wszystkie dopisane rekordy.
+ * Przy okazji sprawdza, czy zapis migawki w tle się zakończył.
+ * @param[in,out] log – wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli rekordy zostały utrwalone,
+ * a @p false, jeśli zapis dziennika się nie powiódł.
+ */
+bool wal_commit(wal *log)
+{
+    bool result = commit_records(log);
+    if (log->child != 0)
+        wal_checkpoint_poll(log, false);
+    return result && log->failed == false;
+}
+
+/** @brief Podaje czas zegara monotonicznego.
+ * @return Czas w mikrosekundach.
+ */
+static muint now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (muint) t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+/** @brief Wypisuje raport o migawce zapisywanej w tle.
+ * Raport ma postać "checkpoint licznik: opis [czas us]".
+ * @param[in,out] log – wskaźnik na dziennik,
+ * @param[in] what    – opis zdarzenia,
+ * @param[in] us      – czas w mikrosekundach,
+ * @param[in] timed   – czy wypisać czas.
+ */
+static void report_checkpoint(wal *log, const char *what, muint us, bool timed)
+{
+    if (log->report == NULL)
+        return;
+    writer_put_string(log->report, "checkpoint ");
+    writer_put_number(log->report, log->checkpoint_base);
+    writer_put_string(log->report, ": ");
+    writer_put_string(log->report, what);
+    if (timed)
+    {
+        writer_put_number(log->report, us);
+        writer_put_string(log->report, " us");
+    }
+    writer_put_char(log->report, '\n');
+    writer_end(log->report);
+}
+
+/** @brief Rozpoczyna zapis migawki gry w procesie potomnym.
+ * Rekordy dopisane po rozpoczęciu zapisu trafiają do nowego pliku, który
+ * zaczyna się od stanu zapisywanej migawki. Proces potomny dzieli z bieżącym
+ * strony pamięci aż do ich zmiany, więc zapisuje stan gry z chwili
+ * rozwidlenia, a bieżący proces wstrzymuje się tylko na utworzenie pliku
+ * i rozwidlenie procesu.
+ * @param[in,out] log    – wskaźnik na dziennik,
+ * @param[in] game       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] snapshot   – ścieżka do pliku migawki,
+ * @param[in,out] report – wskaźnik na strukturę zapisującą raporty.
+ * @return Wartość @p true, jeśli zapis migawki się rozpoczął lub już trwa,
+ * a @p false, jeśli nie udało się go rozpocząć.
+ */
+bool wal_checkpoint_start(wal *log, gamma_t *game, const char *snapshot,
+                          writer *report)
+{
+    if (log->child != 0)
+        return true;
+
+    muint started = now_us();
+    pid_t parent = getpid();
+    log->report = report;
+    log->checkpoint_base = gamma_change_count(game);
+    int fd = -1;
+    pid_t child = -1;
+    if (commit_records(log)
+        && (fd = reset_log(log->next_path, log->checkpoint_base)) >= 0)
+        child = fork();
+
+    // Proces potomny zapisuje migawkę i kończy się bez opróżniania
+    // buforów odziedziczonych po procesie macierzystym. Ginie razem z nim,
+    // aby nie podmienić migawki już po odtworzeniu gry z dziennika.
+    if (child == 0)
+    {
+        if (prctl(PR_SET_PDEATHSIG, SIGKILL) != 0 || getppid() != parent)
+            _exit(EXIT_FAILURE);
+        bool saved = gamma_save(game, snapshot) && sync_directory(snapshot);
+        _exit(saved ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    if (child < 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+            unlink(log->next_path);
+        }
+        report_checkpoint(log, "not started", 0, false);
+        return false;
+    }
+
+    log->base_fd = log->fd;
+    log->fd = fd;
+    log->child = child;
+    log->checkpoint_started = started;
+    log->since_checkpoint = 0;
+    report_checkpoint(log, "started, pause ", now_us() - started, true);
+    return true;
+}
+
+/** @brief Sprawdza, czy zapis migawki w tle się zakończył.
+ * Po udanym zapisie plik z rekordami dopisanymi w trakcie zapisu zastępuje
+ * dziennik. Po nieudanym rekordy te są przenoszone do poprzedniego
+ * dziennika, który nadal pasuje do starej migawki. Jeśli dziennika nie
+ * uda się uporządkować, kolejne ruchy nie są potwierdzane.
+ * @param[in,out] log – wskaźnik na dziennik,
+ * @param[in] wait    – czy czekać na zakończenie zapisu.
+ * @return Wartość @p true, jeśli żadna migawka nie jest już zapisywana,
+ * a @p false, jeśli zapis trwa lub dziennika nie udało się uporządkować.
+ */
+bool wal_checkpoint_poll(wal *log, bool wait)
+{
+    if (log->child == 0)
+        return true;
+
+    int status = 0;
+    pid_t done;
+    do
+    {
+        done = waitpid(log->child, &status, wait ? 0 : WNOHANG);
+    } while (done == -1 && errno == EINTR);
+    if (done == 0)
+        return false;
+
+    bool saved = done == log->child && WIFEXITED(status)
+                 && WEXITSTATUS(status) == EXIT_SUCCESS;
+    log->child = 0;
+
+    bool fine;
+    if (saved)
+    {
+        fine = rename(log->next_path, log->path) == 0
+               && sync_directory(log->path);
+        close(log->base_fd);
+    }
+    else
+    {
+        int merged = -1;
+        if (commit_records(log))
+            merged = merge_logs(log, log->base_fd, lseek(log->base_fd, 0, SEEK_CUR),
+                                log->fd, lseek(log->fd, 0, SEEK_CUR));
+        fine = merged >= 0;
+        close(log->base_fd);
+        if (fine)
+        {
+            close(log->fd);
+            log->fd = merged;
+        }
+    }
+    log->base_fd = -1;
+    log->failed = log->failed || fine == false;
+
+    if (saved)
+        report_checkpoint(log, "saved in ", now_us() - log->checkpoint_started, true);
+    else
+        report_checkpoint(log, "failed", 0, false);
+    return fine;
+}
+
+/** @brief Utrwala dziennik przed zapisem odpowiedzi.
+ * Funkcja pomocnicza w @ref wal_attach.
+ * @param[in,out] arg – wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli dziennik został utrwalony,
+ * a @p false w przeciwnym razie.
+ */
+static bool commit_hook(void *arg)
+{
+    return wal_commit(arg);
+}
+
+/** @brief Utrwala dziennik przed każdym zapisem odpowiedzi.
+ * Dzięki temu odpowiedź na ruch trafia do pliku dopiero wtedy, gdy ruch
+ * jest już bezpiecznie zapisany w dzienniku, a synchronizacja z dyskiem
+ * obejmuje wszystkie ruchy z jednego opróżnienia bufora odpowiedzi.
+ * @param[in,out] log – wskaźnik na dziennik,
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi.
+ */
+void wal_attach(wal *log, writer *out)
+{
+    writer_before_write(out, commit_hook, log);
+}
+
+/** @brief Zapisuje migawkę gry i rozpoczyna pusty dziennik.
+ * Nowy dziennik zaczyna się od stanu licznika zmian planszy zapisanej
+ * migawki. Jeśli awaria nastąpi po zapisaniu migawki, a przed zastąpieniem
+ * dziennika, @ref wal_open rozpozna stary dziennik po tym liczniku.
+ * @param[in,out] log  – wskaźnik na dziennik,
+ * @param[in] game     – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] snapshot – ścieżka do pliku migawki.
+ * @return Wartość @p true, jeśli migawka i nowy dziennik zostały zapisane,
+ * a @p false w przeciwnym razie.
+ */
+bool wal_checkpoint(wal *log, gamma_t *game, const char *snapshot)
+{
+    if (wal_checkpoint_poll(log, true) == false || commit_records(log) == false
+        || gamma_save(game, snapshot) == false
+        || sync_directory(snapshot) == false)
+        return false;
+
+    int fd = reset_log(log->path, gamma_change_count(game));
+    if (fd < 0)
+        return false;
+    close(log->fd);
+    log->fd = fd;
+    log->since_checkpoint = 0;
+    return true;
+}
+
+/** @brief Utrwala pozostałe rekordy i zamyka dziennik.
+ * @param[in,out] log – wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli wszystkie rekordy zostały utrwalone,
+ * a @p false w przeciwnym razie.
+ */
+bool wal_close(wal *log)
+{
+    bool result = wal_checkpoint_poll(log, true);
+    result = commit_records(log) && result;
+    result = close(log->fd) == 0 && result;
+    free(log->buffer);
+    free(log->next_path);
+    log->buffer = NULL;
+    log->next_path = NULL;
+    return result;
+}
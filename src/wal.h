@@ -0,0 +1,128 @@
+/** @file
+ * Interfejs dziennika ruchów zapisywanego z wyprzedzeniem.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#ifndef GAMMA_WAL_H
+#define GAMMA_WAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "gamma.h"
+#include "writer.h"
+
+/** @brief Dziennik udanych poleceń zmieniających stan gry.
+ * Rekordy są gromadzone w buforze i utrwalane grupami: jedno wywołanie
+ * @ref fdatasync obejmuje wszystkie ruchy, których odpowiedzi czekają
+ * na wypisanie. Na czas zapisu migawki w tle nowe rekordy trafiają do
+ * osobnego pliku, który po zapisaniu migawki zastępuje dziennik.
+ */
+typedef struct wal
+{
+    int fd; ///< Deskryptor pliku, do którego trafiają nowe rekordy.
+    const char *path; ///< Ścieżka do pliku dziennika.
+    char *next_path; /**< Ścieżka pliku z rekordami dopisanymi w trakcie
+        zapisu migawki w tle. */
+    unsigned char *buffer; ///< Rekordy oczekujące na zapisanie do pliku.
+    size_t len; ///< Liczba bajtów w buforze.
+    bool dirty; ///< Czy część rekordów zapisano bez synchronizacji z dyskiem.
+    bool failed; ///< Czy zapis dziennika się nie powiódł.
+    muint since_checkpoint; ///< Liczba rekordów od rozpoczęcia ostatniej migawki.
+    int base_fd; /**< Deskryptor dziennika sprzed migawki zapisywanej w tle
+        lub -1, jeśli żadna migawka nie jest zapisywana. */
+    pid_t child; ///< Proces zapisujący migawkę w tle.
+    muint checkpoint_base; ///< Licznik zmian planszy zapisywanej migawki.
+    muint checkpoint_started; ///< Czas rozpoczęcia zapisu migawki w mikrosekundach.
+    writer *report; ///< Wskaźnik na strukturę zapisującą raporty o migawkach.
+} wal;
+
+/** @brief Otwiera dziennik i odtwarza na jego podstawie stan gry.
+ * Jeśli plik nie istnieje, tworzy pusty dziennik dla gry @p *game. W przeciwnym
+ * razie wykonuje zapisane polecenia na grze odtworzonej z migawki (lub na
+ * nowej grze, gdy dziennik zaczyna się od jej utworzenia) i obcina
+ * niedokończony rekord z końca pliku. Dziennik starszy niż migawka jest
+ * zastępowany pustym. Rekordy pozostawione przez przerwany zapis migawki
+ * w tle są wykonywane i przenoszone do dziennika.
+ * @param[out] log      – wskaźnik na inicjowaną strukturę,
+ * @param[in] path      – ścieżka do pliku dziennika,
+ * @param[in,out] game  – wskaźnik na wskaźnik na grę odtworzoną z migawki
+ *                        lub na NULL, jeśli migawki nie ma.
+ * @return Wartość @p true, jeśli dziennik został otwarty, a @p false, jeśli
+ * wystąpił błąd wejścia-wyjścia, zabrakło pamięci lub dziennik nie pasuje
+ * do migawki.
+ */
+bool wal_open(wal *log, const char *path, gamma_t **game);
+
+/** @brief Dopisuje do dziennika udane polecenie.
+ * @param[in,out] log – wskaźnik na dziennik,
+ * @param[in] type    – rodzaj polecenia: @p B, @p m lub @p g,
+ * @param[in] args    – argumenty polecenia,
+ * @param[in] count   – liczba argumentów, co najwyżej cztery.
+ */
+void wal_append(wal *log, char type, const uint *args, int count);
+
+/** @brief Utrwala na dysku wszystkie dopisane rekordy.
+ * @param[in,out] log – wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli rekordy zostały utrwalone,
+ * a @p false, jeśli zapis dziennika się nie powiódł.
+ */
+bool wal_commit(wal *log);
+
+/** @brief Utrwala dziennik przed każdym zapisem odpowiedzi.
+ * Dzięki temu odpowiedź na ruch trafia do pliku dopiero wtedy, gdy ruch
+ * jest już bezpiecznie zapisany w dzienniku, a synchronizacja z dyskiem
+ * obejmuje wszystkie ruchy z jednego opróżnienia bufora odpowiedzi.
+ * @param[in,out] log – wskaźnik na dziennik,
+ * @param[in,out] out – wskaźnik na strukturę zapisującą odpowiedzi.
+ */
+void wal_attach(wal *log, writer *out);
+
+/** @brief Rozpoczyna zapis migawki gry w procesie potomnym.
+ * Proces potomny zapisuje kopię stanu gry z chwili wywołania, a bieżący
+ * proces od razu wraca do wykonywania poleceń. Po zapisaniu migawki
+ * dziennik zaczyna się od jej stanu. Jeśli migawka jest już zapisywana,
+ * funkcja nic nie robi. Początek, czas trwania i wynik zapisu są
+ * wypisywane przez @p report.
+ * @param[in,out] log    – wskaźnik na dziennik,
+ * @param[in] game       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] snapshot   – ścieżka do pliku migawki,
+ * @param[in,out] report – wskaźnik na strukturę zapisującą raporty.
+ * @return Wartość @p true, jeśli zapis migawki się rozpoczął lub już trwa,
+ * a @p false, jeśli nie udało się go rozpocząć.
+ */
+bool wal_checkpoint_start(wal *log, gamma_t *game, const char *snapshot,
+                          writer *report);
+
+/** @brief Sprawdza, czy zapis migawki w tle się zakończył.
+ * Po udanym zapisie dziennik zaczyna się od stanu migawki. Po nieudanym
+ * rekordy dopisane w trakcie zapisu wracają do poprzedniego dziennika.
+ * @param[in,out] log – wskaźnik na dziennik,
+ * @param[in] wait    – czy czekać na zakończenie zapisu.
+ * @return Wartość @p true, jeśli żadna migawka nie jest już zapisywana,
+ * a @p false, jeśli zapis trwa lub dziennika nie udało się uporządkować.
+ */
+bool wal_checkpoint_poll(wal *log, bool wait);
+
+/** @brief Zapisuje migawkę gry i rozpoczyna pusty dziennik.
+ * Najpierw czeka na zakończenie zapisu migawki w tle.
+ * @param[in,out] log  – wskaźnik na dziennik,
+ * @param[in] game     – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] snapshot – ścieżka do pliku migawki.
+ * @return Wartość @p true, jeśli migawka i nowy dziennik zostały zapisane,
+ * a @p false w przeciwnym razie.
+ */
+bool wal_checkpoint(wal *log, gamma_t *game, const char *snapshot);
+
+/** @brief Utrwala pozostałe rekordy i zamyka dziennik.
+ * Najpierw czeka na zakończenie zapisu migawki w tle.
+ * @param[in,out] log – wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli wszystkie rekordy zostały utrwalone,
+ * a @p false w przeciwnym razie.
+ */
+bool wal_close(wal *log);
+
+#endif //GAMMA_WAL_H
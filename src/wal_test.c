@@ -0,0 +1,142 @@
+/** @file
+ * Testy odtwarzania gry z dziennika ruchów po awarii.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 22 maja 2020
+ */
+
+// CMake w wersji release wyłącza asercje.
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include "wal.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Ścieżka testowanego dziennika.
+ */
+#define WAL_PATH "gamma_wal_test.wal"
+
+/**
+ * Ścieżka pliku z rekordami dopisanymi w trakcie zapisu migawki.
+ */
+#define WAL_NEXT_PATH WAL_PATH ".next"
+
+/**
+ * Ścieżka migawki w nieistniejącym katalogu, więc jej zapis się nie powiedzie.
+ */
+#define SNAPSHOT_PATH "gamma_wal_test.missing/snapshot"
+
+/**
+ * Wymiary gry, liczba graczy i dozwolona liczba obszarów.
+ */
+static const uint dimensions[] = {5, 2, 2, 1};
+
+/**
+ * Ruchy wykonane przed rozpoczęciem zapisu migawki. Złoty ruch rozdzieliłby
+ * pola gracza 2 na dwa obszary, więc jest odrzucany i nie trafia do dziennika.
+ */
+static const move before[] = {{1, 0, 0}, {2, 1, 0}, {2, 2, 0}, {2, 3, 0}};
+
+/**
+ * Ruchy wykonane w trakcie zapisu migawki, których rekordy nie zostają
+ * utrwalone przed awarią.
+ */
+static const move after[] = {{2, 4, 0}, {1, 0, 1}, {2, 4, 1}};
+
+/** @brief Wykonuje ruchy i zapisuje w dzienniku te, które się powiodły.
+ * @param[in,out] log  – wskaźnik na dziennik lub NULL,
+ * @param[in,out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves    – tablica ruchów,
+ * @param[in] n        – liczba ruchów.
+ */
+static void play(wal *log, gamma_t *game, const move *moves, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint args[] = {moves[i].player, moves[i].x, moves[i].y};
+        if (gamma_move(game, args[0], args[1], args[2]) && log != NULL)
+            wal_append(log, 'm', args, 3);
+    }
+}
+
+/** @brief Rozgrywa grę z dziennikiem i kończy proces bez jego zamknięcia.
+ * Proces kończy się przed sprawdzeniem wyniku zapisu migawki w tle,
+ * więc plik na rekordy dopisywane w trakcie zapisu zostaje na dysku.
+ */
+static void crash_during_checkpoint(void)
+{
+    gamma_t *game = NULL;
+    wal log;
+    assert(wal_open(&log, WAL_PATH, &game) && game == NULL);
+    game = gamma_new(dimensions[0], dimensions[1], dimensions[2], dimensions[3]);
+    wal_append(&log, 'B', dimensions, 4);
+
+    play(&log, game, before, sizeof(before) / sizeof(before[0]));
+    muint count = gamma_change_count(game);
+    assert(!gamma_golden_move(game, 1, 2, 0));
+    assert(gamma_change_count(game) == count);
+
+    assert(wal_checkpoint_start(&log, game, SNAPSHOT_PATH, NULL));
+    play(&log, game, after, sizeof(after) / sizeof(after[0]));
+    _exit(0);
+}
+
+/** @brief Odtwarza grę z dziennika i porównuje ją z oczekiwaną.
+ * @param[in] expected – wskaźnik na grę rozegraną bez dziennika.
+ */
+static void recover(gamma_t *expected)
+{
+    gamma_t *game = NULL;
+    wal log;
+    assert(wal_open(&log, WAL_PATH, &game) && game != NULL);
+    assert(access(WAL_NEXT_PATH, F_OK) == -1);
+    char *board = gamma_board(game);
+    char *reference = gamma_board(expected);
+    assert(strcmp(board, reference) == 0);
+    assert(gamma_change_count(game) == gamma_change_count(expected));
+    free(board);
+    free(reference);
+    assert(wal_close(&log));
+    gamma_delete(game);
+}
+
+/** @brief Przeprowadza awarię w trakcie zapisu migawki i odtwarza grę.
+ * @return Zero, jeśli wszystkie testy się powiodły.
+ */
+int main(void)
+{
+    unlink(WAL_PATH);
+    unlink(WAL_NEXT_PATH);
+
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0)
+        crash_during_checkpoint();
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(access(WAL_NEXT_PATH, F_OK) == 0);
+
+    gamma_t *expected = gamma_new(dimensions[0], dimensions[1],
+                                  dimensions[2], dimensions[3]);
+    play(NULL, expected, before, sizeof(before) / sizeof(before[0]));
+    assert(!gamma_golden_move(expected, 1, 2, 0));
+
+    // Ponowne otwarcie nie może wykonać rekordów drugi raz.
+    recover(expected);
+    recover(expected);
+
+    gamma_delete(expected);
+    assert(remove(WAL_PATH) == 0);
+
+    printf("Log test conclude with success.\n");
+    return 0;
+}
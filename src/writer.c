@@ -0,0 +1,305 @@
+/** @file
+ * Implementacja modułu buforującego odpowiedzi programu.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#include "writer.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Rozmiar bufora na zapisywane dane.
+ */
+#define WRITE_BUFFER_SIZE (1 << 16)
+
+/**
+ * Największa liczba cyfr liczby w formacie muint.
+ */
+#define MAX_NUMBER_LEN 20
+
+/** @brief Przygotowuje strukturę do zapisywania danych.
+ * @param[out] out   – wskaźnik na inicjowaną strukturę,
+ * @param[in] fd     – deskryptor pliku, do którego będą zapisywane dane,
+ * @param[in] policy – sposób opróżniania bufora.
+ * @return Wartość @p true, jeśli udało się zaalokować bufor,
+ * a @p false w przeciwnym razie.
+ */
+bool writer_init(writer *out, int fd, flush_policy policy)
+{
+    out->fd = fd;
+    out->mem = WRITE_BUFFER_SIZE;
+    out->len = 0;
+    out->policy = policy;
+    out->mark = 0;
+    out->lock = NULL;
+    out->before_write = NULL;
+    out->before_write_arg = NULL;
+    out->buffer = malloc(out->mem * sizeof(char));
+    return out->buffer != NULL;
+}
+
+/** @brief Zapisuje do pliku ciąg znaków.
+ * Powtarza wywołanie @ref write aż do zapisania wszystkich znaków.
+ * Funkcja pomocnicza w @ref write_locked.
+ * @param[in] fd   – deskryptor pliku,
+ * @param[in] data – wskaźnik na zapisywane znaki,
+ * @param[in] len  – liczba zapisywanych znaków.
+ * @return Wartość @p true, jeśli wszystkie znaki zostały zapisane,
+ * a @p false, jeśli wystąpił błąd zapisu.
+ */
+static bool write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t done = write(fd, data, len);
+        if (done == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += done;
+        len -= done;
+    }
+    return true;
+}
+
+/** @brief Wywołuje funkcję @p before_write, jeśli została ustawiona.
+ * Funkcja pomocnicza w @ref writer_flush, @ref reserve_shared
+ * i @ref writer_put_bytes.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane.
+ * @return Wartość @p true, jeśli dane można zapisać, a @p false, jeśli
+ * funkcja @p before_write zakończyła się błędem.
+ */
+static bool before_write(writer *out)
+{
+    return out->before_write == NULL || out->before_write(out->before_write_arg);
+}
+
+/** @brief Zapisuje do pliku ciąg znaków, trzymając blokadę pliku.
+ * Funkcja pomocnicza w @ref writer_flush, @ref reserve_shared
+ * i @ref writer_put_bytes.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] data    – wskaźnik na zapisywane znaki,
+ * @param[in] len     – liczba zapisywanych znaków.
+ * @return Wartość @p true, jeśli wszystkie znaki zostały zapisane,
+ * a @p false, jeśli wystąpił błąd zapisu.
+ */
+static bool write_locked(writer *out, const char *data, size_t len)
+{
+    if (out->lock == NULL)
+        return write_all(out->fd, data, len);
+
+    pthread_mutex_lock(out->lock);
+    bool result = write_all(out->fd, data, len);
+    pthread_mutex_unlock(out->lock);
+    return result;
+}
+
+/** @brief Zapisuje całą zawartość bufora do pliku.
+ * Jeśli funkcja @p before_write zakończy się błędem, dane zostają w buforze.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane.
+ * @return Wartość @p true, jeśli wszystkie dane zostały zapisane,
+ * a @p false, jeśli wystąpił błąd zapisu lub funkcji @p before_write.
+ */
+bool writer_flush(writer *out)
+{
+    if (before_write(out) == false)
+        return false;
+
+    bool result = write_locked(out, out->buffer, out->len);
+    out->len = 0;
+    out->mark = 0;
+    return result;
+}
+
+/** @brief Pozwala zapisywać do tego samego pliku z wielu wątków.
+ * Każdy wątek ma własną strukturę, a wszystkie struktury zapisujące do tego
+ * pliku dzielą blokadę @p lock. Bufor jest wtedy opróżniany tylko na granicy
+ * odpowiedzi, a odpowiedź większa od bufora powiększa go zamiast być
+ * zapisywana w częściach, więc odpowiedzi różnych wątków się nie przeplatają.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] lock    – wskaźnik na blokadę pliku.
+ */
+void writer_share(writer *out, pthread_mutex_t *lock)
+{
+    out->lock = lock;
+}
+
+/** @brief Ustawia funkcję wywoływaną przed każdym zapisem do pliku.
+ * Jeśli funkcja zwróci @p false, dane nie są zapisywane i zostają w buforze,
+ * a @ref writer_flush zwraca @p false. Pozwala np. utrwalić dziennik ruchów, zanim odpowiedzi na te
+ * ruchy trafią do pliku.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] hook    – wywoływana funkcja lub NULL,
+ * @param[in] arg     – argument przekazywany do funkcji @p hook.
+ */
+void writer_before_write(writer *out, bool (*hook)(void *), void *arg)
+{
+    out->before_write = hook;
+    out->before_write_arg = arg;
+}
+
+/** @brief Powiększa bufor tak, by zmieściły się w nim kolejne znaki.
+ * Gdy nie uda się zaalokować pamięci, opróżnia cały bufor, a jeśli i to się
+ * nie uda, porzuca jego zawartość, bo nie ma już gdzie jej przechować.
+ * Funkcja pomocnicza w @ref reserve_shared i @ref reserve.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] extra   – liczba znaków, które mają się jeszcze zmieścić.
+ */
+static void grow(writer *out, size_t extra)
+{
+    size_t mem = 2 * out->mem;
+    if (mem < out->len + extra)
+        mem = out->len + extra;
+    char *buffer = realloc(out->buffer, mem * sizeof(char));
+    if (buffer == NULL)
+    {
+        if (writer_flush(out) == false)
+        {
+            out->len = 0;
+            out->mark = 0;
+        }
+        return;
+    }
+    out->buffer = buffer;
+    out->mem = mem;
+}
+
+/** @brief Zapewnia miejsce we współdzielonym buforze na kolejne znaki.
+ * Zapisuje zakończone odpowiedzi, a jeśli to nie wystarczy, powiększa bufor.
+ * Funkcja pomocnicza w @ref reserve.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] extra   – liczba znaków, które mają się jeszcze zmieścić.
+ */
+static void reserve_shared(writer *out, size_t extra)
+{
+    if (out->mark > 0 && before_write(out))
+    {
+        write_locked(out, out->buffer, out->mark);
+        writer_drain(out, out->mark);
+    }
+    if (out->mem < out->len + extra)
+        grow(out, extra);
+}
+
+/** @brief Zapewnia miejsce w buforze na kolejne znaki.
+ * Jeśli to konieczne, opróżnia lub powiększa bufor.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] extra   – liczba znaków, które mają się jeszcze zmieścić.
+ */
+static inline void reserve(writer *out, size_t extra)
+{
+    if (out->mem < out->len + extra)
+    {
+        if (out->lock != NULL)
+            reserve_shared(out, extra);
+        else if (out->policy == FLUSH_MANUAL)
+            grow(out, extra);
+        else if (writer_flush(out) == false && out->len > 0)
+            grow(out, extra);
+    }
+}
+
+/** @brief Usuwa z początku bufora zapisane już znaki.
+ * Wykorzystywana przy sposobie opróżniania @ref FLUSH_MANUAL, gdy wywołujący
+ * sam przekazał część bufora do pliku.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] n       – liczba zapisanych znaków.
+ */
+void writer_drain(writer *out, size_t n)
+{
+    memmove(out->buffer, out->buffer + n, out->len - n);
+    out->len -= n;
+    out->mark = out->mark < n ? 0 : out->mark - n;
+}
+
+/** @brief Dopisuje znak do bufora.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] c       – dopisywany znak.
+ */
+void writer_put_char(writer *out, char c)
+{
+    reserve(out, 1);
+    out->buffer[out->len++] = c;
+}
+
+/** @brief Dopisuje napis do bufora.
+ * Napisy dłuższe od bufora są zapisywane bezpośrednio do pliku.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] s       – dopisywany napis zakończony znakiem @p '\0'.
+ */
+void writer_put_string(writer *out, const char *s)
+{
+    writer_put_bytes(out, s, strlen(s));
+}
+
+/** @brief Dopisuje ciąg bajtów do bufora.
+ * Ciągi dłuższe od bufora są zapisywane bezpośrednio do pliku.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] data    – wskaźnik na dopisywane bajty,
+ * @param[in] len     – liczba dopisywanych bajtów.
+ */
+void writer_put_bytes(writer *out, const void *data, size_t len)
+{
+    reserve(out, len);
+    if (out->mem < out->len + len)
+    {
+        if (before_write(out))
+        {
+            write_locked(out, data, len);
+            return;
+        }
+        grow(out, len);
+        if (out->mem < out->len + len)
+            return;
+    }
+    memcpy(out->buffer + out->len, data, len);
+    out->len += len;
+}
+
+/** @brief Dopisuje liczbę w zapisie dziesiętnym do bufora.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] n       – dopisywana liczba.
+ */
+void writer_put_number(writer *out, muint n)
+{
+    char reversed[MAX_NUMBER_LEN];
+    size_t len = 0;
+    do
+    {
+        reversed[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n != 0);
+
+    reserve(out, len);
+    while (len > 0)
+        out->buffer[out->len++] = reversed[--len];
+}
+
+/** @brief Kończy odpowiedź na jedno polecenie.
+ * W zależności od sposobu opróżniania bufora zapisuje jego zawartość.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane.
+ */
+void writer_end(writer *out)
+{
+    out->mark = out->len;
+    if (out->policy == FLUSH_LINE)
+        writer_flush(out);
+}
+
+/** @brief Zapisuje zawartość bufora i zwalnia zajmowaną pamięć.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane.
+ */
+void writer_free(writer *out)
+{
+    if (out->buffer != NULL)
+        writer_flush(out);
+    free(out->buffer);
+    out->buffer = NULL;
+}
@@ -0,0 +1,129 @@
+/** @file
+ * Interfejs modułu buforującego odpowiedzi programu.
+ *
+ * @author Grzegorz Bogusław Zaleski (418494)
+ * @copyright Uniwersytet Warszawski
+ * @date 15 maja 2020
+ */
+
+#ifndef GAMMA_WRITER_H
+#define GAMMA_WRITER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "gamma.h"
+
+/** @brief Sposób opróżniania bufora z odpowiedziami.
+ */
+typedef enum flush_policy
+{
+    FLUSH_LINE, ///< Opróżnianie po każdej odpowiedzi, np. dla terminala.
+    FLUSH_SIZE, ///< Opróżnianie dopiero po zapełnieniu bufora, np. dla pliku.
+    FLUSH_MANUAL, /**< Bufor jest powiększany w miarę potrzeby, a jego
+        zawartość zapisuje wywołujący, np. dla nieblokującego gniazda. */
+} flush_policy;
+
+/** @brief Struktura buforująca dane wypisywane przez program.
+ * Zawartość bufora jest przekazywana do pliku jednym wywołaniem
+ * funkcji @ref write.
+ */
+typedef struct writer
+{
+    int fd; ///< Deskryptor pliku, do którego zapisywane są dane.
+    char *buffer; ///< Bufor na dane oczekujące na zapisanie.
+    size_t mem; ///< Rozmiar zaalokowanego bufora.
+    size_t len; ///< Liczba znaków w buforze.
+    flush_policy policy; ///< Sposób opróżniania bufora.
+    size_t mark; ///< Liczba znaków należących do zakończonych odpowiedzi.
+    pthread_mutex_t *lock; /**< Blokada pliku współdzielonego z innymi
+        wątkami lub NULL, jeśli plik nie jest współdzielony. */
+    bool (*before_write)(void *); /**< Funkcja wywoływana przed każdym
+        zapisem do pliku lub NULL. */
+    void *before_write_arg; ///< Argument funkcji @p before_write.
+} writer;
+
+/** @brief Przygotowuje strukturę do zapisywania danych.
+ * @param[out] out   – wskaźnik na inicjowaną strukturę,
+ * @param[in] fd     – deskryptor pliku, do którego będą zapisywane dane,
+ * @param[in] policy – sposób opróżniania bufora.
+ * @return Wartość @p true, jeśli udało się zaalokować bufor,
+ * a @p false w przeciwnym razie.
+ */
+bool writer_init(writer *out, int fd, flush_policy policy);
+
+/** @brief Pozwala zapisywać do tego samego pliku z wielu wątków.
+ * Każdy wątek ma własną strukturę, a wszystkie struktury zapisujące do tego
+ * pliku dzielą blokadę @p lock. Bufor jest wtedy opróżniany tylko na granicy
+ * odpowiedzi, a odpowiedź większa od bufora powiększa go zamiast być
+ * zapisywana w częściach, więc odpowiedzi różnych wątków się nie przeplatają.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] lock    – wskaźnik na blokadę pliku.
+ */
+void writer_share(writer *out, pthread_mutex_t *lock);
+
+/** @brief Ustawia funkcję wywoływaną przed każdym zapisem do pliku.
+ * Jeśli funkcja zwróci @p false, dane nie są zapisywane i zostają w buforze,
+ * a @ref writer_flush zwraca @p false. Pozwala np. utrwalić dziennik ruchów, zanim odpowiedzi na te
+ * ruchy trafią do pliku.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] hook    – wywoływana funkcja lub NULL,
+ * @param[in] arg     – argument przekazywany do funkcji @p hook.
+ */
+void writer_before_write(writer *out, bool (*hook)(void *), void *arg);
+
+/** @brief Dopisuje znak do bufora.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] c       – dopisywany znak.
+ */
+void writer_put_char(writer *out, char c);
+
+/** @brief Dopisuje napis do bufora.
+ * Napisy dłuższe od bufora są zapisywane bezpośrednio do pliku.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] s       – dopisywany napis zakończony znakiem @p '\0'.
+ */
+void writer_put_string(writer *out, const char *s);
+
+/** @brief Dopisuje ciąg bajtów do bufora.
+ * Ciągi dłuższe od bufora są zapisywane bezpośrednio do pliku.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] data    – wskaźnik na dopisywane bajty,
+ * @param[in] len     – liczba dopisywanych bajtów.
+ */
+void writer_put_bytes(writer *out, const void *data, size_t len);
+
+/** @brief Dopisuje liczbę w zapisie dziesiętnym do bufora.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] n       – dopisywana liczba.
+ */
+void writer_put_number(writer *out, muint n);
+
+/** @brief Kończy odpowiedź na jedno polecenie.
+ * W zależności od sposobu opróżniania bufora zapisuje jego zawartość.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane.
+ */
+void writer_end(writer *out);
+
+/** @brief Zapisuje całą zawartość bufora do pliku.
+ * Jeśli funkcja @p before_write zakończy się błędem, dane zostają w buforze.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane.
+ * @return Wartość @p true, jeśli wszystkie dane zostały zapisane,
+ * a @p false, jeśli wystąpił błąd zapisu lub funkcji @p before_write.
+ */
+bool writer_flush(writer *out);
+
+/** @brief Usuwa z początku bufora zapisane już znaki.
+ * Wykorzystywana przy sposobie opróżniania @ref FLUSH_MANUAL, gdy wywołujący
+ * sam przekazał część bufora do pliku.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane,
+ * @param[in] n       – liczba zapisanych znaków.
+ */
+void writer_drain(writer *out, size_t n);
+
+/** @brief Zapisuje zawartość bufora i zwalnia zajmowaną pamięć.
+ * @param[in,out] out – wskaźnik na strukturę zapisującą dane.
+ */
+void writer_free(writer *out);
+
+#endif //GAMMA_WRITER_H